@@ -14,7 +14,9 @@ cp -r includes/* build/
 cp -r resources/* build/
 
 # Build with g++
-g++ build/frontend.cpp -o galaxy_visualization_raylib -lraylib
+g++ -std=c++20 build/frontend.cpp -o galaxy_visualization_raylib -lraylib -pthread -ldl
+g++ -std=c++20 -O2 build/generate_catalog.cpp -o generate_catalog -pthread
+g++ -std=c++20 -O2 build/catalog_tests.cpp -o catalog_tests -pthread
 
 # Run the executable
 ./galaxy_visualization_raylib
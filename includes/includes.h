@@ -7,6 +7,12 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 // If Linux
 #ifdef __linux__
@@ -16,7 +22,7 @@
 
 // If Windows
 #ifdef _WIN32
-// Nothing to include
+#include <malloc.h>
 #endif
 
 // Program specific stuff --------------------------------------
@@ -54,3 +60,36 @@ typedef double f64;
 #define Kilobytes(Value) ((Value) * 1024LL)
 #define Megabytes(Value) (Kilobytes(Value) * 1024LL)
 #define Gigabytes(Value) (Megabytes(Value) * 1024LL)
+
+// Timing ------------------------
+// @Note(Victor): Monotonic wall clock that works before and without a window (raylib's GetTime needs InitWindow)
+internal f64
+GetWallClockSeconds(void)
+{
+    using namespace std::chrono;
+    return duration<f64>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Memory ------------------------
+// @Note(Victor): The SIMD kernels want cache line aligned columns
+internal void *
+AlignedAlloc(usize Alignment, usize Size)
+{
+    // aligned_alloc wants the size to be a multiple of the alignment
+    Size = (Size + Alignment - 1) & ~(Alignment - 1);
+#ifdef _WIN32
+    return _aligned_malloc(Size, Alignment);
+#else
+    return aligned_alloc(Alignment, Size);
+#endif
+}
+
+internal void
+AlignedFree(void *Memory)
+{
+#ifdef _WIN32
+    _aligned_free(Memory);
+#else
+    free(Memory);
+#endif
+}
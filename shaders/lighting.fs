@@ -1,8 +1,18 @@
 #version 330
 
+// SHADING_TIER is defined by LoadTieredShader, see shading.cpp
+#define     SHADING_PHONG           0
+#define     SHADING_LAMBERT         1
+#define     SHADING_UNLIT           2
+
+#ifndef SHADING_TIER
+#define SHADING_TIER SHADING_PHONG
+#endif
+
 // Input vertex attributes (from vertex shader)
 in vec3 fragPosition;
 in vec2 fragTexCoord;
+in vec4 fragColor;
 in vec3 fragNormal;
 
 // Input uniform values
@@ -31,10 +41,30 @@ uniform Light lights[MAX_LIGHTS];
 uniform vec4 ambient;
 uniform vec3 viewPos;
 
+// All the lights summed into one quadratic form of vec4(normal, 1), see GetLightSum
+uniform mat4 lightSum;
+
 void main()
 {
+#if SHADING_TIER == SHADING_UNLIT
+    finalColor = colDiffuse*fragColor;
+#elif SHADING_TIER == SHADING_LAMBERT
+    vec4 texelColor = texture(texture0, fragTexCoord);
+    vec4 diffuseColor = colDiffuse*fragColor;
+
+    vec4 normal = vec4(normalize(fragNormal), 1.0);
+    float lightDot = max(dot(normal, lightSum*normal), 0.0);
+
+    finalColor = texelColor*diffuseColor*(vec4(vec3(lightDot), 1.0) + ambient/2.0);
+
+    // Close enough to the 1/2.2 gamma, without the pow
+    finalColor = sqrt(finalColor);
+#else
     // Fetch texel color from the diffuse texture
     vec4 texelColor = texture(texture0, fragTexCoord);
+
+    // The material color tinted by the color of the instance
+    vec4 diffuseColor = colDiffuse*fragColor;
     
     // Fetch specular map value
     vec3 specularMapColor = texture(specularMap, fragTexCoord).rgb;
@@ -76,11 +106,12 @@ void main()
     }
 
     // Combine the texel color with lighting and specular
-    finalColor = (texelColor * (colDiffuse + vec4(specular, 1.0)) * vec4(lightDot, 1.0));
+    finalColor = (texelColor * (diffuseColor + vec4(specular, 1.0)) * vec4(lightDot, 1.0));
     
     // Add ambient lighting
-    finalColor += texelColor * (ambient / 2.0) * colDiffuse;
+    finalColor += texelColor * (ambient / 2.0) * diffuseColor;
 
     // Gamma correction
     finalColor = pow(finalColor, vec4(1.0 / 2.2));
+#endif
 }
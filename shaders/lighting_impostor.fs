@@ -0,0 +1,131 @@
+#version 330
+
+// SHADING_TIER is defined by LoadTieredShader, see shading.cpp
+#define     SHADING_PHONG           0
+#define     SHADING_LAMBERT         1
+#define     SHADING_UNLIT           2
+
+#ifndef SHADING_TIER
+#define SHADING_TIER SHADING_PHONG
+#endif
+
+// Input vertex attributes (from vertex shader)
+in vec3 fragPosition;
+in vec2 fragTexCoord;
+in vec4 fragColor;
+
+// Input uniform values
+uniform sampler2D texture0;     // Diffuse texture
+uniform sampler2D specularMap;  // Specular map
+uniform vec4 colDiffuse;
+uniform float shininess;        // Shininess (exponent for specular reflection)
+uniform mat4 matView;
+
+// Output fragment color
+out vec4 finalColor;
+
+#define     MAX_LIGHTS              8
+#define     LIGHT_DIRECTIONAL       0
+#define     LIGHT_POINT             1
+
+#define     PI                      3.14159265358979
+
+struct Light {
+    int enabled;
+    int type;
+    vec3 position;
+    vec3 target;
+    vec4 color;
+};
+
+// Input lighting values
+uniform Light lights[MAX_LIGHTS];
+uniform vec4 ambient;
+uniform vec3 viewPos;
+
+// All the lights summed into one quadratic form of vec4(normal, 1), see GetLightSum
+uniform mat4 lightSum;
+
+void main()
+{
+    // The quad is the square around the sphere, the corners are not part of it
+    vec2 corner = fragTexCoord*2.0 - 1.0;
+    float distanceSquared = dot(corner, corner);
+    if (distanceSquared > 1.0) discard;
+
+#if SHADING_TIER == SHADING_UNLIT
+    finalColor = colDiffuse*fragColor;
+#else
+    // Normal of the sphere under this pixel, facing the camera
+    vec3 cameraRight = vec3(matView[0][0], matView[1][0], matView[2][0]);
+    vec3 cameraUp = vec3(matView[0][1], matView[1][1], matView[2][1]);
+    vec3 cameraBack = vec3(matView[0][2], matView[1][2], matView[2][2]);
+    vec3 normal = normalize(cameraRight*corner.x + cameraUp*corner.y + cameraBack*sqrt(1.0 - distanceSquared));
+
+    // Texture coordinates of the sphere at that normal, like GenMeshSphere
+    vec2 sphereTexCoord = vec2(0.5 + atan(normal.z, normal.x)/(2.0*PI), acos(clamp(normal.y, -1.0, 1.0))/PI);
+
+    // From here on the same as lighting.fs
+#if SHADING_TIER == SHADING_LAMBERT
+    vec4 texelColor = texture(texture0, sphereTexCoord);
+    vec4 diffuseColor = colDiffuse*fragColor;
+
+    float lightDot = max(dot(vec4(normal, 1.0), lightSum*vec4(normal, 1.0)), 0.0);
+
+    finalColor = texelColor*diffuseColor*(vec4(vec3(lightDot), 1.0) + ambient/2.0);
+
+    // Close enough to the 1/2.2 gamma, without the pow
+    finalColor = sqrt(finalColor);
+#else
+    vec4 texelColor = texture(texture0, sphereTexCoord);
+    vec3 specularMapColor = texture(specularMap, sphereTexCoord).rgb;
+
+    // The material color tinted by the color of the instance
+    vec4 diffuseColor = colDiffuse*fragColor;
+
+    // Lighting and specular setup
+    vec3 lightDot = vec3(0.0);
+    vec3 viewD = normalize(viewPos - fragPosition);
+    vec3 specular = vec3(0.0);
+
+    for (int i = 0; i < MAX_LIGHTS; i++)
+    {
+        if (lights[i].enabled == 1)
+        {
+            vec3 lightDir = vec3(0.0);
+
+            if (lights[i].type == LIGHT_DIRECTIONAL)
+            {
+                lightDir = -normalize(lights[i].target - lights[i].position);
+            }
+
+            if (lights[i].type == LIGHT_POINT)
+            {
+                lightDir = normalize(lights[i].position - fragPosition);
+            }
+
+            // Diffuse lighting
+            float NdotL = max(dot(normal, lightDir), 0.0);
+            lightDot += lights[i].color.rgb * NdotL;
+
+            // Specular reflection
+            if (NdotL > 0.0)
+            {
+                vec3 reflectDir = reflect(-lightDir, normal);
+                float specCo = pow(max(dot(viewD, reflectDir), 0.0), shininess);
+                specular += specCo * specularMapColor;
+            }
+        }
+    }
+
+    // Combine the texel color with lighting and specular
+    finalColor = (texelColor * (diffuseColor + vec4(specular, 1.0)) * vec4(lightDot, 1.0));
+
+    // Add ambient lighting
+    finalColor += texelColor * (ambient / 2.0) * diffuseColor;
+
+    // Gamma correction
+    finalColor = pow(finalColor, vec4(1.0 / 2.2));
+#endif
+#endif
+}
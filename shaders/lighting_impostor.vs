@@ -0,0 +1,58 @@
+#version 330
+
+// Input vertex attributes (a quad in the xy plane, see GenMeshImpostorQuad)
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+
+// Input instance attributes (16 bytes per instance, see SkyInstance): RA and Dec in radians, cz in km/s, catalog id
+in vec4 instanceSky;
+
+// Slots of the per catalog uniforms, INSTANCE_CATALOG_MAX_COUNT in instancing.cpp
+#define MAX_CATALOGS 16
+
+// Input uniform values
+uniform mat4 mvp;
+uniform mat4 matView;
+uniform float catalogScale[MAX_CATALOGS];
+uniform vec4 catalogColor[MAX_CATALOGS];
+
+// Input projection values, see InstanceUniforms
+uniform float sphereRadius;
+uniform float catalogDistanceScale[MAX_CATALOGS];
+uniform float catalogRedshiftBlend[MAX_CATALOGS];
+
+// Output vertex attributes (to fragment shader)
+out vec3 fragPosition;
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+// Where the galaxy is: on the sky sphere, at its redshift distance or in between
+vec3 projectInstance(vec4 sky, int catalog)
+{
+    float cosDec = cos(sky.y);
+    vec3 direction = vec3(cos(sky.x)*cosDec, sin(sky.y), sin(sky.x)*cosDec);
+
+    return direction*mix(sphereRadius, max(sky.z, 0.0)*catalogDistanceScale[catalog], catalogRedshiftBlend[catalog]);
+}
+
+void main()
+{
+    int catalog = int(instanceSky.w);
+    vec3 instancePosition = projectInstance(instanceSky, catalog);
+    float instanceScale = catalogScale[catalog];
+
+    // Turn the quad towards the camera, the rows of the view matrix are the camera axes
+    vec3 cameraRight = vec3(matView[0][0], matView[1][0], matView[2][0]);
+    vec3 cameraUp = vec3(matView[0][1], matView[1][1], matView[2][1]);
+
+    vec3 corner = (cameraRight*vertexPosition.x + cameraUp*vertexPosition.y)*instanceScale;
+    vec4 worldPosition = vec4(instancePosition + corner, 1.0);
+
+    // Send vertex attributes to fragment shader
+    fragPosition = vec3(mvp*worldPosition);
+    fragTexCoord = vertexTexCoord;
+    fragColor = catalogColor[catalog];
+
+    // Calculate final vertex position
+    gl_Position = mvp*worldPosition;
+}
\ No newline at end of file
@@ -5,11 +5,22 @@ in vec3 vertexPosition;
 in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 
-in mat4 instanceTransform;
+// Input instance attributes (16 bytes per instance, see SkyInstance): RA and Dec in radians, cz in km/s, catalog id
+in vec4 instanceSky;
+
+// Slots of the per catalog uniforms, INSTANCE_CATALOG_MAX_COUNT in instancing.cpp
+#define MAX_CATALOGS 16
 
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matNormal;
+uniform float catalogScale[MAX_CATALOGS];
+uniform vec4 catalogColor[MAX_CATALOGS];
+
+// Input projection values, see InstanceUniforms
+uniform float sphereRadius;
+uniform float catalogDistanceScale[MAX_CATALOGS];
+uniform float catalogRedshiftBlend[MAX_CATALOGS];
 
 // Output vertex attributes (to fragment shader)
 out vec3 fragPosition;
@@ -17,16 +28,30 @@ out vec2 fragTexCoord;
 out vec4 fragColor;
 out vec3 fragNormal;
 
+// Where the galaxy is: on the sky sphere, at its redshift distance or in between
+vec3 projectInstance(vec4 sky, int catalog)
+{
+    float cosDec = cos(sky.y);
+    vec3 direction = vec3(cos(sky.x)*cosDec, sin(sky.y), sin(sky.x)*cosDec);
+
+    return direction*mix(sphereRadius, max(sky.z, 0.0)*catalogDistanceScale[catalog], catalogRedshiftBlend[catalog]);
+}
+
 void main()
 {
-    // Compute MVP for current instance
-    mat4 mvpi = mvp*instanceTransform;
+    int catalog = int(instanceSky.w);
+    vec3 instancePosition = projectInstance(instanceSky, catalog);
+    float instanceScale = catalogScale[catalog];
+
+    // Rebuild the instance transform: uniform scale, then translation
+    vec4 worldPosition = vec4(vertexPosition*instanceScale + instancePosition, 1.0);
 
     // Send vertex attributes to fragment shader
-    fragPosition = vec3(mvpi*vec4(vertexPosition, 1.0));
+    fragPosition = vec3(mvp*worldPosition);
     fragTexCoord = vertexTexCoord;
+    fragColor = catalogColor[catalog];
     fragNormal = normalize(vec3(matNormal*vec4(vertexNormal, 1.0)));
 
     // Calculate final vertex position
-    gl_Position = mvpi*vec4(vertexPosition, 1.0);
+    gl_Position = mvp*worldPosition;
 }
\ No newline at end of file
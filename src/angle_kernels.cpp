@@ -0,0 +1,195 @@
+// Angle kernels -----------------------------------------------------------------
+// @Note(Victor): The float angles the instance builder works in. A Cephes sincos (sinf/cosf polynomials,
+// like sse_mathfun) and the conversions of the catalog units to radians, each once in scalar and once
+// 8 at a time in AVX2. The two do the exact same float operations in the same order, so they give bit
+// identical results and the tail of a block can use either. The sincos is within a couple of float
+// ulps of cosf/sinf.
+//
+// No raylib in here, so the tests can check the two paths against each other.
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ANGLE_KERNELS_HAS_AVX2 1
+#else
+#define ANGLE_KERNELS_HAS_AVX2 0
+#endif
+
+const f64 FIXED_ARCMIN_TO_RADIANS = (CATALOG_FIXED_STEP / 60.0) * PIdividedBy180;
+
+// Cephes sinf/cosf: reduction by pi/4 in three parts, then a polynomial on [-pi/4, pi/4]
+const f32 SINCOS_FOUR_OVER_PI = 1.27323954473516f;
+const f32 SINCOS_PI_OVER_FOUR_1 = 0.78515625f;
+const f32 SINCOS_PI_OVER_FOUR_2 = 2.4187564849853515625e-4f;
+const f32 SINCOS_PI_OVER_FOUR_3 = 3.77489497744594108e-8f;
+const f32 SINCOS_SIN_0 = -1.9515295891e-4f;
+const f32 SINCOS_SIN_1 = 8.3321608736e-3f;
+const f32 SINCOS_SIN_2 = -1.6666654611e-1f;
+const f32 SINCOS_COS_0 = 2.443315711809948e-5f;
+const f32 SINCOS_COS_1 = -1.388731625493765e-3f;
+const f32 SINCOS_COS_2 = 4.166664568298827e-2f;
+
+internal inline f32
+FlipSign(f32 Value, u32 SignBit)
+{
+    u32 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+    Bits ^= SignBit;
+    memcpy(&Value, &Bits, sizeof(Bits));
+
+    return Value;
+}
+
+internal inline void
+SinCos(f32 Angle, f32 *Sin, f32 *Cos)
+{
+    u32 AngleBits;
+    memcpy(&AngleBits, &Angle, sizeof(AngleBits));
+    u32 SinSign = AngleBits & 0x80000000;
+    f32 X = fabsf(Angle);
+
+    // Octant, rounded up to even
+    i32 Octant = (i32)(X * SINCOS_FOUR_OVER_PI);
+    Octant = (Octant + 1) & ~1;
+    f32 Y = (f32)Octant;
+
+    SinSign ^= (u32)(Octant & 4) << 29;
+    u32 CosSign = (u32)(~(Octant - 2) & 4) << 29;
+    bool IsSwapped = (Octant & 2) != 0;
+
+    X = ((X - Y * SINCOS_PI_OVER_FOUR_1) - Y * SINCOS_PI_OVER_FOUR_2) - Y * SINCOS_PI_OVER_FOUR_3;
+    f32 Z = X * X;
+
+    f32 CosPolynomial = (((SINCOS_COS_0 * Z + SINCOS_COS_1) * Z + SINCOS_COS_2) * Z) * Z - Z * 0.5f + 1.0f;
+    f32 SinPolynomial = (((SINCOS_SIN_0 * Z + SINCOS_SIN_1) * Z + SINCOS_SIN_2) * Z) * X + X;
+
+    *Sin = FlipSign(IsSwapped ? CosPolynomial : SinPolynomial, SinSign);
+    *Cos = FlipSign(IsSwapped ? SinPolynomial : CosPolynomial, CosSign);
+}
+
+internal inline f32
+ArcminToRadians(f64 Arcmin)
+{
+    // @Note(Victor): Same expression as the old per galaxy loop, in doubles, then rounded once
+    return (f32)((Arcmin / 60.0) * PIdividedBy180);
+}
+
+// Fixed point arc minutes of a compact catalog
+internal inline f32
+ArcminToRadians(i32 Steps)
+{
+    return (f32)((f64)Steps * FIXED_ARCMIN_TO_RADIANS);
+}
+
+// @Note(Victor): HHMMSS.s with DegreesPerUnit 15 (an hour of RA is 15 degrees), +-DDMMSS with 1
+internal inline f32
+SexagesimalToRadians(f64 Value, f64 DegreesPerUnit)
+{
+    f64 Magnitude = fabs(Value);
+    f64 Units = floor(Magnitude / 10000.0);
+    f64 Rest = Magnitude - Units * 10000.0;
+    f64 Minutes = floor(Rest / 100.0);
+    f64 Seconds = Rest - Minutes * 100.0;
+
+    f64 Degrees = DegreesPerUnit * ((Units + Minutes / 60.0) + Seconds / 3600.0);
+    return (f32)(copysign(Degrees, Value) * PIdividedBy180);
+}
+
+#if ANGLE_KERNELS_HAS_AVX2
+__attribute__((target("avx2"))) internal inline void
+SinCos8(__m256 Angle, __m256 *Sin, __m256 *Cos)
+{
+    const __m256 SignMask = _mm256_castsi256_ps(_mm256_set1_epi32((i32)0x80000000));
+
+    __m256 SinSign = _mm256_and_ps(Angle, SignMask);
+    __m256 X = _mm256_andnot_ps(SignMask, Angle);
+
+    __m256i Octant = _mm256_cvttps_epi32(_mm256_mul_ps(X, _mm256_set1_ps(SINCOS_FOUR_OVER_PI)));
+    Octant = _mm256_and_si256(_mm256_add_epi32(Octant, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    __m256 Y = _mm256_cvtepi32_ps(Octant);
+
+    SinSign = _mm256_xor_ps(SinSign, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(Octant, _mm256_set1_epi32(4)), 29)));
+    __m256 CosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(Octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    __m256 IsSwapped = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(Octant, _mm256_set1_epi32(2)), _mm256_set1_epi32(2)));
+
+    // @Note(Victor): No FMA, this has to round like the scalar SinCos
+    X = _mm256_sub_ps(X, _mm256_mul_ps(Y, _mm256_set1_ps(SINCOS_PI_OVER_FOUR_1)));
+    X = _mm256_sub_ps(X, _mm256_mul_ps(Y, _mm256_set1_ps(SINCOS_PI_OVER_FOUR_2)));
+    X = _mm256_sub_ps(X, _mm256_mul_ps(Y, _mm256_set1_ps(SINCOS_PI_OVER_FOUR_3)));
+    __m256 Z = _mm256_mul_ps(X, X);
+
+    __m256 CosPolynomial = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_COS_0), Z), _mm256_set1_ps(SINCOS_COS_1));
+    CosPolynomial = _mm256_add_ps(_mm256_mul_ps(CosPolynomial, Z), _mm256_set1_ps(SINCOS_COS_2));
+    CosPolynomial = _mm256_mul_ps(_mm256_mul_ps(CosPolynomial, Z), Z);
+    CosPolynomial = _mm256_sub_ps(CosPolynomial, _mm256_mul_ps(Z, _mm256_set1_ps(0.5f)));
+    CosPolynomial = _mm256_add_ps(CosPolynomial, _mm256_set1_ps(1.0f));
+
+    __m256 SinPolynomial = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_SIN_0), Z), _mm256_set1_ps(SINCOS_SIN_1));
+    SinPolynomial = _mm256_add_ps(_mm256_mul_ps(SinPolynomial, Z), _mm256_set1_ps(SINCOS_SIN_2));
+    SinPolynomial = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(SinPolynomial, Z), X), X);
+
+    *Sin = _mm256_xor_ps(_mm256_blendv_ps(SinPolynomial, CosPolynomial, IsSwapped), SinSign);
+    *Cos = _mm256_xor_ps(_mm256_blendv_ps(CosPolynomial, SinPolynomial, IsSwapped), CosSign);
+}
+
+__attribute__((target("avx2"))) internal inline __m256
+ArcminToRadians8(const f64 *Arcmin)
+{
+    const __m256d Sixty = _mm256_set1_pd(60.0);
+    const __m256d ToRadians = _mm256_set1_pd(PIdividedBy180);
+
+    __m128 Low = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_div_pd(_mm256_loadu_pd(Arcmin), Sixty), ToRadians));
+    __m128 High = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_div_pd(_mm256_loadu_pd(Arcmin + 4), Sixty), ToRadians));
+
+    return _mm256_set_m128(High, Low);
+}
+
+// @Note(Victor): Exact widening to doubles, then the same multiply and rounding as the scalar ArcminToRadians
+__attribute__((target("avx2"))) internal inline __m256
+ArcminToRadians8(const i32 *Steps)
+{
+    const __m256d ToRadians = _mm256_set1_pd(FIXED_ARCMIN_TO_RADIANS);
+
+    __m256i Packed = _mm256_loadu_si256((const __m256i *)Steps);
+    __m128 Low = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(Packed)), ToRadians));
+    __m128 High = _mm256_cvtpd_ps(_mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(Packed, 1)), ToRadians));
+
+    return _mm256_set_m128(High, Low);
+}
+
+__attribute__((target("avx2"))) internal inline __m128
+SexagesimalToRadians4(const f64 *Value, f64 DegreesPerUnit)
+{
+    const __m256d SignMask = _mm256_set1_pd(-0.0);
+
+    __m256d Signed = _mm256_loadu_pd(Value);
+    __m256d Magnitude = _mm256_andnot_pd(SignMask, Signed);
+
+    __m256d Units = _mm256_floor_pd(_mm256_div_pd(Magnitude, _mm256_set1_pd(10000.0)));
+    __m256d Rest = _mm256_sub_pd(Magnitude, _mm256_mul_pd(Units, _mm256_set1_pd(10000.0)));
+    __m256d Minutes = _mm256_floor_pd(_mm256_div_pd(Rest, _mm256_set1_pd(100.0)));
+    __m256d Seconds = _mm256_sub_pd(Rest, _mm256_mul_pd(Minutes, _mm256_set1_pd(100.0)));
+
+    __m256d Degrees = _mm256_add_pd(Units, _mm256_div_pd(Minutes, _mm256_set1_pd(60.0)));
+    Degrees = _mm256_add_pd(Degrees, _mm256_div_pd(Seconds, _mm256_set1_pd(3600.0)));
+    Degrees = _mm256_mul_pd(_mm256_set1_pd(DegreesPerUnit), Degrees);
+    Degrees = _mm256_or_pd(Degrees, _mm256_and_pd(SignMask, Signed));
+
+    return _mm256_cvtpd_ps(_mm256_mul_pd(Degrees, _mm256_set1_pd(PIdividedBy180)));
+}
+
+__attribute__((target("avx2"))) internal inline __m256
+SexagesimalToRadians8(const f64 *Value, f64 DegreesPerUnit)
+{
+    return _mm256_set_m128(SexagesimalToRadians4(Value + 4, DegreesPerUnit), SexagesimalToRadians4(Value, DegreesPerUnit));
+}
+#endif
+
+internal bool
+UseAngleKernelsAVX2(void)
+{
+#if ANGLE_KERNELS_HAS_AVX2
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,578 @@
+// Headless benchmark ------------------------------------------------------------
+// @Note(Victor): `--bench` runs the load path without a window (none of it needs GL) and prints JSON on
+// stdout. The logs the loaders print go to stderr for the run, so stdout is only the JSON.
+//
+// For every arcmin catalog, every stage runs Repetitions times:
+//   read   the whole file into memory (I/O, or the page cache once it is warm)
+//   parse  ReadInputDataFromFile into a fresh catalog, never the .gcat cache
+//   build  the instances on the sphere
+//   index  the sky tiling of those instances
+//   density  binning the catalog into a sky density map and coloring it
+//   pick   one galaxy under a mouse ray through the sky tiling, per ray
+// and with --bench-correlation=N the angular correlation of the first N galaxies of the first two
+// catalogs. Every stage reports its median and p95 (nearest rank) in milliseconds.
+//
+// With GALAXY_COMPACT the catalogs are parsed into fixed point and the stages run on that. Either way
+// every catalog is also parsed in the other storage once and the two are compared: the arc minutes, the
+// angle between the positions, and the angle between the SkyInstances they build, against the f64 path.
+// --bench-correlation=100000,1000000,10000000 runs the correlation at each size for a scaling curve,
+// --bench-correlation-brute also times the brute force pair counting at each of them.
+
+#include <algorithm>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+const u32 BENCH_MAX_CATALOGS = 8;
+const u32 BENCH_MAX_REPETITIONS = 1000;
+const u32 BENCH_MAX_CORRELATION_SIZES = 16;
+
+// @Note(Victor): One pick sample is the average over this many rays. The tolerance is what 4 pixels are
+// in the middle of a 720 pixel high window with the 65 degree field of view of the camera.
+const u32 BENCH_PICK_RAYS = 1000;
+const f32 BENCH_PICK_TOLERANCE = 0.0071f;
+const f32 BENCH_GALAXY_RADIUS = 0.02f; // The galaxy mesh radius at the scale of the course catalogs
+
+struct BenchOptions
+{
+    const char *Files[BENCH_MAX_CATALOGS];
+    u32 FileCount;
+    u32 Repetitions;
+    u64 CorrelationSizes[BENCH_MAX_CORRELATION_SIZES];
+    u32 CorrelationSizeCount; // 0 is no correlation
+    bool CorrelationBruteForce;
+};
+
+struct BenchStage
+{
+    f64 Seconds[BENCH_MAX_REPETITIONS];
+    u32 Count;
+};
+
+struct BenchStats
+{
+    f64 Median;
+    f64 P95;
+    f64 Min;
+    f64 Max;
+};
+
+global_variable u64 BenchPeakTrackedMemory = 0;
+
+internal void
+NoteBenchMemory(void)
+{
+    u64 Memory = CPUMemory;
+    BenchPeakTrackedMemory = Memory > BenchPeakTrackedMemory ? Memory : BenchPeakTrackedMemory;
+}
+
+internal BenchStats
+GetBenchStats(const BenchStage *Stage)
+{
+    BenchStats Result = {};
+    if (Stage->Count == 0)
+    {
+        return Result;
+    }
+
+    f64 Sorted[BENCH_MAX_REPETITIONS];
+    memcpy(Sorted, Stage->Seconds, Stage->Count * sizeof(f64));
+    std::sort(Sorted, Sorted + Stage->Count);
+
+    u32 Count = Stage->Count;
+    Result.Median = Count % 2 ? Sorted[Count / 2] : 0.5 * (Sorted[Count / 2 - 1] + Sorted[Count / 2]);
+
+    u32 Rank = (u32)ceil(0.95 * Count);
+    Result.P95 = Sorted[Rank > 0 ? Rank - 1 : 0];
+    Result.Min = Sorted[0];
+    Result.Max = Sorted[Count - 1];
+
+    return Result;
+}
+
+// Bytes, as far as the platform can tell
+internal u64
+GetPeakResidentMemory(void)
+{
+#if defined(__linux__) || defined(__APPLE__)
+    struct rusage Usage;
+    if (getrusage(RUSAGE_SELF, &Usage) != 0)
+    {
+        return 0;
+    }
+
+#if defined(__APPLE__)
+    return (u64)Usage.ru_maxrss;
+#else
+    return (u64)Usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
+
+internal void
+PrintJsonString(FILE *Out, const char *String)
+{
+    fputc('"', Out);
+    for (const char *At = String; *At; ++At)
+    {
+        if (*At == '"' || *At == '\\')
+        {
+            fputc('\\', Out);
+            fputc(*At, Out);
+        }
+        else if ((u8)*At < 0x20)
+        {
+            fprintf(Out, "\\u%04x", (u8)*At);
+        }
+        else
+        {
+            fputc(*At, Out);
+        }
+    }
+    fputc('"', Out);
+}
+
+internal void
+PrintBenchStage(FILE *Out, const char *Name, const BenchStage *Stage, bool IsLast)
+{
+    BenchStats Stats = GetBenchStats(Stage);
+    fprintf(Out, "        \"%s\": {\"median_ms\": %.4f, \"p95_ms\": %.4f, \"min_ms\": %.4f, \"max_ms\": %.4f}%s\n",
+            Name, Stats.Median * 1000.0, Stats.P95 * 1000.0, Stats.Min * 1000.0, Stats.Max * 1000.0, IsLast ? "" : ",");
+}
+
+internal bool
+BenchReadFile(const char *FileName, BenchStage *Stage, u64 *FileSize)
+{
+    f64 StartTime = GetWallClockSeconds();
+
+    FILE *f = fopen(FileName, "rb");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    fseek(f, 0, SEEK_END);
+    u64 Size = (u64)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *Buffer = (char *)malloc(Size > 0 ? Size : 1);
+    CPUMemory += Size;
+    bool Success = fread(Buffer, 1, Size, f) == Size;
+    fclose(f);
+
+    Stage->Seconds[Stage->Count++] = GetWallClockSeconds() - StartTime;
+    NoteBenchMemory();
+
+    free(Buffer);
+    CPUMemory -= Size;
+
+    *FileSize = Size;
+    return (Success);
+}
+
+// How far the fixed point catalog is from the f64 one, in arc minutes and arc seconds
+struct BenchPrecision
+{
+    f64 MaxArcmin;
+    f64 MeanArcmin;
+    f64 MaxArcsec;
+    f64 MeanArcsec;
+    f64 MaxInstanceArcsec;
+    f64 IdenticalInstances; // Fraction of SkyInstances with the same RA and Dec floats
+};
+
+struct BenchCatalog
+{
+    const char *FileName;
+    u64 FileSize;
+    MemoryArena Memory;
+    Catalog Data;
+    BenchPrecision Precision;
+
+    BenchStage Read;
+    BenchStage Parse;
+    BenchStage Build;
+    BenchStage Index;
+    BenchStage Density;
+    BenchStage Pick;
+};
+
+// Leaves the catalog of the last repetition in Result->Data
+internal bool
+BenchCatalogStages(BenchCatalog *Result, u32 Repetitions)
+{
+    u64 Count = 0;
+    if (!ReadCatalogDeclaredCount(Result->FileName, &Count))
+    {
+        printf("\tCould not read the count of %s\n", Result->FileName);
+        return (false);
+    }
+
+    for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        if (!BenchReadFile(Result->FileName, &Result->Read, &Result->FileSize))
+        {
+            printf("\tCould not read %s\n", Result->FileName);
+            return (false);
+        }
+    }
+
+    for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        // @Note(Victor): Every repetition parses into the pages of the last one, like a reload
+        FreeCatalog(&Result->Data);
+        ResetArena(&Result->Memory);
+        bool Allocated = CompactCatalogs ? AllocateCompactCatalog(&Result->Data, &Result->Memory, Count)
+                                         : AllocateCatalog(&Result->Data, &Result->Memory, Count, false);
+        if (!Allocated)
+        {
+            printf("\tNo memory for the %lu data points of %s\n", (unsigned long)Count, Result->FileName);
+            return (false);
+        }
+
+        f64 StartTime = GetWallClockSeconds();
+        bool Success = ReadInputDataFromFile(Result->FileName, &Result->Data);
+        Result->Parse.Seconds[Result->Parse.Count++] = GetWallClockSeconds() - StartTime;
+        NoteBenchMemory();
+
+        if (!Success)
+        {
+            return (false);
+        }
+    }
+
+    // The instances only live for the stages below, the catalog stays
+    ArenaMark Mark = GetArenaMark(&Result->Memory);
+    GalaxyInstance *Instances = PushArray(&Result->Memory, GalaxyInstance, Count);
+    GalaxyInstance *Sorted = PushArray(&Result->Memory, GalaxyInstance, Count);
+    SkyInstance *Sky = PushArray(&Result->Memory, SkyInstance, Count);
+    SkyInstance *SortedSky = PushArray(&Result->Memory, SkyInstance, Count);
+    if (!Instances || !Sorted || !Sky || !SortedSky)
+    {
+        printf("\tNo memory for the instances of %s\n", Result->FileName);
+        PopArenaToMark(&Result->Memory, Mark);
+        return (false);
+    }
+
+    Color InstanceColor = {0, 0, 255, 255};
+    for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        f64 StartTime = GetWallClockSeconds();
+        BuildSphereInstances(&Result->Data, 0, Count, 50.0f, InstanceColor, 0, Instances, Sky);
+        Result->Build.Seconds[Result->Build.Count++] = GetWallClockSeconds() - StartTime;
+    }
+
+    // The index of the last repetition is kept for the picking
+    SpatialIndex Index = {};
+    for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        // @Note(Victor): The sky tiling sorts in place, so every repetition starts from the built order
+        memcpy(Sorted, Instances, Count * sizeof(GalaxyInstance));
+        memcpy(SortedSky, Sky, Count * sizeof(SkyInstance));
+
+        FreeSpatialIndex(&Index);
+        f64 StartTime = GetWallClockSeconds();
+        BuildSkyTiling(&Index, Sorted, SortedSky, Count);
+        Result->Index.Seconds[Result->Index.Count++] = GetWallClockSeconds() - StartTime;
+        NoteBenchMemory();
+    }
+
+    // @Note(Victor): Rays from the Earth towards random galaxies, a little off so that some of them miss,
+    // like the mouse going over the sky
+    IndexProjection Projection = {50.0f, 0.0f, BENCH_GALAXY_RADIUS};
+    Ray PickRays[BENCH_PICK_RAYS];
+    for (u32 i = 0; i < BENCH_PICK_RAYS && Count > 0; ++i)
+    {
+        u64 Target = (u64)(GetRandomUnit(Count, i, 0) * Count);
+        Vector3 Direction = GetInstanceDirection(&Sorted[Target], &SortedSky[Target]);
+        Direction.x += (f32)(GetRandomUnit(Count, i, 1) - 0.5) * 4.0f * BENCH_PICK_TOLERANCE;
+        Direction.y += (f32)(GetRandomUnit(Count, i, 2) - 0.5) * 4.0f * BENCH_PICK_TOLERANCE;
+        Direction.z += (f32)(GetRandomUnit(Count, i, 3) - 0.5) * 4.0f * BENCH_PICK_TOLERANCE;
+        PickRays[i] = {{0.0f, 0.0f, 0.0f}, Vector3Normalize(Direction)};
+    }
+
+    u32 PickHitCount = 0;
+    for (u32 Repetition = 0; Repetition < Repetitions && Count > 0; ++Repetition)
+    {
+        PickHitCount = 0;
+        f64 StartTime = GetWallClockSeconds();
+        for (u32 i = 0; i < BENCH_PICK_RAYS; ++i)
+        {
+            PickResult Pick = PickSpatialIndex(&Index, Sorted, SortedSky, &Projection, PickRays[i], BENCH_PICK_TOLERANCE);
+            PickHitCount += Pick.Hit ? 1 : 0;
+        }
+        Result->Pick.Seconds[Result->Pick.Count++] = (GetWallClockSeconds() - StartTime) / BENCH_PICK_RAYS;
+    }
+    printf("\t%u of %u pick rays hit a galaxy\n", PickHitCount, BENCH_PICK_RAYS);
+
+    FreeSpatialIndex(&Index);
+
+    for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+    {
+        SkyDensityMap Density = {};
+        AllocateSkyDensityMap(&Density, SKY_DENSITY_DEFAULT_COLUMNS);
+
+        f64 StartTime = GetWallClockSeconds();
+        AddSkyDensityPoints(&Density, SKY_DENSITY_DATA, &Result->Data, 0, Count);
+        ColorSkyDensityMap(&Density);
+        Result->Density.Seconds[Result->Density.Count++] = GetWallClockSeconds() - StartTime;
+        NoteBenchMemory();
+
+        FreeSkyDensityMap(&Density);
+    }
+
+    PopArenaToMark(&Result->Memory, Mark);
+
+    return (true);
+}
+
+// Angle between two points given in radians, in arc seconds. Haversine, the angles are tiny.
+internal f64
+GetBenchSeparation(f64 RightAscensionA, f64 DeclinationA, f64 RightAscensionB, f64 DeclinationB)
+{
+    f64 SinDec = sin(0.5 * (DeclinationB - DeclinationA));
+    f64 SinRa = sin(0.5 * (RightAscensionB - RightAscensionA));
+    f64 Haversine = SinDec * SinDec + cos(DeclinationA) * cos(DeclinationB) * SinRa * SinRa;
+
+    return 2.0 * asin(sqrt(Haversine)) / PIdividedBy180 * 3600.0;
+}
+
+// @Note(Victor): Parses the catalog again in the storage it was not benchmarked in, on an arena of its own
+// so the numbers of the stages above stay as they were
+internal bool
+BenchCatalogPrecision(BenchCatalog *Result)
+{
+    u64 Count = Result->Data.Count;
+    MemoryArena Scratch = {};
+
+    Catalog Other = {};
+    bool Success = IsCatalogCompact(&Result->Data) ? AllocateCatalog(&Other, &Scratch, Count, false)
+                                                   : AllocateCompactCatalog(&Other, &Scratch, Count);
+    Success = Success && ReadInputDataFromFile(Result->FileName, &Other) && Other.Count == Count;
+
+    GalaxyInstance *Instances = Success ? PushArray(&Scratch, GalaxyInstance, Count) : nullptr;
+    SkyInstance *ExactSky = Success ? PushArray(&Scratch, SkyInstance, Count) : nullptr;
+    SkyInstance *CompactSky = Success ? PushArray(&Scratch, SkyInstance, Count) : nullptr;
+    Success = Success && Instances && ExactSky && CompactSky;
+
+    if (Success)
+    {
+        const Catalog *Exact = IsCatalogCompact(&Result->Data) ? &Other : &Result->Data;
+        const Catalog *Compact = IsCatalogCompact(&Result->Data) ? &Result->Data : &Other;
+
+        Color InstanceColor = {0, 0, 255, 255};
+        BuildSphereInstances(Exact, 0, Count, 50.0f, InstanceColor, 0, Instances, ExactSky);
+        BuildSphereInstances(Compact, 0, Count, 50.0f, InstanceColor, 0, Instances, CompactSky);
+
+        BenchPrecision *Precision = &Result->Precision;
+        f64 SumArcmin = 0.0;
+        f64 SumArcsec = 0.0;
+        u64 IdenticalCount = 0;
+        for (u64 i = 0; i < Count; ++i)
+        {
+            f64 Ra = Exact->RightAscension[i];
+            f64 Dec = Exact->Declination[i];
+            f64 CompactRa = GetCatalogRightAscension(Compact, i);
+            f64 CompactDec = GetCatalogDeclination(Compact, i);
+
+            f64 Arcmin = fmax(fabs(CompactRa - Ra), fabs(CompactDec - Dec));
+            f64 Arcsec = GetBenchSeparation(Ra / 60.0 * PIdividedBy180, Dec / 60.0 * PIdividedBy180,
+                                            CompactRa / 60.0 * PIdividedBy180, CompactDec / 60.0 * PIdividedBy180);
+            f64 InstanceArcsec = GetBenchSeparation(ExactSky[i].RightAscension, ExactSky[i].Declination,
+                                                    CompactSky[i].RightAscension, CompactSky[i].Declination);
+
+            Precision->MaxArcmin = fmax(Precision->MaxArcmin, Arcmin);
+            Precision->MaxArcsec = fmax(Precision->MaxArcsec, Arcsec);
+            Precision->MaxInstanceArcsec = fmax(Precision->MaxInstanceArcsec, InstanceArcsec);
+            SumArcmin += Arcmin;
+            SumArcsec += Arcsec;
+            IdenticalCount += ExactSky[i].RightAscension == CompactSky[i].RightAscension &&
+                              ExactSky[i].Declination == CompactSky[i].Declination;
+        }
+
+        Precision->MeanArcmin = Count > 0 ? SumArcmin / Count : 0.0;
+        Precision->MeanArcsec = Count > 0 ? SumArcsec / Count : 0.0;
+        Precision->IdenticalInstances = Count > 0 ? (f64)IdenticalCount / Count : 1.0;
+    }
+    else
+    {
+        printf("\tCould not compare %s with its fixed point storage\n", Result->FileName);
+    }
+
+    FreeCatalog(&Other);
+    FreeArena(&Scratch);
+
+    return (Success);
+}
+
+internal bool
+IsBenchRequested(i32 argc, char **argv)
+{
+    for (i32 i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--bench") == 0 || strncmp(argv[i], "--bench=", strlen("--bench=")) == 0)
+        {
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+// @Note(Victor): Call before anything is printed. From then on printf goes to stderr and the returned
+// file is the real stdout, for the JSON only.
+internal FILE *
+BeginBenchOutput(void)
+{
+    FILE *Json = stdout;
+
+#if defined(__linux__) || defined(__APPLE__)
+    fflush(stdout);
+    i32 JsonDescriptor = dup(STDOUT_FILENO);
+    if (JsonDescriptor >= 0 && dup2(STDERR_FILENO, STDOUT_FILENO) >= 0)
+    {
+        Json = fdopen(JsonDescriptor, "w");
+    }
+#endif
+
+    return Json;
+}
+
+// @Note(Victor): Returns the exit code of the program
+internal i32
+RunHeadlessBenchmark(const BenchOptions *Options, FILE *Json)
+{
+    u32 Repetitions = Options->Repetitions;
+    Repetitions = Repetitions < 1 ? 1 : (Repetitions > BENCH_MAX_REPETITIONS ? BENCH_MAX_REPETITIONS : Repetitions);
+
+    BenchCatalog *Catalogs = (BenchCatalog *)calloc(Options->FileCount, sizeof(BenchCatalog));
+    bool Success = true;
+    for (u32 i = 0; Success && i < Options->FileCount; ++i)
+    {
+        printf("\tBenchmarking %s, %u repetitions\n", Options->Files[i], Repetitions);
+        Catalogs[i].FileName = Options->Files[i];
+        Success = BenchCatalogStages(&Catalogs[i], Repetitions) && BenchCatalogPrecision(&Catalogs[i]);
+    }
+
+    // One tree and one brute force stage per size, the stages are too big for the stack
+    u32 SizeCount = Options->CorrelationSizeCount;
+    BenchStage *Correlation = (BenchStage *)calloc(2 * BENCH_MAX_CORRELATION_SIZES, sizeof(BenchStage));
+    BenchStage *CorrelationBruteForce = Correlation + BENCH_MAX_CORRELATION_SIZES;
+    u64 CorrelationCounts[BENCH_MAX_CORRELATION_SIZES] = {};
+    if (Success && Options->FileCount >= 2)
+    {
+        const Catalog *Data = &Catalogs[0].Data;
+        const Catalog *Random = &Catalogs[1].Data;
+
+        CorrelationResult *Result = (CorrelationResult *)calloc(1, sizeof(CorrelationResult));
+        for (u32 Size = 0; Size < SizeCount; ++Size)
+        {
+            u64 CorrelationCount = Options->CorrelationSizes[Size];
+            CorrelationCount = CorrelationCount < Data->Count ? CorrelationCount : Data->Count;
+            CorrelationCount = CorrelationCount < Random->Count ? CorrelationCount : Random->Count;
+            CorrelationCounts[Size] = CorrelationCount;
+
+            printf("\tAngular correlation of %lu galaxies\n", (unsigned long)CorrelationCount);
+            for (u32 Repetition = 0; Repetition < Repetitions; ++Repetition)
+            {
+                f64 StartTime = GetWallClockSeconds();
+                ComputeAngularCorrelation(Data, CorrelationCount, Random, CorrelationCount, Result, CORRELATION_TREE);
+                Correlation[Size].Seconds[Correlation[Size].Count++] = GetWallClockSeconds() - StartTime;
+                NoteBenchMemory();
+
+                if (Options->CorrelationBruteForce)
+                {
+                    StartTime = GetWallClockSeconds();
+                    ComputeAngularCorrelation(Data, CorrelationCount, Random, CorrelationCount, Result, CORRELATION_BRUTE_FORCE);
+                    CorrelationBruteForce[Size].Seconds[CorrelationBruteForce[Size].Count++] = GetWallClockSeconds() - StartTime;
+                    NoteBenchMemory();
+                }
+            }
+        }
+        free(Result);
+    }
+
+    if (Success)
+    {
+        fprintf(Json, "{\n");
+        fprintf(Json, "  \"threads\": %u,\n", GetThreadCount());
+        fprintf(Json, "  \"avx2\": %s,\n", UseAngleKernelsAVX2() ? "true" : "false");
+        fprintf(Json, "  \"repetitions\": %u,\n", Repetitions);
+        fprintf(Json, "  \"catalogs\": [\n");
+        for (u32 i = 0; i < Options->FileCount; ++i)
+        {
+            BenchCatalog *Bench = &Catalogs[i];
+            fprintf(Json, "    {\n      \"file\": ");
+            PrintJsonString(Json, Bench->FileName);
+            fprintf(Json, ",\n      \"count\": %lu,\n      \"bytes\": %lu,\n      \"arena_peak_bytes\": %lu,\n",
+                    (unsigned long)Bench->Data.Count, (unsigned long)Bench->FileSize, (unsigned long)Bench->Memory.Peak);
+            fprintf(Json, "      \"storage\": \"%s\",\n      \"bytes_per_galaxy\": %lu,\n",
+                    IsCatalogCompact(&Bench->Data) ? "fixed32" : "f64", (unsigned long)GetCatalogGalaxySize(&Bench->Data));
+
+            BenchPrecision *Precision = &Bench->Precision;
+            fprintf(Json, "      \"fixed_point_error\": {\"max_arcmin\": %.3e, \"mean_arcmin\": %.3e, \"max_arcsec\": %.3e, \"mean_arcsec\": %.3e, "
+                          "\"instance_max_arcsec\": %.3e, \"identical_instances\": %.6f},\n",
+                    Precision->MaxArcmin, Precision->MeanArcmin, Precision->MaxArcsec, Precision->MeanArcsec,
+                    Precision->MaxInstanceArcsec, Precision->IdenticalInstances);
+            fprintf(Json, "      \"stages\": {\n");
+            PrintBenchStage(Json, "read", &Bench->Read, false);
+            PrintBenchStage(Json, "parse", &Bench->Parse, false);
+            PrintBenchStage(Json, "build", &Bench->Build, false);
+            PrintBenchStage(Json, "index", &Bench->Index, false);
+            PrintBenchStage(Json, "density", &Bench->Density, false);
+            PrintBenchStage(Json, "pick", &Bench->Pick, true);
+            fprintf(Json, "      }\n    }%s\n", i + 1 < Options->FileCount ? "," : "");
+        }
+        fprintf(Json, "  ],\n");
+
+        fprintf(Json, "  \"analysis\": {\n");
+        if (SizeCount > 0 && Correlation[0].Count > 0)
+        {
+            fprintf(Json, "    \"angular_correlation\": [\n");
+            for (u32 Size = 0; Size < SizeCount; ++Size)
+            {
+                BenchStats Stats = GetBenchStats(&Correlation[Size]);
+                fprintf(Json, "      {\"count\": %lu, \"median_ms\": %.4f, \"p95_ms\": %.4f, \"min_ms\": %.4f, \"max_ms\": %.4f",
+                        (unsigned long)CorrelationCounts[Size], Stats.Median * 1000.0, Stats.P95 * 1000.0, Stats.Min * 1000.0, Stats.Max * 1000.0);
+                if (CorrelationBruteForce[Size].Count > 0)
+                {
+                    BenchStats BruteForceStats = GetBenchStats(&CorrelationBruteForce[Size]);
+                    fprintf(Json, ", \"brute_force_median_ms\": %.4f", BruteForceStats.Median * 1000.0);
+                }
+                fprintf(Json, "}%s\n", Size + 1 < SizeCount ? "," : "");
+            }
+            fprintf(Json, "    ]\n");
+        }
+        fprintf(Json, "  },\n");
+
+        fprintf(Json, "  \"memory\": {\"peak_resident_bytes\": %lu, \"peak_tracked_bytes\": %lu}\n",
+                (unsigned long)GetPeakResidentMemory(), (unsigned long)BenchPeakTrackedMemory);
+        fprintf(Json, "}\n");
+    }
+    else
+    {
+        printf("\tThe benchmark failed\n");
+    }
+
+    for (u32 i = 0; i < Options->FileCount; ++i)
+    {
+        FreeCatalog(&Catalogs[i].Data);
+        FreeArena(&Catalogs[i].Memory);
+    }
+    free(Catalogs);
+    free(Correlation);
+
+    fflush(stdout);
+    if (Json != stdout)
+    {
+        fclose(Json);
+    }
+
+    // @Note(Victor): Same as CleanupOurStuff, everything we allocated is freed again
+    Assert(CPUMemory == 0);
+
+    return Success ? 0 : 1;
+}
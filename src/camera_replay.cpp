@@ -0,0 +1,489 @@
+// Camera replay -----------------------------------------------------------------
+// @Note(Victor): GALAXY_REPLAY=path.txt flies the camera along a scripted path with a fixed timestep and
+// no frame cap, and writes the frame times to GALAXY_REPLAY_OUT (galaxy_replay.json by default) when it
+// is done. The same path renders the same frames on every run, so two builds (or two machines) can be
+// compared frame by frame.
+//
+// The path file is one segment per line, # starts a comment:
+//   timestep 0.016667                      seconds per frame, 1/60 by default
+//   orbit <seconds> <zoom> [speed]         the orbit of the auto camera, speed in radians per second (0.2)
+//   zoom <seconds> <from> <to> [speed]     the same orbit while the zoom goes from one value to the other
+//   fly <seconds> x0 y0 z0 x1 y1 z1 tx ty tz [tx1 ty1 tz1]
+//                                          a straight line looking at a target (or from one to the next)
+// The orbit angle carries over from one orbit or zoom segment to the next, like the auto camera.
+//
+// Every frame records its wall time, the CPU part of it (without the time EndDrawing waits in the swap)
+// and the GPU time of its passes. The GPU times come back PROFILER_GPU_FRAMES frames late, so a few more
+// frames are drawn at the end of the path before the summary is written. GALAXY_REPLAY_SHOTS=dir writes
+// every GALAXY_REPLAY_SHOT_EVERY'th frame (60) to dir as a PNG, the time that takes is not counted.
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+const u32 CAMERA_PATH_MAX_SEGMENTS = 256;
+const u32 CAMERA_REPLAY_MAX_FRAMES = 1 << 20;
+const f64 CAMERA_REPLAY_ORBIT_SPEED = 0.2; // Radians per second, what RotateCameraAroundOrigo turns
+
+enum Camera_Segment_Kind
+{
+    CAMERA_SEGMENT_ORBIT,
+    CAMERA_SEGMENT_ZOOM,
+    CAMERA_SEGMENT_FLY,
+};
+
+struct CameraSegment
+{
+    Camera_Segment_Kind Kind;
+    f64 Seconds;
+
+    // Orbit and zoom
+    f64 ZoomFrom;
+    f64 ZoomTo;
+    f64 Speed;
+
+    // Fly
+    Vector3 From;
+    Vector3 To;
+    Vector3 TargetFrom;
+    Vector3 TargetTo;
+};
+
+struct CameraPath
+{
+    CameraSegment Segments[CAMERA_PATH_MAX_SEGMENTS];
+    u32 SegmentCount;
+    f64 TimeStep;
+    f64 Seconds;
+    u32 FrameCount;
+};
+
+struct CameraReplay
+{
+    const char *PathFileName; // nullptr when there is no replay
+    const char *OutFileName;
+    const char *ShotDirectory;
+    u32 ShotEvery;
+
+    CameraPath Path;
+    bool IsRunning; // Set by the main loop while the frames count
+    bool IsDone;
+
+    u32 Frame;         // The next frame of the path
+    u32 DrainFrames;   // Drawn after the path, until the last GPU times are back
+    u64 ProfilerFirst; // FrameNumber of the profiler at frame 0 of the path
+    f64 ShotSeconds;   // Taking the screenshot of this frame
+
+    // Per frame of the path, seconds
+    f64 *FrameSeconds;
+    f64 *CpuSeconds;
+    f64 *GpuSeconds; // Negative until the GPU time of the frame is read back
+};
+
+internal bool
+LoadCameraPath(const char *FileName, CameraPath *Path)
+{
+    FILE *File = fopen(FileName, "r");
+    if (File == nullptr)
+    {
+        printf("\tCould not open the camera path %s\n", FileName);
+        return (false);
+    }
+
+    *Path = {};
+    Path->TimeStep = 1.0 / 60.0;
+
+    char Line[512];
+    u32 LineNumber = 0;
+    bool IsValid = true;
+    while (IsValid && fgets(Line, sizeof(Line), File))
+    {
+        LineNumber++;
+
+        char *Comment = strchr(Line, '#');
+        if (Comment)
+        {
+            *Comment = 0;
+        }
+
+        char Command[32] = {};
+        if (sscanf(Line, "%31s", Command) != 1)
+        {
+            continue;
+        }
+
+        if (strcmp(Command, "timestep") == 0)
+        {
+            IsValid = sscanf(Line, "%*s %lf", &Path->TimeStep) == 1 && Path->TimeStep > 0.0;
+            continue;
+        }
+
+        if (Path->SegmentCount == CAMERA_PATH_MAX_SEGMENTS)
+        {
+            printf("\tThe camera path %s has more than %u segments\n", FileName, CAMERA_PATH_MAX_SEGMENTS);
+            IsValid = false;
+            break;
+        }
+
+        CameraSegment *Segment = &Path->Segments[Path->SegmentCount];
+        Segment->Speed = CAMERA_REPLAY_ORBIT_SPEED;
+
+        if (strcmp(Command, "orbit") == 0)
+        {
+            Segment->Kind = CAMERA_SEGMENT_ORBIT;
+            IsValid = sscanf(Line, "%*s %lf %lf %lf", &Segment->Seconds, &Segment->ZoomFrom, &Segment->Speed) >= 2;
+            Segment->ZoomTo = Segment->ZoomFrom;
+        }
+        else if (strcmp(Command, "zoom") == 0)
+        {
+            Segment->Kind = CAMERA_SEGMENT_ZOOM;
+            IsValid = sscanf(Line, "%*s %lf %lf %lf %lf", &Segment->Seconds, &Segment->ZoomFrom, &Segment->ZoomTo, &Segment->Speed) >= 3;
+        }
+        else if (strcmp(Command, "fly") == 0)
+        {
+            Segment->Kind = CAMERA_SEGMENT_FLY;
+            Vector3 *From = &Segment->From;
+            Vector3 *To = &Segment->To;
+            Vector3 *Target = &Segment->TargetFrom;
+            Vector3 *TargetTo = &Segment->TargetTo;
+            i32 Count = sscanf(Line, "%*s %lf %f %f %f %f %f %f %f %f %f %f %f %f", &Segment->Seconds, &From->x, &From->y, &From->z,
+                               &To->x, &To->y, &To->z, &Target->x, &Target->y, &Target->z, &TargetTo->x, &TargetTo->y, &TargetTo->z);
+            IsValid = Count == 10 || Count == 13;
+            if (Count == 10)
+            {
+                *TargetTo = *Target;
+            }
+        }
+        else
+        {
+            IsValid = false;
+        }
+
+        IsValid = IsValid && Segment->Seconds > 0.0;
+        if (IsValid)
+        {
+            Path->Seconds += Segment->Seconds;
+            Path->SegmentCount++;
+        }
+    }
+    fclose(File);
+
+    if (!IsValid)
+    {
+        printf("\tCould not read line %u of the camera path %s\n", LineNumber, FileName);
+        return (false);
+    }
+
+    f64 FrameCount = ceil(Path->Seconds / Path->TimeStep - 1e-9);
+    if (Path->SegmentCount == 0 || FrameCount > CAMERA_REPLAY_MAX_FRAMES)
+    {
+        printf("\tThe camera path %s needs between 1 and %u frames\n", FileName, CAMERA_REPLAY_MAX_FRAMES);
+        return (false);
+    }
+    Path->FrameCount = (u32)FrameCount;
+
+    return (true);
+}
+
+// @Note(Victor): Only depends on the frame, never on how long the frames before it took
+internal void
+GetCameraPathPose(const CameraPath *Path, u32 Frame, Camera3D *Camera)
+{
+    f64 Time = Frame * Path->TimeStep;
+    f64 Angle = 0.0;
+
+    for (u32 i = 0; i < Path->SegmentCount; ++i)
+    {
+        const CameraSegment *Segment = &Path->Segments[i];
+        bool IsLast = i == Path->SegmentCount - 1;
+        if (Time > Segment->Seconds && !IsLast)
+        {
+            Time -= Segment->Seconds;
+            if (Segment->Kind != CAMERA_SEGMENT_FLY)
+            {
+                Angle += Segment->Speed * Segment->Seconds;
+            }
+            continue;
+        }
+
+        f32 t = (f32)fmin(Time / Segment->Seconds, 1.0);
+        if (Segment->Kind == CAMERA_SEGMENT_FLY)
+        {
+            Camera->position = Vector3Lerp(Segment->From, Segment->To, t);
+            Camera->target = Vector3Lerp(Segment->TargetFrom, Segment->TargetTo, t);
+        }
+        else
+        {
+            // The auto camera of RotateCameraAroundOrigo
+            Angle += Segment->Speed * Time;
+            f64 PathZoom = Segment->ZoomFrom + (Segment->ZoomTo - Segment->ZoomFrom) * t;
+
+            Camera->position.x = 25.0f * cosf(Angle) * PathZoom;
+            Camera->position.y = 50.0f;
+            Camera->position.z = 25.0f * sinf(Angle) * PathZoom;
+            Camera->target = Vector3Zero();
+        }
+        Camera->up = {0.0f, 1.0f, 0.0f};
+        break;
+    }
+}
+
+// Reads the path and makes room for its frames, the replay itself starts once the catalogs are loaded
+internal bool
+LoadCameraReplay(CameraReplay *Replay)
+{
+    if (!LoadCameraPath(Replay->PathFileName, &Replay->Path))
+    {
+        return (false);
+    }
+
+    u32 Count = Replay->Path.FrameCount;
+    Replay->FrameSeconds = (f64 *)calloc(3 * Count, sizeof(f64));
+    Replay->CpuSeconds = Replay->FrameSeconds + Count;
+    Replay->GpuSeconds = Replay->CpuSeconds + Count;
+    CPUMemory += 3 * Count * sizeof(f64);
+
+    for (u32 Frame = 0; Frame < Count; ++Frame)
+    {
+        Replay->GpuSeconds[Frame] = -1.0;
+    }
+
+    if (Replay->ShotDirectory)
+    {
+#if defined(__linux__) || defined(__APPLE__)
+        mkdir(Replay->ShotDirectory, 0755);
+#endif
+    }
+
+    printf("\tReplaying %s: %u frames of %.4f s, %u segments\n", Replay->PathFileName, Count, Replay->Path.TimeStep, Replay->Path.SegmentCount);
+
+    return (true);
+}
+
+internal void
+FreeCameraReplay(CameraReplay *Replay)
+{
+    if (Replay->FrameSeconds)
+    {
+        free(Replay->FrameSeconds);
+        CPUMemory -= 3 * Replay->Path.FrameCount * sizeof(f64);
+    }
+    Replay->FrameSeconds = nullptr;
+    Replay->CpuSeconds = nullptr;
+    Replay->GpuSeconds = nullptr;
+}
+
+// Whether the frame that is drawn now is recorded, false while draining
+internal bool
+IsCameraReplayRecording(const CameraReplay *Replay)
+{
+    return Replay->IsRunning && Replay->Frame < Replay->Path.FrameCount;
+}
+
+// @Note(Victor): Before EndDrawing, the screen is read back from the back buffer
+internal void
+TakeCameraReplayShot(CameraReplay *Replay)
+{
+    Replay->ShotSeconds = 0.0;
+    if (!IsCameraReplayRecording(Replay) || Replay->ShotDirectory == nullptr || Replay->Frame % Replay->ShotEvery != 0)
+    {
+        return;
+    }
+
+    f64 Start = GetWallClockSeconds();
+
+    rlDrawRenderBatchActive();
+    Image Shot = LoadImageFromScreen();
+    ExportImage(Shot, TextFormat("%s/frame_%06u.png", Replay->ShotDirectory, Replay->Frame));
+    UnloadImage(Shot);
+
+    Replay->ShotSeconds = GetWallClockSeconds() - Start;
+}
+
+struct CameraReplayStats
+{
+    f64 Mean;
+    f64 P50;
+    f64 P99;
+    f64 Worst;
+    u32 WorstFrame;
+    u32 Count;
+};
+
+// Nearest rank percentiles, the frames without a time (negative) are left out
+internal CameraReplayStats
+GetCameraReplayStats(const f64 *Seconds, u32 Count)
+{
+    CameraReplayStats Result = {};
+
+    f64 *Sorted = (f64 *)calloc(Count > 0 ? Count : 1, sizeof(f64));
+    f64 Sum = 0.0;
+    for (u32 Frame = 0; Frame < Count; ++Frame)
+    {
+        if (Seconds[Frame] < 0.0)
+        {
+            continue;
+        }
+
+        Sorted[Result.Count++] = Seconds[Frame];
+        Sum += Seconds[Frame];
+        if (Seconds[Frame] > Result.Worst)
+        {
+            Result.Worst = Seconds[Frame];
+            Result.WorstFrame = Frame;
+        }
+    }
+
+    if (Result.Count > 0)
+    {
+        std::sort(Sorted, Sorted + Result.Count);
+        Result.Mean = Sum / Result.Count;
+        Result.P50 = Sorted[(u32)ceil(0.50 * Result.Count) - 1];
+        Result.P99 = Sorted[(u32)ceil(0.99 * Result.Count) - 1];
+    }
+    free(Sorted);
+
+    return Result;
+}
+
+internal void
+PrintCameraReplayStats(FILE *Out, const char *Name, const f64 *Seconds, u32 Count, bool IsLast)
+{
+    CameraReplayStats Stats = GetCameraReplayStats(Seconds, Count);
+    fprintf(Out, "    \"%s\": ", Name);
+    if (Stats.Count == 0)
+    {
+        fprintf(Out, "null%s\n", IsLast ? "" : ",");
+        return;
+    }
+
+    fprintf(Out, "{\"frames\": %u, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p99_ms\": %.4f, \"worst_ms\": %.4f, \"worst_frame\": %u}%s\n",
+            Stats.Count, Stats.Mean * 1000.0, Stats.P50 * 1000.0, Stats.P99 * 1000.0, Stats.Worst * 1000.0, Stats.WorstFrame, IsLast ? "" : ",");
+
+    printf("\t%-6s mean %8.3f ms  p50 %8.3f ms  p99 %8.3f ms  worst %8.3f ms (frame %u)\n", Name, Stats.Mean * 1000.0, Stats.P50 * 1000.0,
+           Stats.P99 * 1000.0, Stats.Worst * 1000.0, Stats.WorstFrame);
+}
+
+internal void
+PrintCameraReplaySeries(FILE *Out, const char *Name, const f64 *Seconds, u32 Count, bool IsLast)
+{
+    fprintf(Out, "    \"%s\": [", Name);
+    for (u32 Frame = 0; Frame < Count; ++Frame)
+    {
+        if (Seconds[Frame] < 0.0)
+        {
+            fprintf(Out, "%snull", Frame ? ", " : "");
+        }
+        else
+        {
+            fprintf(Out, "%s%.4f", Frame ? ", " : "", Seconds[Frame] * 1000.0);
+        }
+    }
+    fprintf(Out, "]%s\n", IsLast ? "" : ",");
+}
+
+// @Note(Victor): llvmpipe or a GPU, so a JSON says what it was measured on
+typedef const u8 *GLGetString(u32 Name);
+const u32 GL_RENDERER_STRING = 0x1F01;
+
+internal const char *
+GetGLRenderer(void)
+{
+#if PROFILER_HAS_GL_TIMERS
+    GLGetString *GetString = (GLGetString *)GetGLProcedure("glGetString");
+    if (GetString)
+    {
+        return (const char *)GetString(GL_RENDERER_STRING);
+    }
+#endif
+    return nullptr;
+}
+
+internal bool
+WriteCameraReplay(const CameraReplay *Replay)
+{
+    const char *Renderer = GetGLRenderer();
+    const CameraPath *Path = &Replay->Path;
+    u32 Count = Path->FrameCount;
+
+    printf("\n\tCamera replay of %s, %u frames\n", Replay->PathFileName, Count);
+
+    FILE *Out = fopen(Replay->OutFileName, "w");
+    if (Out == nullptr)
+    {
+        printf("\tCould not write %s\n", Replay->OutFileName);
+        return (false);
+    }
+
+    fprintf(Out, "{\n");
+    fprintf(Out, "  \"path\": ");
+    PrintJsonString(Out, Replay->PathFileName);
+    fprintf(Out, ",\n  \"renderer\": ");
+    PrintJsonString(Out, Renderer ? Renderer : "unknown");
+    fprintf(Out, ",\n  \"width\": %i,\n  \"height\": %i,\n", GetScreenWidth(), GetScreenHeight());
+    fprintf(Out, "  \"timestep\": %.6f,\n  \"frames\": %u,\n", Path->TimeStep, Count);
+
+    fprintf(Out, "  \"summary\": {\n");
+    PrintCameraReplayStats(Out, "frame", Replay->FrameSeconds, Count, false);
+    PrintCameraReplayStats(Out, "cpu", Replay->CpuSeconds, Count, false);
+    PrintCameraReplayStats(Out, "gpu", Replay->GpuSeconds, Count, true);
+    fprintf(Out, "  },\n");
+
+    fprintf(Out, "  \"frame_ms\": {\n");
+    PrintCameraReplaySeries(Out, "frame", Replay->FrameSeconds, Count, false);
+    PrintCameraReplaySeries(Out, "cpu", Replay->CpuSeconds, Count, false);
+    PrintCameraReplaySeries(Out, "gpu", Replay->GpuSeconds, Count, true);
+    fprintf(Out, "  }\n}\n");
+    fclose(Out);
+
+    printf("\tWrote %s\n", Replay->OutFileName);
+
+    return (true);
+}
+
+// @Note(Victor): After EndProfileFrame, takes this frame's times from the profiler. Returns true once the
+// last GPU times are in and the summary is written.
+internal bool
+EndCameraReplayFrame(CameraReplay *Replay)
+{
+    if (!Replay->IsRunning)
+    {
+        return Replay->IsDone;
+    }
+
+    Profiler *Profile = &GlobalProfiler;
+    u32 Count = Replay->Path.FrameCount;
+
+    if (Replay->Frame < Count)
+    {
+        if (Replay->Frame == 0)
+        {
+            Replay->ProfilerFirst = Profile->FrameNumber - 1;
+        }
+
+        f64 Frame = GetLastProfileSeconds("Frame", PROFILE_CPU) - Replay->ShotSeconds;
+        f64 Present = GetLastProfileSeconds("Present", PROFILE_CPU);
+        Replay->FrameSeconds[Replay->Frame] = Frame;
+        Replay->CpuSeconds[Replay->Frame] = Frame > Present ? Frame - Present : 0.0;
+        Replay->Frame++;
+    }
+    else
+    {
+        Replay->DrainFrames++;
+    }
+
+    if (Profile->HasGpuRead && Profile->GpuReadFrame >= Replay->ProfilerFirst && Profile->GpuReadFrame - Replay->ProfilerFirst < Count &&
+        Replay->Frame > 0)
+    {
+        Replay->GpuSeconds[Profile->GpuReadFrame - Replay->ProfilerFirst] = Profile->GpuReadSeconds;
+    }
+
+    if (Replay->Frame == Count && (Replay->DrainFrames > PROFILER_GPU_FRAMES || !Profile->HasGpuTimers))
+    {
+        WriteCameraReplay(Replay);
+        Replay->IsRunning = false;
+        Replay->IsDone = true;
+    }
+
+    return Replay->IsDone;
+}
@@ -0,0 +1,297 @@
+// Catalogs ------------------------------------------------------------------------
+// @Note(Victor): A catalog is one galaxy per index with every field in its own column (structure of
+// arrays). The columns are either pushed on a memory arena (see memory_arena.cpp), or they point straight
+// into a memory mapped .gcat file (see catalog_cache.cpp), in which case they are read only.
+//
+// With GALAXY_COMPACT the arcmin catalogs keep their positions as fixed point instead: an i32 count of
+// CATALOG_FIXED_STEP (1e-4) arc minutes per coordinate, 8 bytes a galaxy instead of 16. The course
+// catalogs print six significant digits: mostly two decimals, at most six for the values below 1
+// (data_100k_arcmin.txt), six everywhere in flat_100k_arcmin.txt. Everything up to four decimals is kept
+// exactly, the rest is rounded by at most half a step, 5e-5 arc minutes (0.003 arc seconds), about a
+// float ulp of the radians the instances are built in. Either the f64 or the fixed columns are set, never both.
+
+#include <sys/stat.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define PLATFORM_HAS_MMAP 1
+#else
+#define PLATFORM_HAS_MMAP 0
+#endif
+
+struct MappedFile
+{
+    const char *Data = nullptr;
+    u64 Size = 0;
+    bool IsMapped = false; // Otherwise Data was read into a malloc'd buffer
+};
+
+internal bool
+MapFile(const char *FileName, MappedFile *File)
+{
+    *File = {};
+
+#if PLATFORM_HAS_MMAP
+    i32 Descriptor = open(FileName, O_RDONLY);
+    if (Descriptor < 0)
+    {
+        return (false);
+    }
+
+    struct stat FileStat;
+    if (fstat(Descriptor, &FileStat) != 0)
+    {
+        close(Descriptor);
+        return (false);
+    }
+
+    File->Size = (u64)FileStat.st_size;
+    if (File->Size > 0)
+    {
+        void *Mapping = mmap(nullptr, File->Size, PROT_READ, MAP_PRIVATE, Descriptor, 0);
+        if (Mapping == MAP_FAILED)
+        {
+            close(Descriptor);
+            return (false);
+        }
+
+        madvise(Mapping, File->Size, MADV_WILLNEED);
+        File->Data = (const char *)Mapping;
+        File->IsMapped = true;
+    }
+
+    // The mapping keeps the file alive
+    close(Descriptor);
+    return (true);
+#else
+    FILE *f = fopen(FileName, "rb");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    fseek(f, 0, SEEK_END);
+    File->Size = (u64)ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *Buffer = (char *)malloc(File->Size + 1);
+    if (fread(Buffer, 1, File->Size, f) != File->Size)
+    {
+        free(Buffer);
+        fclose(f);
+        return (false);
+    }
+
+    fclose(f);
+    File->Data = Buffer;
+    return (true);
+#endif
+}
+
+internal void
+UnmapFile(MappedFile *File)
+{
+#if PLATFORM_HAS_MMAP
+    if (File->IsMapped)
+    {
+        munmap((void *)File->Data, File->Size);
+    }
+#else
+    free((void *)File->Data);
+#endif
+    *File = {};
+}
+
+enum Catalog_Field
+{
+    CATALOG_FIELD_RIGHT_ASCENSION,
+    CATALOG_FIELD_DECLINATION,
+    CATALOG_FIELD_REDSHIFT,
+
+    CATALOG_FIELD_COUNT,
+};
+
+struct Catalog
+{
+    u64 Count = 0;
+    u64 Capacity = 0;
+
+    // @Note(Victor): Arc minutes for the course catalogs, HHMMSS.s / DDMMSS for the redshift catalog
+    f64 *RightAscension = nullptr;
+    f64 *Declination = nullptr;
+    f64 *Redshift = nullptr; // cz in km/s, nullptr when the catalog has no redshift column
+
+    // Compact arcmin catalogs, RightAscension and Declination are nullptr then
+    i32 *RightAscensionFixed = nullptr;
+    i32 *DeclinationFixed = nullptr;
+
+    // Bytes of the source file the galaxies were read from, the lines after that were appended since
+    // (see ReadCatalogTail). 0 when there is no source, e.g. a standalone .gcat.
+    u64 SourceSize = 0;
+
+    // Set when the columns live in a mapped .gcat file instead of our own memory
+    MappedFile Cache;
+};
+
+internal f64 **
+GetCatalogColumn(Catalog *Result, Catalog_Field Field)
+{
+    switch (Field)
+    {
+    case CATALOG_FIELD_RIGHT_ASCENSION:
+        return &Result->RightAscension;
+    case CATALOG_FIELD_DECLINATION:
+        return &Result->Declination;
+    case CATALOG_FIELD_REDSHIFT:
+        return &Result->Redshift;
+    default:
+        return nullptr;
+    }
+}
+
+internal i32 **
+GetCatalogFixedColumn(Catalog *Result, Catalog_Field Field)
+{
+    switch (Field)
+    {
+    case CATALOG_FIELD_RIGHT_ASCENSION:
+        return &Result->RightAscensionFixed;
+    case CATALOG_FIELD_DECLINATION:
+        return &Result->DeclinationFixed;
+    default:
+        return nullptr;
+    }
+}
+
+internal u64
+GetCatalogColumnCount(const Catalog *Source)
+{
+    return Source->Redshift ? 3 : 2;
+}
+
+internal bool
+IsCatalogCompact(const Catalog *Source)
+{
+    return Source->RightAscensionFixed != nullptr;
+}
+
+internal bool
+HasCatalogPositions(const Catalog *Source)
+{
+    return (Source->RightAscension && Source->Declination) || (Source->RightAscensionFixed && Source->DeclinationFixed);
+}
+
+// Bytes one galaxy takes in the columns
+internal u64
+GetCatalogGalaxySize(const Catalog *Source)
+{
+    u64 Result = IsCatalogCompact(Source) ? 2 * sizeof(i32) : 2 * sizeof(f64);
+    return Result + (Source->Redshift ? sizeof(f64) : 0);
+}
+
+// Fixed point positions -----------------------------------------------------------------
+const f64 CATALOG_FIXED_SCALE = 10000.0; // Steps per arc minute
+const f64 CATALOG_FIXED_STEP = 1.0 / CATALOG_FIXED_SCALE;
+
+// @Note(Victor): Set with GALAXY_COMPACT, only the arcmin catalogs are stored compact
+global_variable bool CompactCatalogs = false;
+
+internal inline i32
+QuantizeArcmin(f64 Arcmin)
+{
+    // Far outside the sky, but a number the i32 can hold
+    f64 Steps = Arcmin * CATALOG_FIXED_SCALE;
+    Steps = Steps < -2147483647.0 ? -2147483647.0 : (Steps > 2147483647.0 ? 2147483647.0 : Steps);
+
+    return (i32)llround(Steps);
+}
+
+internal inline f64
+DequantizeArcmin(i32 Steps)
+{
+    return (f64)Steps * CATALOG_FIXED_STEP;
+}
+
+internal inline void
+SetCatalogPosition(Catalog *Result, u64 Index, f64 RightAscension, f64 Declination)
+{
+    if (Result->RightAscensionFixed)
+    {
+        Result->RightAscensionFixed[Index] = QuantizeArcmin(RightAscension);
+        Result->DeclinationFixed[Index] = QuantizeArcmin(Declination);
+    }
+    else
+    {
+        Result->RightAscension[Index] = RightAscension;
+        Result->Declination[Index] = Declination;
+    }
+}
+
+// In the units of the source, arc minutes for a compact catalog
+internal inline f64
+GetCatalogRightAscension(const Catalog *Source, u64 Index)
+{
+    return Source->RightAscensionFixed ? DequantizeArcmin(Source->RightAscensionFixed[Index]) : Source->RightAscension[Index];
+}
+
+internal inline f64
+GetCatalogDeclination(const Catalog *Source, u64 Index)
+{
+    return Source->DeclinationFixed ? DequantizeArcmin(Source->DeclinationFixed[Index]) : Source->Declination[Index];
+}
+
+// @Note(Victor): The columns live as long as Arena, FreeCatalog leaves them to it
+internal bool
+AllocateCatalog(Catalog *Result, MemoryArena *Arena, u64 Capacity, bool HasRedshift)
+{
+    *Result = {};
+
+    ArenaMark Mark = GetArenaMark(Arena);
+    Result->RightAscension = PushArray(Arena, f64, Capacity);
+    Result->Declination = PushArray(Arena, f64, Capacity);
+    Result->Redshift = HasRedshift ? PushArray(Arena, f64, Capacity) : nullptr;
+
+    if (!Result->RightAscension || !Result->Declination || (HasRedshift && !Result->Redshift))
+    {
+        PopArenaToMark(Arena, Mark);
+        *Result = {};
+        return (false);
+    }
+
+    Result->Capacity = Capacity;
+    return (true);
+}
+
+// An arcmin catalog with fixed point positions and no redshift
+internal bool
+AllocateCompactCatalog(Catalog *Result, MemoryArena *Arena, u64 Capacity)
+{
+    *Result = {};
+
+    ArenaMark Mark = GetArenaMark(Arena);
+    Result->RightAscensionFixed = PushArray(Arena, i32, Capacity);
+    Result->DeclinationFixed = PushArray(Arena, i32, Capacity);
+
+    if (!Result->RightAscensionFixed || !Result->DeclinationFixed)
+    {
+        PopArenaToMark(Arena, Mark);
+        *Result = {};
+        return (false);
+    }
+
+    Result->Capacity = Capacity;
+    return (true);
+}
+
+internal void
+FreeCatalog(Catalog *Result)
+{
+    if (Result->Cache.Data)
+    {
+        UnmapFile(&Result->Cache);
+    }
+
+    *Result = {};
+}
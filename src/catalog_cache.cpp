@@ -0,0 +1,463 @@
+// Catalog cache (.gcat) ----------------------------------------------------------------
+// @Note(Victor): The text catalogs never change, so the first time we parse one we write its columns
+// next to it as "<source>.gcat" and from then on we just map that file and point the catalog columns
+// into it. No parsing and no copying, the page cache does the rest.
+//
+// Layout: GcatHeader, then one column per field at the offsets in the header, every column aligned to
+// GCAT_ALIGNMENT. Native byte order (little endian on everything we run on). The columns are f64, or
+// the fixed point i32 positions of a compact catalog (GALAXY_COMPACT), the cache is stored like the
+// catalog it was written from.
+//
+// The cache is rebuilt when the size or modification time of the source differ from the ones in the
+// header. With GALAXY_VERIFY_CACHE the source is also hashed and compared, for when a file is copied
+// over with its old timestamp.
+//
+// A .gcat without a source (no stamps, e.g. from generate_catalog) can be loaded directly as a catalog.
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const u32 GCAT_MAGIC = 0x54414347; // "GCAT"
+const u32 GCAT_VERSION = 2; // 2: the redshift catalog is read by column, older caches of it are wrong
+const u64 GCAT_ALIGNMENT = 64;
+const u64 GCAT_HASH_CHUNK_SIZE = Megabytes(1);
+
+enum Gcat_Field_Type
+{
+    GCAT_FIELD_F64 = 1,
+    GCAT_FIELD_FIXED32 = 2, // i32 in CATALOG_FIXED_STEP arc minutes
+};
+
+struct GcatField
+{
+    u32 Id;   // Catalog_Field
+    u32 Type; // Gcat_Field_Type
+    u64 Offset;
+};
+
+struct GcatHeader
+{
+    u32 Magic;
+    u32 Version;
+
+    u64 Count;
+    u64 FileSize;
+
+    // What the cache was built from
+    u64 SourceSize;
+    i64 SourceModifiedTime; // Nanoseconds since the epoch
+    u64 SourceHash;
+
+    u32 FieldCount;
+    u32 Reserved;
+    GcatField Fields[CATALOG_FIELD_COUNT];
+};
+
+// @Note(Victor): Set with GALAXY_VERIFY_CACHE
+global_variable bool VerifyCatalogCache = false;
+
+internal bool
+GetFileStamp(const char *FileName, u64 *Size, i64 *ModifiedTime)
+{
+    struct stat FileStat;
+    if (stat(FileName, &FileStat) != 0)
+    {
+        return (false);
+    }
+
+    *Size = (u64)FileStat.st_size;
+
+#if defined(__linux__)
+    *ModifiedTime = (i64)FileStat.st_mtim.tv_sec * 1000000000LL + FileStat.st_mtim.tv_nsec;
+#elif defined(__APPLE__)
+    *ModifiedTime = (i64)FileStat.st_mtimespec.tv_sec * 1000000000LL + FileStat.st_mtimespec.tv_nsec;
+#else
+    *ModifiedTime = (i64)FileStat.st_mtime * 1000000000LL;
+#endif
+
+    return (true);
+}
+
+// @Note(Victor): 64 bit multiply/xor hash over fixed size chunks hashed in parallel, then the chunk
+// hashes are combined in order. Not cryptographic, it only has to notice that the file changed.
+internal u64
+HashBytes(const char *Data, u64 Size, u64 Seed)
+{
+    const u64 Multiplier = 0x9E3779B97F4A7C15ULL;
+
+    u64 Hash = Seed ^ (Size * Multiplier);
+    u64 At = 0;
+    for (; At + 8 <= Size; At += 8)
+    {
+        u64 Word;
+        memcpy(&Word, Data + At, sizeof(Word));
+        Hash = (Hash ^ Word) * Multiplier;
+        Hash ^= Hash >> 29;
+    }
+
+    for (; At < Size; ++At)
+    {
+        Hash = (Hash ^ (u8)Data[At]) * Multiplier;
+    }
+
+    return Hash ^ (Hash >> 32);
+}
+
+internal bool
+HashFile(const char *FileName, u64 *Hash)
+{
+    MappedFile File;
+    if (!MapFile(FileName, &File))
+    {
+        return (false);
+    }
+
+    u64 ChunkCount = (File.Size + GCAT_HASH_CHUNK_SIZE - 1) / GCAT_HASH_CHUNK_SIZE;
+    u64 *ChunkHashes = (u64 *)calloc(ChunkCount + 1, sizeof(u64));
+
+    ParallelFor(ChunkCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Chunk = Begin; Chunk < End; ++Chunk)
+        {
+            u64 ChunkBegin = Chunk * GCAT_HASH_CHUNK_SIZE;
+            u64 ChunkSize = File.Size - ChunkBegin < GCAT_HASH_CHUNK_SIZE ? File.Size - ChunkBegin : GCAT_HASH_CHUNK_SIZE;
+            ChunkHashes[Chunk] = HashBytes(File.Data + ChunkBegin, ChunkSize, Chunk);
+        } });
+
+    *Hash = HashBytes((const char *)ChunkHashes, ChunkCount * sizeof(u64), File.Size);
+
+    free(ChunkHashes);
+    UnmapFile(&File);
+
+    return (true);
+}
+
+internal void
+GetCatalogCacheFileName(const char *SourceFileName, char *Buffer, usize BufferSize)
+{
+    snprintf(Buffer, BufferSize, "%s.gcat", SourceFileName);
+}
+
+// @Note(Victor): Points the columns of Result into the mapped .gcat file CacheFileName. When it is the cache
+// of SourceFileName it also has to be up to date with it, a standalone .gcat (SourceFileName nullptr,
+// e.g. from generate_catalog) is taken as is.
+internal bool
+MapGcatFile(const char *CacheFileName, const char *SourceFileName, Catalog *Result)
+{
+    u64 SourceSize = 0;
+    i64 SourceModifiedTime = 0;
+    if (SourceFileName && !GetFileStamp(SourceFileName, &SourceSize, &SourceModifiedTime))
+    {
+        return (false);
+    }
+
+    MappedFile File;
+    if (!MapFile(CacheFileName, &File))
+    {
+        return (false);
+    }
+
+    GcatHeader Header = {};
+    bool IsValid = File.Size >= sizeof(GcatHeader);
+    if (IsValid)
+    {
+        memcpy(&Header, File.Data, sizeof(GcatHeader));
+
+        IsValid = Header.Magic == GCAT_MAGIC &&
+                  Header.Version == GCAT_VERSION &&
+                  Header.FileSize == File.Size &&
+                  Header.FieldCount <= CATALOG_FIELD_COUNT;
+    }
+
+    if (IsValid && SourceFileName && (Header.SourceSize != SourceSize || Header.SourceModifiedTime != SourceModifiedTime))
+    {
+        printf("\t%s changed since %s was written\n", SourceFileName, CacheFileName);
+        IsValid = false;
+    }
+
+    if (IsValid && SourceFileName && VerifyCatalogCache)
+    {
+        u64 SourceHash = 0;
+        IsValid = HashFile(SourceFileName, &SourceHash) && SourceHash == Header.SourceHash;
+        if (!IsValid)
+        {
+            printf("\tThe contents of %s don't match %s\n", SourceFileName, CacheFileName);
+        }
+    }
+
+    *Result = {};
+    for (u32 i = 0; IsValid && i < Header.FieldCount; ++i)
+    {
+        GcatField Field = Header.Fields[i];
+
+        void **Column = nullptr;
+        u64 ElementSize = 0;
+        if (Field.Type == GCAT_FIELD_F64)
+        {
+            Column = (void **)GetCatalogColumn(Result, (Catalog_Field)Field.Id);
+            ElementSize = sizeof(f64);
+        }
+        else if (Field.Type == GCAT_FIELD_FIXED32)
+        {
+            Column = (void **)GetCatalogFixedColumn(Result, (Catalog_Field)Field.Id);
+            ElementSize = sizeof(i32);
+        }
+
+        IsValid = Column != nullptr &&
+                  Field.Offset % GCAT_ALIGNMENT == 0 &&
+                  Field.Offset + Header.Count * ElementSize <= File.Size;
+
+        if (IsValid)
+        {
+            // @Note(Victor): Read only, the mapping is PROT_READ
+            *Column = (void *)(File.Data + Field.Offset);
+        }
+    }
+
+    // Both positions, and both in the same storage
+    IsValid = IsValid && HasCatalogPositions(Result) && (Result->RightAscension == nullptr || Result->RightAscensionFixed == nullptr);
+    if (!IsValid)
+    {
+        *Result = {};
+        UnmapFile(&File);
+        return (false);
+    }
+
+    Result->Count = Header.Count;
+    Result->Capacity = Header.Count;
+    Result->SourceSize = Header.SourceSize;
+    Result->Cache = File;
+
+    return (true);
+}
+
+// Points the columns of Result into the cache of SourceFileName, if there is an up to date one
+internal bool
+MapCatalogCache(const char *SourceFileName, Catalog *Result)
+{
+    char CacheFileName[1024];
+    GetCatalogCacheFileName(SourceFileName, CacheFileName, sizeof(CacheFileName));
+
+    return MapGcatFile(CacheFileName, SourceFileName, Result);
+}
+
+// Writes the columns of Source to CacheFileName, through a temporary file so a crash halfway never
+// leaves a cache behind that looks valid. Source stamps the cache with its source file, if any.
+internal bool
+WriteGcatFile(const char *CacheFileName, const Catalog *Source, const GcatHeader *Stamp)
+{
+    char TemporaryFileName[1040];
+    snprintf(TemporaryFileName, sizeof(TemporaryFileName), "%s.tmp", CacheFileName);
+
+    GcatHeader Header = {};
+    Header.Magic = GCAT_MAGIC;
+    Header.Version = GCAT_VERSION;
+    Header.Count = Source->Count;
+
+    if (Stamp)
+    {
+        Header.SourceSize = Stamp->SourceSize;
+        Header.SourceModifiedTime = Stamp->SourceModifiedTime;
+        Header.SourceHash = Stamp->SourceHash;
+    }
+
+    bool IsCompact = IsCatalogCompact(Source);
+    const void *Columns[CATALOG_FIELD_COUNT] = {};
+    Columns[CATALOG_FIELD_RIGHT_ASCENSION] = IsCompact ? (const void *)Source->RightAscensionFixed : (const void *)Source->RightAscension;
+    Columns[CATALOG_FIELD_DECLINATION] = IsCompact ? (const void *)Source->DeclinationFixed : (const void *)Source->Declination;
+    Columns[CATALOG_FIELD_REDSHIFT] = Source->Redshift;
+
+    u64 ColumnSizes[CATALOG_FIELD_COUNT] = {};
+    u64 Offset = (sizeof(GcatHeader) + GCAT_ALIGNMENT - 1) & ~(GCAT_ALIGNMENT - 1);
+    for (u32 Id = 0; Id < CATALOG_FIELD_COUNT; ++Id)
+    {
+        if (Columns[Id])
+        {
+            bool IsFixed = IsCompact && Id != CATALOG_FIELD_REDSHIFT;
+            ColumnSizes[Id] = Source->Count * (IsFixed ? sizeof(i32) : sizeof(f64));
+
+            GcatField *Field = &Header.Fields[Header.FieldCount++];
+            Field->Id = Id;
+            Field->Type = IsFixed ? GCAT_FIELD_FIXED32 : GCAT_FIELD_F64;
+            Field->Offset = Offset;
+
+            Offset = (Offset + ColumnSizes[Id] + GCAT_ALIGNMENT - 1) & ~(GCAT_ALIGNMENT - 1);
+        }
+    }
+    Header.FileSize = Offset;
+
+    FILE *f = fopen(TemporaryFileName, "wb");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    bool Success = fwrite(&Header, sizeof(Header), 1, f) == 1;
+
+    const u8 Padding[GCAT_ALIGNMENT] = {};
+    u64 Written = sizeof(Header);
+    for (u32 i = 0; Success && i < Header.FieldCount; ++i)
+    {
+        const GcatField *Field = &Header.Fields[i];
+        u64 ColumnSize = ColumnSizes[Field->Id];
+        Success = fwrite(Padding, 1, Field->Offset - Written, f) == Field->Offset - Written &&
+                  fwrite(Columns[Field->Id], 1, ColumnSize, f) == ColumnSize;
+        Written = Field->Offset + ColumnSize;
+    }
+
+    Success = Success && fwrite(Padding, 1, Header.FileSize - Written, f) == Header.FileSize - Written;
+    Success = (fclose(f) == 0) && Success;
+
+#ifdef _WIN32
+    remove(CacheFileName);
+#endif
+    Success = Success && rename(TemporaryFileName, CacheFileName) == 0;
+    if (!Success)
+    {
+        remove(TemporaryFileName);
+    }
+
+    return (Success);
+}
+
+// @Note(Victor): Whether the cache can go next to SourceFileName. A read only data directory is left alone
+// before the source is hashed, not after.
+internal bool
+CanWriteCatalogCache(const char *SourceFileName)
+{
+    char Directory[1024];
+    snprintf(Directory, sizeof(Directory), "%s", SourceFileName);
+
+    char *Slash = strrchr(Directory, '/');
+#ifdef _WIN32
+    char *Backslash = strrchr(Directory, '\\');
+    Slash = Backslash > Slash ? Backslash : Slash;
+#endif
+    if (Slash)
+    {
+        // "/catalog.txt" is in the root directory
+        Slash[Slash == Directory ? 1 : 0] = 0;
+    }
+    else
+    {
+        snprintf(Directory, sizeof(Directory), ".");
+    }
+
+#ifdef _WIN32
+    return _access(Directory, 2) == 0;
+#else
+    return access(Directory, W_OK) == 0;
+#endif
+}
+
+// Writes the columns of Source to "<SourceFileName>.gcat"
+internal bool
+WriteCatalogCache(const char *SourceFileName, const Catalog *Source)
+{
+    char CacheFileName[1024];
+    GetCatalogCacheFileName(SourceFileName, CacheFileName, sizeof(CacheFileName));
+
+    GcatHeader Stamp = {};
+    if (!GetFileStamp(SourceFileName, &Stamp.SourceSize, &Stamp.SourceModifiedTime) ||
+        !HashFile(SourceFileName, &Stamp.SourceHash))
+    {
+        return (false);
+    }
+
+    // @Note(Victor): Lines were appended while (or before) it was read, a cache stamped with the bigger
+    // file would be taken for all of it on the next run
+    if (Stamp.SourceSize != Source->SourceSize)
+    {
+        printf("\t%s has more than the %lu bytes that were read\n", SourceFileName, (unsigned long)Source->SourceSize);
+        return (false);
+    }
+
+    return WriteGcatFile(CacheFileName, Source, &Stamp);
+}
+
+typedef bool CatalogReader(const char *FileName, Catalog *Result);
+
+// How many galaxies a Reader will find in the file, without parsing them
+typedef bool CatalogCounter(const char *FileName, u64 *Count);
+
+// @Note(Victor): Maps the cache of SourceFileName if it is up to date. Otherwise asks Counter how big the
+// catalog is, parses the source with Reader into a catalog of that size on Arena and, with WriteCache, writes
+// the cache for the next run. Tools that only read a catalog pass false, so they leave nothing next to it.
+internal bool
+LoadCatalog(const char *SourceFileName, CatalogReader *Reader, CatalogCounter *Counter, bool HasRedshift, bool WriteCache,
+            MemoryArena *Arena, Catalog *Result)
+{
+    // A .gcat on its own, there is no text to parse
+    usize NameLength = strlen(SourceFileName);
+    if (NameLength > 5 && strcmp(SourceFileName + NameLength - 5, ".gcat") == 0)
+    {
+        if (!MapGcatFile(SourceFileName, nullptr, Result))
+        {
+            printf("\tCould not map %s\n", SourceFileName);
+            return (false);
+        }
+
+        printf("\tMapped %lu data points from %s\n", (unsigned long)Result->Count, SourceFileName);
+        return (true);
+    }
+
+    // @Note(Victor): A cache written in the other storage is read again, otherwise GALAXY_COMPACT would
+    // keep mapping the f64 columns of the last run that was not compact
+    bool IsCompact = CompactCatalogs && !HasRedshift;
+    if (MapCatalogCache(SourceFileName, Result))
+    {
+        if (IsCatalogCompact(Result) == IsCompact)
+        {
+            printf("\tMapped %lu data points from the cache of %s\n", (unsigned long)Result->Count, SourceFileName);
+            return (true);
+        }
+
+        printf("\tThe cache of %s is %s, reading it again\n", SourceFileName, IsCompact ? "not compact" : "compact");
+        FreeCatalog(Result);
+    }
+
+    u64 Capacity = 0;
+    if (!Counter(SourceFileName, &Capacity))
+    {
+        printf("\tCould not tell how many data points %s has\n", SourceFileName);
+        return (false);
+    }
+
+    ArenaMark Mark = GetArenaMark(Arena);
+    bool Allocated = IsCompact ? AllocateCompactCatalog(Result, Arena, Capacity) : AllocateCatalog(Result, Arena, Capacity, HasRedshift);
+    if (!Allocated)
+    {
+        printf("\tNo memory for the %lu data points of %s\n", (unsigned long)Capacity, SourceFileName);
+        return (false);
+    }
+
+    if (!Reader(SourceFileName, Result))
+    {
+        // Nothing of the failed read stays on the arena
+        FreeCatalog(Result);
+        PopArenaToMark(Arena, Mark);
+        return (false);
+    }
+
+    if (WriteCache)
+    {
+        if (!CanWriteCatalogCache(SourceFileName))
+        {
+            printf("\tNot writing the catalog cache of %s, its directory is read only\n", SourceFileName);
+        }
+        else if (WriteCatalogCache(SourceFileName, Result))
+        {
+            printf("\tWrote the catalog cache of %s\n", SourceFileName);
+        }
+        else
+        {
+            // @Note(Victor): Not fatal, we just parse again next time
+            printf("\tCould not write the catalog cache of %s\n", SourceFileName);
+        }
+    }
+
+    return (true);
+}
@@ -0,0 +1,250 @@
+// Random catalogs ---------------------------------------------------------------
+// @Note(Victor): The uniform catalog to compare the real galaxies against, generated in memory instead
+// of read from flat_100k_arcmin.txt (or written to a file by generate_catalog).
+//
+// Galaxy i depends only on the seed and on i. Its random numbers are a hash of (Seed, i, draw), a counter
+// based generator with the SplitMix64 finalizer, so the catalog is the same for any thread count and block size.
+//
+// The galaxies are uniform in area: RA is uniform and so is sin(Dec). The flat file is uniform in Dec
+// instead, which puts too many galaxies near the pole.
+// - RANDOM_CATALOG_BOUNDS keeps them inside the RA/Dec bounds of a reference catalog.
+// - RANDOM_CATALOG_FOOTPRINT also redraws every galaxy (with the next draws of the same counter) until it
+//   lands in a cell of the sky the reference has galaxies in.
+
+enum Random_Catalog_Region
+{
+    RANDOM_CATALOG_SPHERE,
+    RANDOM_CATALOG_BOUNDS,
+    RANDOM_CATALOG_FOOTPRINT,
+};
+
+global_variable const char *RandomCatalogRegionNames[] = {"sphere", "bounds", "footprint"};
+
+// Footprint cells, equal area: 1 degree of RA by 1/90 of sin(Dec)
+const u32 RANDOM_FOOTPRINT_RA_CELLS = 360;
+const u32 RANDOM_FOOTPRINT_DEC_CELLS = 180;
+const u32 RANDOM_FOOTPRINT_MAX_TRIES = 1024; // Then the galaxy stays where it is, so a bad footprint can't hang us
+
+const u64 RANDOM_CATALOG_BLOCK_SIZE = 65536;
+const u64 RANDOM_CATALOG_DEFAULT_SEED = 0x6A09E667F3BCC908ULL;
+
+const f64 ARCMIN_PER_RADIAN = 180.0 * 60.0 / 3.14159265358979323846;
+
+struct RandomCatalogOptions
+{
+    Random_Catalog_Region Region;
+    u64 Count; // 0 for as many as the reference has
+    u64 Seed;
+
+    const Catalog *Reference; // For the bounds and the footprint
+};
+
+// Where the galaxies may go, in arc minutes like the catalogs
+struct RandomCatalogFootprint
+{
+    f64 MinRightAscension;
+    f64 MaxRightAscension;
+    f64 MinSinDeclination;
+    f64 MaxSinDeclination;
+
+    bool HasCells;
+    u8 Cells[RANDOM_FOOTPRINT_DEC_CELLS][RANDOM_FOOTPRINT_RA_CELLS]; // 1 where the reference has galaxies
+};
+
+internal inline u64
+MixRandomBits(u64 Value)
+{
+    Value = (Value ^ (Value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    Value = (Value ^ (Value >> 27)) * 0x94D049BB133111EBULL;
+    return Value ^ (Value >> 31);
+}
+
+// Draw number Draw of galaxy Index, in [0, 1)
+internal inline f64
+GetRandomUnit(u64 Seed, u64 Index, u64 Draw)
+{
+    u64 Key = MixRandomBits(Seed + (Index + 1) * 0x9E3779B97F4A7C15ULL);
+    u64 Bits = MixRandomBits(Key + (Draw + 1) * 0xD1B54A32D192ED03ULL);
+
+    return (f64)(Bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+internal u32
+GetFootprintCell(f64 RightAscension, f64 SinDeclination, u32 *DecCell)
+{
+    f64 Ra = fmod(RightAscension, 360.0 * 60.0);
+    Ra = Ra < 0.0 ? Ra + 360.0 * 60.0 : Ra;
+
+    u32 RaCell = (u32)(Ra * (RANDOM_FOOTPRINT_RA_CELLS / (360.0 * 60.0)));
+    u32 Dec = (u32)((SinDeclination + 1.0) * 0.5 * RANDOM_FOOTPRINT_DEC_CELLS);
+
+    *DecCell = Dec < RANDOM_FOOTPRINT_DEC_CELLS ? Dec : RANDOM_FOOTPRINT_DEC_CELLS - 1;
+    return RaCell < RANDOM_FOOTPRINT_RA_CELLS ? RaCell : RANDOM_FOOTPRINT_RA_CELLS - 1;
+}
+
+internal void
+GetSphereFootprint(RandomCatalogFootprint *Result)
+{
+    Result->MinRightAscension = 0.0;
+    Result->MaxRightAscension = 360.0 * 60.0;
+    Result->MinSinDeclination = -1.0;
+    Result->MaxSinDeclination = 1.0;
+    Result->HasCells = false;
+}
+
+// @Note(Victor): The bounds of Reference, and with RANDOM_CATALOG_FOOTPRINT the cells it has galaxies in.
+// Every thread marks its own cells, they are merged at the end.
+internal void
+GetReferenceFootprint(const Catalog *Reference, Random_Catalog_Region Region, RandomCatalogFootprint *Result)
+{
+    u32 ThreadCount = GetThreadCount();
+    u64 CellCount = RANDOM_FOOTPRINT_DEC_CELLS * RANDOM_FOOTPRINT_RA_CELLS;
+
+    f64 *Bounds = (f64 *)calloc(ThreadCount * 4, sizeof(f64));
+    u8 *ThreadCells = Region == RANDOM_CATALOG_FOOTPRINT ? (u8 *)calloc(ThreadCount, CellCount) : nullptr;
+    for (u32 Thread = 0; Thread < ThreadCount; ++Thread)
+    {
+        Bounds[Thread * 4 + 0] = INFINITY;
+        Bounds[Thread * 4 + 1] = -INFINITY;
+        Bounds[Thread * 4 + 2] = INFINITY;
+        Bounds[Thread * 4 + 3] = -INFINITY;
+    }
+
+    ParallelFor(Reference->Count, RANDOM_CATALOG_BLOCK_SIZE, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        f64 *ThreadBounds = &Bounds[ThreadIndex * 4];
+        for (u64 i = Begin; i < End; ++i)
+        {
+            f64 Ra = GetCatalogRightAscension(Reference, i);
+            f64 SinDec = sin(GetCatalogDeclination(Reference, i) / ARCMIN_PER_RADIAN);
+
+            ThreadBounds[0] = Ra < ThreadBounds[0] ? Ra : ThreadBounds[0];
+            ThreadBounds[1] = Ra > ThreadBounds[1] ? Ra : ThreadBounds[1];
+            ThreadBounds[2] = SinDec < ThreadBounds[2] ? SinDec : ThreadBounds[2];
+            ThreadBounds[3] = SinDec > ThreadBounds[3] ? SinDec : ThreadBounds[3];
+
+            if (ThreadCells)
+            {
+                u32 DecCell = 0;
+                u32 RaCell = GetFootprintCell(Ra, SinDec, &DecCell);
+                ThreadCells[ThreadIndex * CellCount + DecCell * RANDOM_FOOTPRINT_RA_CELLS + RaCell] = 1;
+            }
+        } });
+
+    GetSphereFootprint(Result);
+    Result->MinRightAscension = INFINITY;
+    Result->MaxRightAscension = -INFINITY;
+    Result->MinSinDeclination = INFINITY;
+    Result->MaxSinDeclination = -INFINITY;
+    for (u32 Thread = 0; Thread < ThreadCount; ++Thread)
+    {
+        Result->MinRightAscension = fmin(Result->MinRightAscension, Bounds[Thread * 4 + 0]);
+        Result->MaxRightAscension = fmax(Result->MaxRightAscension, Bounds[Thread * 4 + 1]);
+        Result->MinSinDeclination = fmin(Result->MinSinDeclination, Bounds[Thread * 4 + 2]);
+        Result->MaxSinDeclination = fmax(Result->MaxSinDeclination, Bounds[Thread * 4 + 3]);
+    }
+
+    if (ThreadCells)
+    {
+        memset(Result->Cells, 0, sizeof(Result->Cells));
+        for (u32 Thread = 0; Thread < ThreadCount; ++Thread)
+        {
+            for (u64 Cell = 0; Cell < CellCount; ++Cell)
+            {
+                (&Result->Cells[0][0])[Cell] |= ThreadCells[Thread * CellCount + Cell];
+            }
+        }
+        Result->HasCells = true;
+    }
+
+    free(Bounds);
+    free(ThreadCells);
+}
+
+// @Note(Victor): Fills the first Count galaxies of Result, which needs room for them. RA and Dec in arc minutes,
+// quantized when Result is compact.
+internal void
+GenerateRandomGalaxies(Catalog *Result, u64 Count, u64 Seed, const RandomCatalogFootprint *Footprint)
+{
+    Assert(Count <= Result->Capacity);
+
+    f64 RaScale = Footprint->MaxRightAscension - Footprint->MinRightAscension;
+    f64 SinDecScale = Footprint->MaxSinDeclination - Footprint->MinSinDeclination;
+
+    ParallelFor(Count, RANDOM_CATALOG_BLOCK_SIZE, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            f64 Ra = 0.0;
+            f64 SinDec = 0.0;
+            for (u32 Try = 0; Try < RANDOM_FOOTPRINT_MAX_TRIES; ++Try)
+            {
+                Ra = Footprint->MinRightAscension + RaScale * GetRandomUnit(Seed, i, 2 * Try);
+                SinDec = Footprint->MinSinDeclination + SinDecScale * GetRandomUnit(Seed, i, 2 * Try + 1);
+
+                u32 DecCell = 0;
+                u32 RaCell = Footprint->HasCells ? GetFootprintCell(Ra, SinDec, &DecCell) : 0;
+                if (!Footprint->HasCells || Footprint->Cells[DecCell][RaCell])
+                {
+                    break;
+                }
+            }
+
+            SetCatalogPosition(Result, i, Ra, asin(SinDec) * ARCMIN_PER_RADIAN);
+        } });
+
+    Result->Count = Count;
+}
+
+// Allocates Result on Arena and generates the catalog Options asks for
+internal bool
+LoadRandomCatalog(const RandomCatalogOptions *Options, MemoryArena *Arena, Catalog *Result)
+{
+    f64 StartTime = GetWallClockSeconds();
+
+    Random_Catalog_Region Region = Options->Region;
+    const Catalog *Reference = Options->Reference;
+    if (Region != RANDOM_CATALOG_SPHERE && (Reference == nullptr || Reference->Count == 0))
+    {
+        printf("\tNo reference catalog for the %s of the random catalog, using the whole sphere\n", RandomCatalogRegionNames[Region]);
+        Region = RANDOM_CATALOG_SPHERE;
+    }
+
+    u64 Count = Options->Count;
+    if (Count == 0)
+    {
+        if (Reference == nullptr || Reference->Count == 0)
+        {
+            printf("\tNo size for the random catalog, and no reference catalog to take it from\n");
+            return (false);
+        }
+
+        Count = Reference->Count;
+    }
+
+    RandomCatalogFootprint *Footprint = (RandomCatalogFootprint *)calloc(1, sizeof(RandomCatalogFootprint));
+    if (Region == RANDOM_CATALOG_SPHERE)
+    {
+        GetSphereFootprint(Footprint);
+    }
+    else
+    {
+        GetReferenceFootprint(Reference, Region, Footprint);
+    }
+
+    bool Allocated = CompactCatalogs ? AllocateCompactCatalog(Result, Arena, Count) : AllocateCatalog(Result, Arena, Count, false);
+    if (!Allocated)
+    {
+        printf("\tNo memory for %lu random galaxies\n", (unsigned long)Count);
+        free(Footprint);
+        return (false);
+    }
+    GenerateRandomGalaxies(Result, Count, Options->Seed, Footprint);
+
+    free(Footprint);
+
+    printf("\tGenerated %lu random galaxies (%s, seed %lu) in %.3f s\n", (unsigned long)Count,
+           RandomCatalogRegionNames[Region], (unsigned long)Options->Seed, GetWallClockSeconds() - StartTime);
+
+    return (true);
+}
@@ -0,0 +1,403 @@
+// Catalog loading ------------------------------------------------------------------
+// @Note(Victor): The arcmin catalogs are a count on the first line followed by one
+// "right_ascension\tdeclination" line per galaxy. The file is memory mapped, cut into newline aligned
+// chunks and every chunk is parsed on its own thread with std::from_chars, straight out of the mapping.
+// One pass counts the lines of every chunk so each chunk knows where its galaxies go in the output.
+//
+// A catalog can grow while it is watched (GALAXY_WATCH): lines are appended after the count ones and the
+// count is not updated. Only ReadWatchedInputDataFromFile accepts those, it leaves them to ReadCatalogTail,
+// which picks up at Catalog.SourceSize. Everywhere else the header has to match the lines.
+
+#include <charconv>
+
+// @Note(Victor): Chunks per thread, more than one so a slow chunk doesn't hold everybody up
+const u64 CATALOG_CHUNKS_PER_THREAD = 8;
+const u64 CATALOG_MIN_CHUNK_SIZE = Kilobytes(64);
+const u64 CATALOG_TAIL_READ_SIZE = Megabytes(4); // Per ReadCatalogTail, about 200k appended lines
+
+// 64 bit offsets into the catalogs that are bigger than 2 GB
+#if PLATFORM_HAS_MMAP
+#define SeekCatalogFile(File, Offset, Origin) fseeko((File), (off_t)(Offset), (Origin))
+#define TellCatalogFile(File) ftello(File)
+#else
+#define SeekCatalogFile(File, Offset, Origin) _fseeki64((File), (i64)(Offset), (Origin))
+#define TellCatalogFile(File) _ftelli64(File)
+#endif
+
+internal inline bool
+IsCatalogWhitespace(char Character)
+{
+    return Character == ' ' || Character == '\t' || Character == '\r';
+}
+
+// @Note(Victor): Blank lines (the last one usually is) are not galaxies
+internal bool
+IsBlankLine(const char *Begin, const char *End)
+{
+    for (const char *At = Begin; At < End; ++At)
+    {
+        if (!IsCatalogWhitespace(*At))
+        {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+internal u64
+CountCatalogLines(const char *Begin, const char *End)
+{
+    u64 LineCount = 0;
+    while (Begin < End)
+    {
+        const char *LineEnd = (const char *)memchr(Begin, '\n', End - Begin);
+        LineEnd = LineEnd ? LineEnd : End;
+
+        LineCount += IsBlankLine(Begin, LineEnd) ? 0 : 1;
+        Begin = LineEnd + 1;
+    }
+
+    return LineCount;
+}
+
+internal const char *
+SkipCatalogWhitespace(const char *At, const char *End)
+{
+    while (At < End && IsCatalogWhitespace(*At))
+    {
+        At++;
+    }
+
+    return At;
+}
+
+// Parses "right_ascension declination" (tabs or spaces), returns false on anything else
+internal bool
+ParseCatalogLine(const char *Begin, const char *End, f64 *RightAscension, f64 *Declination)
+{
+    const char *At = SkipCatalogWhitespace(Begin, End);
+    std::from_chars_result Result = std::from_chars(At, End, *RightAscension);
+    if (Result.ec != std::errc())
+    {
+        return (false);
+    }
+
+    At = SkipCatalogWhitespace(Result.ptr, End);
+    Result = std::from_chars(At, End, *Declination);
+    if (Result.ec != std::errc())
+    {
+        return (false);
+    }
+
+    return SkipCatalogWhitespace(Result.ptr, End) == End;
+}
+
+internal bool
+ParseCatalogHeader(const char *Begin, const char *End, u64 *DeclaredCount)
+{
+    const char *At = SkipCatalogWhitespace(Begin, End);
+    std::from_chars_result Result = std::from_chars(At, End, *DeclaredCount);
+
+    return Result.ec == std::errc() && SkipCatalogWhitespace(Result.ptr, End) == End;
+}
+
+// @Note(Victor): Only the count on the first line, for sizing a catalog before reading it
+internal bool
+ReadCatalogDeclaredCount(const char *FileName, u64 *DeclaredCount)
+{
+    FILE *f = fopen(FileName, "r");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    char Line[256];
+    bool Success = fgets(Line, sizeof(Line), f) != NULL;
+    fclose(f);
+
+    if (Success)
+    {
+        char *LineEnd = (char *)memchr(Line, '\n', sizeof(Line));
+        LineEnd = LineEnd ? LineEnd : Line + strlen(Line);
+        Success = ParseCatalogHeader(Line, LineEnd, DeclaredCount);
+    }
+
+    return (Success);
+}
+
+// @Note(Victor): Cuts [Begin, End) into chunks that start right after a newline, ChunkCount + 1 boundaries
+// (the last one is End). Free them with free().
+internal const char **
+SplitIntoLineChunks(const char *Begin, const char *End, u64 *ChunkCount)
+{
+    u64 Size = End - Begin;
+
+    u64 Count = GetThreadCount() * CATALOG_CHUNKS_PER_THREAD;
+    if (Size / Count < CATALOG_MIN_CHUNK_SIZE)
+    {
+        Count = Size / CATALOG_MIN_CHUNK_SIZE + 1;
+    }
+
+    const char **ChunkBegin = (const char **)calloc(Count + 1, sizeof(const char *));
+
+    ChunkBegin[0] = Begin;
+    for (u64 Chunk = 1; Chunk < Count; ++Chunk)
+    {
+        const char *Split = Begin + (Size * Chunk) / Count;
+        Split = Split < ChunkBegin[Chunk - 1] ? ChunkBegin[Chunk - 1] : Split;
+
+        const char *Newline = (const char *)memchr(Split, '\n', End - Split);
+        ChunkBegin[Chunk] = Newline ? Newline + 1 : End;
+    }
+    ChunkBegin[Count] = End;
+
+    *ChunkCount = Count;
+    return ChunkBegin;
+}
+
+// Reads an arcmin catalog into the (allocated) columns of Result, up to its capacity. With AllowAppendedLines
+// the lines after the declared ones are not an error, they are left after Result->SourceSize.
+internal bool
+ReadArcminCatalog(const char *FileName, Catalog *Result, bool AllowAppendedLines)
+{
+    Result->Count = 0;
+
+    MappedFile File;
+    if (!MapFile(FileName, &File))
+    {
+        printf("Error opening file: %s\n", FileName);
+        return (false);
+    }
+
+    const char *FileEnd = File.Data + File.Size;
+    const char *HeaderEnd = File.Data ? (const char *)memchr(File.Data, '\n', File.Size) : nullptr;
+    if (HeaderEnd == nullptr)
+    {
+        printf("Error reading header of %s!\n", FileName);
+        UnmapFile(&File);
+        return (false);
+    }
+
+    u64 DeclaredCount = 0;
+    if (!ParseCatalogHeader(File.Data, HeaderEnd, &DeclaredCount))
+    {
+        printf("Error parsing header of %s, expected the number of data points\n", FileName);
+        UnmapFile(&File);
+        return (false);
+    }
+
+    if (DeclaredCount > Result->Capacity)
+    {
+        printf("Error: %s has %lu data points, there is only room for %lu\n", FileName,
+               (unsigned long)DeclaredCount, (unsigned long)Result->Capacity);
+        UnmapFile(&File);
+        return (false);
+    }
+
+    u64 ChunkCount = 0;
+    const char **ChunkBegin = SplitIntoLineChunks(HeaderEnd + 1, FileEnd, &ChunkCount);
+    u64 *ChunkFirstLine = (u64 *)calloc(ChunkCount + 1, sizeof(u64));
+
+    // Pass 1: how many galaxies every chunk has
+    ParallelFor(ChunkCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Chunk = Begin; Chunk < End; ++Chunk)
+        {
+            ChunkFirstLine[Chunk + 1] = CountCatalogLines(ChunkBegin[Chunk], ChunkBegin[Chunk + 1]);
+        } });
+
+    for (u64 Chunk = 0; Chunk < ChunkCount; ++Chunk)
+    {
+        ChunkFirstLine[Chunk + 1] += ChunkFirstLine[Chunk];
+    }
+
+    u64 LineCount = ChunkFirstLine[ChunkCount];
+    bool Success = true;
+
+    if (LineCount < DeclaredCount || (LineCount > DeclaredCount && !AllowAppendedLines))
+    {
+        printf("Error: the header of %s says %lu data points but there are %lu\n", FileName,
+               (unsigned long)DeclaredCount, (unsigned long)LineCount);
+        Success = false;
+    }
+    else if (LineCount > DeclaredCount)
+    {
+        printf("\t%s has %lu data points after the %lu of its header, they are read as appended\n", FileName,
+               (unsigned long)(LineCount - DeclaredCount), (unsigned long)DeclaredCount);
+    }
+
+    // Where the lines after the declared ones start, set by the chunk with the last declared line
+    u64 TailBegin = DeclaredCount == 0 ? (u64)(HeaderEnd + 1 - File.Data) : File.Size;
+
+    // Pass 2: parse every chunk straight into its slice of the output
+    if (Success)
+    {
+        std::atomic<u64> FirstBadLine{~0ULL};
+
+        ParallelFor(ChunkCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                    {
+            for (u64 Chunk = Begin; Chunk < End; ++Chunk)
+            {
+                const char *At = ChunkBegin[Chunk];
+                const char *ChunkEnd = ChunkBegin[Chunk + 1];
+                u64 Line = ChunkFirstLine[Chunk];
+
+                while (At < ChunkEnd && Line < DeclaredCount)
+                {
+                    const char *LineEnd = (const char *)memchr(At, '\n', ChunkEnd - At);
+                    LineEnd = LineEnd ? LineEnd : ChunkEnd;
+
+                    if (!IsBlankLine(At, LineEnd))
+                    {
+                        f64 RightAscension, Declination;
+                        if (!ParseCatalogLine(At, LineEnd, &RightAscension, &Declination))
+                        {
+                            u64 Expected = FirstBadLine.load();
+                            while (Line < Expected && !FirstBadLine.compare_exchange_weak(Expected, Line))
+                            {
+                            }
+                            break;
+                        }
+
+                        SetCatalogPosition(Result, Line, RightAscension, Declination);
+                        Line++;
+                        if (Line == DeclaredCount && LineCount > DeclaredCount)
+                        {
+                            TailBegin = (u64)(LineEnd + 1 - File.Data);
+                        }
+                    }
+
+                    At = LineEnd + 1;
+                }
+            } });
+
+        if (FirstBadLine.load() != ~0ULL)
+        {
+            printf("Error parsing data point %lu of %s!\n", (unsigned long)(FirstBadLine.load() + 1), FileName);
+            Success = false;
+        }
+    }
+
+    if (Success)
+    {
+        Result->Count = DeclaredCount;
+        Result->SourceSize = TailBegin < File.Size ? TailBegin : File.Size;
+    }
+
+    free(ChunkBegin);
+    free(ChunkFirstLine);
+    UnmapFile(&File);
+
+    return (Success);
+}
+
+internal bool
+ReadInputDataFromFile(const char *FileName, Catalog *Result)
+{
+    return ReadArcminCatalog(FileName, Result, false);
+}
+
+// @Note(Victor): For the watched catalogs only, the lines a writer appended before we got to the file
+internal bool
+ReadWatchedInputDataFromFile(const char *FileName, Catalog *Result)
+{
+    return ReadArcminCatalog(FileName, Result, true);
+}
+
+// @Note(Victor): Which file a catalog name pointed to. A writer that replaces the file (renames a new one
+// over it, or deletes it and writes it again) gives the name another one, where the offsets read so far
+// mean nothing. st_ino is 0 on Windows, there a replaced file is only noticed when it got shorter.
+struct CatalogFileId
+{
+    u64 Device;
+    u64 Inode;
+};
+
+internal CatalogFileId
+GetCatalogFileId(const struct stat *FileStat)
+{
+    CatalogFileId Result = {(u64)FileStat->st_dev, (u64)FileStat->st_ino};
+    return Result;
+}
+
+// @Note(Victor): Parses the lines appended to an arcmin catalog after *Offset onto the end of Result, up to
+// its capacity, and moves *Offset past them. Only whole lines are taken, one that is still being written
+// stays for the next call. Reads at most CATALOG_TAIL_READ_SIZE bytes, so a call never takes long;
+// *TailSize says how much of the file is still left after *Offset. False when the file is gone, is not
+// FileId any more (replaced), got shorter or has a line that is not a galaxy.
+internal bool
+ReadCatalogTail(const char *FileName, const CatalogFileId *FileId, u64 *Offset, Catalog *Result, u64 *TailSize)
+{
+    *TailSize = 0;
+
+    FILE *f = fopen(FileName, "rb");
+    if (f == NULL)
+    {
+        printf("\tCould not open %s to read what was appended, it is not watched any more\n", FileName);
+        return (false);
+    }
+
+    // The file that is open, not whatever the name points to by now
+    struct stat FileStat;
+    CatalogFileId OpenId = fstat(fileno(f), &FileStat) == 0 ? GetCatalogFileId(&FileStat) : CatalogFileId{};
+    if (OpenId.Device != FileId->Device || OpenId.Inode != FileId->Inode)
+    {
+        printf("\t%s was replaced by another file, it is not watched any more\n", FileName);
+        fclose(f);
+        return (false);
+    }
+
+    bool Success = SeekCatalogFile(f, 0, SEEK_END) == 0;
+    u64 FileSize = Success ? (u64)TellCatalogFile(f) : 0;
+    if (Success && FileSize < *Offset)
+    {
+        printf("\t%s got shorter (%lu bytes, %lu were read), it is not watched any more\n", FileName, (unsigned long)FileSize,
+               (unsigned long)*Offset);
+        Success = false;
+    }
+
+    u64 Size = Success ? FileSize - *Offset : 0;
+    Size = Size < CATALOG_TAIL_READ_SIZE ? Size : CATALOG_TAIL_READ_SIZE;
+    if (Size == 0 || Result->Count == Result->Capacity)
+    {
+        fclose(f);
+        *TailSize = Success ? FileSize - *Offset : 0;
+        return (Success);
+    }
+
+    char *Buffer = (char *)malloc(Size);
+    Success = SeekCatalogFile(f, *Offset, SEEK_SET) == 0 && fread(Buffer, 1, Size, f) == Size;
+    fclose(f);
+
+    const char *At = Buffer;
+    const char *End = Buffer + Size;
+    while (Success && At < End && Result->Count < Result->Capacity)
+    {
+        const char *LineEnd = (const char *)memchr(At, '\n', End - At);
+        if (LineEnd == nullptr)
+        {
+            break;
+        }
+
+        if (!IsBlankLine(At, LineEnd))
+        {
+            f64 RightAscension, Declination;
+            if (!ParseCatalogLine(At, LineEnd, &RightAscension, &Declination))
+            {
+                printf("\tError parsing the appended line at byte %lu of %s\n", (unsigned long)(*Offset + (At - Buffer)), FileName);
+                Success = false;
+                break;
+            }
+            SetCatalogPosition(Result, Result->Count++, RightAscension, Declination);
+        }
+
+        At = LineEnd + 1;
+    }
+
+    *Offset += (u64)(At - Buffer);
+    *TailSize = FileSize - *Offset;
+    free(Buffer);
+
+    return (Success);
+}
@@ -0,0 +1,802 @@
+// Catalog streaming -------------------------------------------------------------
+// @Note(Victor): The catalogs are loaded on a loader thread while the window is already up.
+// - The loader reads each catalog and builds its instances in batches. Every finished batch is
+//   published through BuiltCount.
+// - At the start of every frame the main thread uploads whatever is new, with a byte budget.
+//   Until the catalog is sorted it is drawn unculled, as points.
+// - Once every batch of a catalog is on the GPU, the loader sorts the instances into the spatial
+//   index. The main thread then uploads them once more in that order, with the same budget, into the
+//   one buffer the sorted instances of every catalog share (CatalogLoader.Instances), one catalog after
+//   the other. From then on the catalog is culled and drawn with its levels of detail, in the same draws
+//   as the other catalogs.
+//
+// The main thread never waits on the loader. The loader only waits for the uploads, before it
+// reorders the instances the main thread uploads from.
+//
+// With CatalogLoader.IsWatching (GALAXY_WATCH) the loader stays up once everything is loaded and follows
+// the arcmin catalogs as lines are appended to them (inotify on Linux, otherwise, or for a file inotify
+// can't watch, every CATALOG_WATCH_INTERVAL_MS). Only the new lines are read, from where the last read
+// stopped, and only their instances are built, into blocks that are published through AppendedCount.
+// The main thread uploads them with the same budget to the end of a buffer of their own, which only
+// grows, and draws it as points, unculled: the appended galaxies are not in the spatial index (nor
+// picked) until the next run.
+//
+// A catalog that is replaced instead of appended to (a new file renamed over it, or deleted and written
+// again) is not followed: the offset of the old file means nothing in the new one. The device and inode
+// of the file are kept when the watch starts, and the first read that finds another file under the
+// name, or none, stops watching it with a message. The galaxies already read stay.
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define CATALOG_WATCH_HAS_INOTIFY 1
+#else
+#define CATALOG_WATCH_HAS_INOTIFY 0
+#endif
+
+const u32 CATALOG_STREAM_MAX_COUNT = INSTANCE_CATALOG_MAX_COUNT; // The id of a catalog is its slot in the shaders
+const u64 CATALOG_STREAM_BATCH_SIZE = 262144;
+const u64 CATALOG_STREAM_UPLOAD_BUDGET = Megabytes(8); // Per frame, over all catalogs
+const u32 CATALOG_WATCH_INTERVAL_MS = 100; // How often the loader looks for appended lines without inotify, and for being stopped
+
+#if CATALOG_WATCH_HAS_INOTIFY
+// @Note(Victor): The self events are the file being replaced, the next read finds out and stops watching it
+const u32 CATALOG_WATCH_EVENTS = IN_MODIFY | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF;
+#endif
+
+enum Catalog_Stream_Stage
+{
+    CATALOG_STREAM_QUEUED,
+    CATALOG_STREAM_READING,
+    CATALOG_STREAM_BUILDING,
+    CATALOG_STREAM_UPLOADING, // Every batch is built, waiting for the main thread to upload them
+    CATALOG_STREAM_INDEXING,
+    CATALOG_STREAM_READY,
+    CATALOG_STREAM_FAILED,
+};
+
+enum Galaxy_Layout
+{
+    GALAXY_LAYOUT_SPHERE,   // Celestial coordinates only, on a sphere, sky tiles
+    GALAXY_LAYOUT_REDSHIFT, // At a distance from the redshift, octree
+};
+
+// CATALOG_STREAM_BATCH_SIZE galaxies appended to a watched catalog, on the arena of its stream
+struct CatalogAppendBlock
+{
+    Catalog Data;
+    GalaxyInstance *Instances;
+    SkyInstance *Sky;
+    CatalogAppendBlock *Next;
+};
+
+struct CatalogStream
+{
+    // What to load, set before StartCatalogLoader
+    const char *FileName;
+    CatalogReader *Reader;
+    CatalogCounter *Counter; // Sizes the catalog from the file
+    bool HasRedshift;
+    const RandomCatalogOptions *Random; // Generated instead of read when set, FileName is only its name then
+
+    Galaxy_Layout Layout;
+    f64 LayoutScale; // Radius of the sphere, or distance per km/s of cz
+    Color InstanceColor;
+
+    u32 Id; // Slot in the loader, the catalog id of its SkyInstances
+
+    // Written by the loader, read by the main thread once Stage says so
+    MemoryArena Memory; // The parsed columns and the instances, reset when the stream is read again
+    Catalog Data;
+    GalaxyInstance *Instances; // Placed with the layout, for the spatial index
+    SkyInstance *Sky;          // What the GPU gets, in the same order
+    u64 Count;
+    SpatialIndex Index;
+    VisibleInstances Visible;
+
+    std::atomic<u32> Stage{CATALOG_STREAM_QUEUED};
+    std::atomic<u64> BuiltCount{0};
+
+    // Guarded by CatalogLoader.Mutex, only the main thread writes it
+    u64 UploadedCount;
+
+    // Appended to the file since it was loaded, while it is watched. The loader writes a block (and links
+    // it in) before AppendedCount says it is there.
+    CatalogAppendBlock *Appended;
+    std::atomic<u64> AppendedCount{0};
+
+    // Loader only
+    bool IsWatched;                   // False again once the file can't be followed
+    CatalogFileId SourceId;           // The file SourceOffset is in
+    u64 SourceOffset;                 // Where the next appended line starts
+    CatalogAppendBlock *LastAppended;
+
+    // Main thread only
+    GalaxyInstanceBuffer Buffer; // The batches as they are built, unloaded once the sorted instances are up
+    u64 SharedFirst;             // Where the sorted instances go in CatalogLoader.Instances
+    u64 SharedCount;             // How many of them are uploaded
+    bool IsIndexUploaded;
+
+    GalaxyInstanceBuffer AppendedBuffer; // The appended galaxies, its Count is how many are uploaded
+    CatalogAppendBlock *UploadBlock;     // The block the next one to upload is in
+};
+
+struct CatalogLoader
+{
+    CatalogStream *Streams[CATALOG_STREAM_MAX_COUNT];
+    u32 StreamCount;
+
+    // Main thread only, the sorted instances of every catalog in the order of Streams
+    GalaxyInstanceBuffer Instances;
+
+    std::thread Thread;
+    std::mutex Mutex;
+    std::condition_variable Changed;
+    bool IsCancelled; // Guarded by Mutex
+
+    bool IsWatching; // Set before StartCatalogLoader, follows the catalogs once they are loaded
+};
+
+internal void
+SetCatalogStreamStage(CatalogLoader *Loader, CatalogStream *Stream, Catalog_Stream_Stage Stage)
+{
+    {
+        std::lock_guard<std::mutex> Lock(Loader->Mutex);
+        Stream->Stage.store(Stage, std::memory_order_release);
+    }
+    Loader->Changed.notify_all();
+}
+
+internal bool
+IsCatalogLoaderCancelled(CatalogLoader *Loader)
+{
+    std::lock_guard<std::mutex> Lock(Loader->Mutex);
+    return Loader->IsCancelled;
+}
+
+internal bool
+ReadCatalogStream(CatalogLoader *Loader, CatalogStream *Stream)
+{
+    SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_READING);
+
+    // @Note(Victor): A stream that is read again reuses the pages of the last read
+    FreeCatalog(&Stream->Data);
+    ResetArena(&Stream->Memory);
+
+    // The lines appended to a watched catalog before it was read are followed like the ones after
+    CatalogReader *Reader = Loader->IsWatching && Stream->Reader == ReadInputDataFromFile ? ReadWatchedInputDataFromFile : Stream->Reader;
+
+    bool Success = Stream->Random ? LoadRandomCatalog(Stream->Random, &Stream->Memory, &Stream->Data)
+                                  : LoadCatalog(Stream->FileName, Reader, Stream->Counter, Stream->HasRedshift, true,
+                                                &Stream->Memory, &Stream->Data);
+    if (Success)
+    {
+        Stream->Count = Stream->Data.Count;
+        Stream->Instances = PushArray(&Stream->Memory, GalaxyInstance, Stream->Count);
+        Stream->Sky = PushArray(&Stream->Memory, SkyInstance, Stream->Count);
+        Success = Stream->Instances && Stream->Sky;
+    }
+
+    if (!Success)
+    {
+        printf("\tCould not load %s\n", Stream->FileName);
+        SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_FAILED);
+        return (false);
+    }
+
+    SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_BUILDING);
+
+    return (true);
+}
+
+internal bool
+BuildCatalogStream(CatalogLoader *Loader, CatalogStream *Stream)
+{
+    for (u64 First = 0; First < Stream->Count; First += CATALOG_STREAM_BATCH_SIZE)
+    {
+        if (IsCatalogLoaderCancelled(Loader))
+        {
+            return (false);
+        }
+
+        u64 BatchCount = Stream->Count - First < CATALOG_STREAM_BATCH_SIZE ? Stream->Count - First : CATALOG_STREAM_BATCH_SIZE;
+        if (Stream->Layout == GALAXY_LAYOUT_SPHERE)
+        {
+            BuildSphereInstances(&Stream->Data, First, BatchCount, (f32)Stream->LayoutScale, Stream->InstanceColor, Stream->Id,
+                                 Stream->Instances, Stream->Sky);
+        }
+        else
+        {
+            BuildRedshiftInstances(&Stream->Data, First, BatchCount, Stream->LayoutScale, Stream->InstanceColor, Stream->Id,
+                                   Stream->Instances, Stream->Sky);
+        }
+
+        Stream->BuiltCount.store(First + BatchCount, std::memory_order_release);
+    }
+
+    SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_UPLOADING);
+
+    return (true);
+}
+
+internal bool
+IndexCatalogStream(CatalogLoader *Loader, CatalogStream *Stream)
+{
+    // @Note(Victor): The index reorders the instances in place, so every batch has to be uploaded first
+    {
+        std::unique_lock<std::mutex> Lock(Loader->Mutex);
+        Loader->Changed.wait(Lock, [&]
+                             { return Loader->IsCancelled || Stream->UploadedCount == Stream->Count; });
+
+        if (Loader->IsCancelled)
+        {
+            return (false);
+        }
+    }
+
+    SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_INDEXING);
+
+    if (Stream->Layout == GALAXY_LAYOUT_SPHERE)
+    {
+        BuildSkyTiling(&Stream->Index, Stream->Instances, Stream->Sky, Stream->Count);
+    }
+    else
+    {
+        BuildOctree(&Stream->Index, Stream->Instances, Stream->Sky, Stream->Count);
+    }
+    AllocateVisibleInstances(&Stream->Visible, &Stream->Index);
+
+    SetCatalogStreamStage(Loader, Stream, CATALOG_STREAM_READY);
+
+    return (true);
+}
+
+// @Note(Victor): Only the arcmin text catalogs grow by lines at the end, the redshift listings end with
+// their notes and the generated catalogs and standalone .gcat files have no text to follow
+internal bool
+IsCatalogStreamAppendable(const CatalogStream *Stream)
+{
+    return Stream->Reader == ReadInputDataFromFile && Stream->Random == nullptr && Stream->Layout == GALAXY_LAYOUT_SPHERE &&
+           Stream->Data.SourceSize > 0 && Stream->Stage.load(std::memory_order_acquire) == CATALOG_STREAM_READY;
+}
+
+// A new block at the end of the appended galaxies of Stream, nullptr when there is no memory for it
+internal CatalogAppendBlock *
+PushCatalogAppendBlock(CatalogStream *Stream)
+{
+    MemoryArena *Arena = &Stream->Memory;
+    ArenaMark Mark = GetArenaMark(Arena);
+
+    CatalogAppendBlock *Result = PushArray(Arena, CatalogAppendBlock, 1);
+    // Stored like the catalog it is appended to, the tail is parsed into it the same way
+    bool Success = Result && (IsCatalogCompact(&Stream->Data) ? AllocateCompactCatalog(&Result->Data, Arena, CATALOG_STREAM_BATCH_SIZE)
+                                                              : AllocateCatalog(&Result->Data, Arena, CATALOG_STREAM_BATCH_SIZE, Stream->HasRedshift));
+    if (Success)
+    {
+        Result->Instances = PushArray(Arena, GalaxyInstance, CATALOG_STREAM_BATCH_SIZE);
+        Result->Sky = PushArray(Arena, SkyInstance, CATALOG_STREAM_BATCH_SIZE);
+        Success = Result->Instances && Result->Sky;
+    }
+
+    if (!Success)
+    {
+        PopArenaToMark(Arena, Mark);
+        return nullptr;
+    }
+
+    if (Stream->LastAppended)
+    {
+        Stream->LastAppended->Next = Result;
+    }
+    else
+    {
+        Stream->Appended = Result;
+    }
+    Stream->LastAppended = Result;
+
+    return Result;
+}
+
+// @Note(Victor): Loader thread. Reads everything appended to the file of Stream since the last call, builds
+// the instances of just those galaxies and publishes them. A line that is only half written waits for the next call.
+internal void
+AppendCatalogStream(CatalogLoader *Loader, CatalogStream *Stream)
+{
+    u64 TailSize = 1;
+    while (Stream->IsWatched && TailSize > 0 && !IsCatalogLoaderCancelled(Loader))
+    {
+        CatalogAppendBlock *Block = Stream->LastAppended;
+        if (Block == nullptr || Block->Data.Count == Block->Data.Capacity)
+        {
+            Block = PushCatalogAppendBlock(Stream);
+            if (Block == nullptr)
+            {
+                printf("\tNo memory for the galaxies appended to %s, it is not watched any more\n", Stream->FileName);
+                Stream->IsWatched = false;
+                break;
+            }
+        }
+
+        u64 First = Block->Data.Count;
+        if (!ReadCatalogTail(Stream->FileName, &Stream->SourceId, &Stream->SourceOffset, &Block->Data, &TailSize))
+        {
+            Stream->IsWatched = false;
+            break;
+        }
+
+        u64 Count = Block->Data.Count - First;
+        if (Count == 0)
+        {
+            break;
+        }
+
+        BuildSphereInstances(&Block->Data, First, Count, (f32)Stream->LayoutScale, Stream->InstanceColor, Stream->Id,
+                             Block->Instances, Block->Sky);
+        Stream->AppendedCount.store(Stream->AppendedCount.load(std::memory_order_relaxed) + Count, std::memory_order_release);
+    }
+}
+
+// @Note(Victor): Loader thread, after everything is loaded, until the loader is stopped. The lines appended
+// while the catalogs were loading are picked up first.
+internal void
+WatchCatalogStreams(CatalogLoader *Loader)
+{
+    u32 WatchedCount = 0;
+    bool IsChanged[CATALOG_STREAM_MAX_COUNT] = {};
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        struct stat FileStat;
+        if (IsCatalogStreamAppendable(Stream) && stat(Stream->FileName, &FileStat) != 0)
+        {
+            printf("\tCould not find %s any more, it is not watched\n", Stream->FileName);
+        }
+        else if (IsCatalogStreamAppendable(Stream))
+        {
+            Stream->IsWatched = true;
+            Stream->SourceId = GetCatalogFileId(&FileStat);
+            Stream->SourceOffset = Stream->Data.SourceSize;
+            IsChanged[i] = true;
+            WatchedCount++;
+        }
+    }
+
+    if (WatchedCount == 0)
+    {
+        return;
+    }
+
+#if CATALOG_WATCH_HAS_INOTIFY
+    i32 Watches[CATALOG_STREAM_MAX_COUNT];
+    i32 Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        Watches[i] = Notify >= 0 && Stream->IsWatched ? inotify_add_watch(Notify, Stream->FileName, CATALOG_WATCH_EVENTS) : -1;
+        if (Notify >= 0 && Stream->IsWatched && Watches[i] < 0)
+        {
+            printf("\tCould not watch %s, it is polled every %u ms instead\n", Stream->FileName, CATALOG_WATCH_INTERVAL_MS);
+        }
+    }
+#endif
+
+    printf("\tWatching %u catalogs for appended galaxies\n", WatchedCount);
+
+    while (!IsCatalogLoaderCancelled(Loader))
+    {
+        for (u32 i = 0; i < Loader->StreamCount; ++i)
+        {
+            if (IsChanged[i] && Loader->Streams[i]->IsWatched)
+            {
+                AppendCatalogStream(Loader, Loader->Streams[i]);
+            }
+            IsChanged[i] = false;
+        }
+
+#if CATALOG_WATCH_HAS_INOTIFY
+        if (Notify >= 0)
+        {
+            // Woken up by the first write, then every event that came in is taken at once
+            pollfd Poll = {Notify, POLLIN, 0};
+            if (poll(&Poll, 1, CATALOG_WATCH_INTERVAL_MS) > 0)
+            {
+                alignas(inotify_event) char Events[4096];
+                ssize_t Size;
+                while ((Size = read(Notify, Events, sizeof(Events))) > 0)
+                {
+                    for (char *At = Events; At < Events + Size;)
+                    {
+                        const inotify_event *Event = (const inotify_event *)At;
+                        for (u32 i = 0; i < Loader->StreamCount; ++i)
+                        {
+                            if (Watches[i] >= 0 && Watches[i] == Event->wd)
+                            {
+                                IsChanged[i] = true;
+                                if (Event->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))
+                                {
+                                    // The watch stays on the old file, the read that follows stops
+                                    inotify_rm_watch(Notify, Watches[i]);
+                                    Watches[i] = -1;
+                                }
+                            }
+                        }
+                        At += sizeof(inotify_event) + Event->len;
+                    }
+                }
+            }
+
+            // The files inotify refused are looked at every interval
+            for (u32 i = 0; i < Loader->StreamCount; ++i)
+            {
+                if (Loader->Streams[i]->IsWatched && Watches[i] < 0)
+                {
+                    IsChanged[i] = true;
+                }
+            }
+            continue;
+        }
+#endif
+
+        {
+            std::unique_lock<std::mutex> Lock(Loader->Mutex);
+            Loader->Changed.wait_for(Lock, std::chrono::milliseconds(CATALOG_WATCH_INTERVAL_MS), [&]
+                                     { return Loader->IsCancelled; });
+        }
+
+        for (u32 i = 0; i < Loader->StreamCount; ++i)
+        {
+            IsChanged[i] = true;
+        }
+    }
+
+#if CATALOG_WATCH_HAS_INOTIFY
+    if (Notify >= 0)
+    {
+        close(Notify);
+    }
+#endif
+}
+
+internal void
+CatalogLoaderMain(CatalogLoader *Loader)
+{
+    f64 StartTime = GetWallClockSeconds();
+
+    // @Note(Victor): Read and build everything before the first wait on the main thread, so
+    // WaitForCatalogStream works before the window (and the uploads) exist
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        if (ReadCatalogStream(Loader, Stream) && !BuildCatalogStream(Loader, Stream))
+        {
+            return;
+        }
+    }
+
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        if (Stream->Stage.load(std::memory_order_acquire) == CATALOG_STREAM_UPLOADING && !IndexCatalogStream(Loader, Stream))
+        {
+            return;
+        }
+    }
+
+    printf("\tLoaded the catalogs in %.3f s\n", GetWallClockSeconds() - StartTime);
+
+    if (Loader->IsWatching)
+    {
+        WatchCatalogStreams(Loader);
+    }
+}
+
+internal void
+StartCatalogLoader(CatalogLoader *Loader, CatalogStream **Streams, u32 StreamCount)
+{
+    Assert(StreamCount <= CATALOG_STREAM_MAX_COUNT);
+
+    for (u32 i = 0; i < StreamCount; ++i)
+    {
+        Loader->Streams[i] = Streams[i];
+        Streams[i]->Id = i;
+    }
+    Loader->StreamCount = StreamCount;
+    Loader->IsCancelled = false;
+
+    Loader->Thread = std::thread(CatalogLoaderMain, Loader);
+}
+
+// Waits for the loader and drops whatever it has not done yet
+internal void
+StopCatalogLoader(CatalogLoader *Loader)
+{
+    if (!Loader->Thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(Loader->Mutex);
+        Loader->IsCancelled = true;
+    }
+    Loader->Changed.notify_all();
+
+    Loader->Thread.join();
+}
+
+// @Note(Victor): Blocks until the catalog of Stream is read (or failed), for the things that need the
+// whole catalog on the CPU before the window opens. Never waits on the uploads.
+internal bool
+WaitForCatalogStream(CatalogLoader *Loader, CatalogStream *Stream)
+{
+    std::unique_lock<std::mutex> Lock(Loader->Mutex);
+    Loader->Changed.wait(Lock, [&]
+                         { return Stream->Stage.load(std::memory_order_acquire) >= CATALOG_STREAM_BUILDING; });
+
+    return Stream->Stage.load(std::memory_order_acquire) != CATALOG_STREAM_FAILED;
+}
+
+// @Note(Victor): The loader reads every catalog before it sorts the first one, so once one is sorted all
+// their sizes are known and the shared buffer is made big enough for all of them at once
+internal void
+ReserveSharedInstances(CatalogLoader *Loader)
+{
+    u64 Total = 0;
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        u32 Stage = Stream->Stage.load(std::memory_order_acquire);
+        Assert(Stage >= CATALOG_STREAM_BUILDING);
+
+        if (Stage != CATALOG_STREAM_FAILED)
+        {
+            Stream->SharedFirst = Total;
+            Total += Stream->Count;
+        }
+    }
+
+    ReserveGalaxyInstances(&Loader->Instances, Total);
+}
+
+// @Note(Victor): Main thread, once per frame. Uploads the new batches (at most
+// CATALOG_STREAM_UPLOAD_BUDGET bytes of them) and the sorted instances of catalogs that just got indexed.
+internal void
+UpdateCatalogStreams(CatalogLoader *Loader)
+{
+    u64 Budget = CATALOG_STREAM_UPLOAD_BUDGET / sizeof(SkyInstance);
+
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        u32 Stage = Stream->Stage.load(std::memory_order_acquire);
+
+        if (Stage == CATALOG_STREAM_READY && !Stream->IsIndexUploaded)
+        {
+            if (Loader->Instances.Ids == nullptr)
+            {
+                ReserveSharedInstances(Loader);
+            }
+
+            u64 Count = Stream->Count - Stream->SharedCount < Budget ? Stream->Count - Stream->SharedCount : Budget;
+            UploadGalaxyInstanceRange(&Loader->Instances, Stream->Sky + Stream->SharedCount, Stream->SharedFirst + Stream->SharedCount, Count);
+            Stream->SharedCount += Count;
+            Budget -= Count;
+
+            if (Stream->SharedCount == Stream->Count)
+            {
+                UnloadGalaxyInstances(&Stream->Buffer);
+                Stream->IsIndexUploaded = true;
+            }
+            continue;
+        }
+
+        if (Stage < CATALOG_STREAM_BUILDING || Stage > CATALOG_STREAM_UPLOADING || Budget == 0)
+        {
+            continue;
+        }
+
+        u64 BuiltCount = Stream->BuiltCount.load(std::memory_order_acquire);
+        if (BuiltCount > Stream->UploadedCount)
+        {
+            u64 Count = BuiltCount - Stream->UploadedCount < Budget ? BuiltCount - Stream->UploadedCount : Budget;
+
+            ReserveGalaxyInstances(&Stream->Buffer, Stream->Count);
+            UploadGalaxyInstanceRange(&Stream->Buffer, Stream->Sky + Stream->UploadedCount, Stream->UploadedCount, Count);
+            Budget -= Count;
+
+            {
+                std::lock_guard<std::mutex> Lock(Loader->Mutex);
+                Stream->UploadedCount += Count;
+            }
+            Loader->Changed.notify_all();
+        }
+    }
+}
+
+// @Note(Victor): Main thread, once per frame while the catalogs are watched. Uploads what was appended since
+// the last frame, at most CATALOG_STREAM_UPLOAD_BUDGET bytes of it, to the end of the appended buffers.
+internal void
+UpdateAppendedGalaxies(CatalogLoader *Loader)
+{
+    u64 Budget = CATALOG_STREAM_UPLOAD_BUDGET / sizeof(SkyInstance);
+
+    for (u32 i = 0; i < Loader->StreamCount && Budget > 0; ++i)
+    {
+        CatalogStream *Stream = Loader->Streams[i];
+        GalaxyInstanceBuffer *Buffer = &Stream->AppendedBuffer;
+        u64 AppendedCount = Stream->AppendedCount.load(std::memory_order_acquire);
+
+        while (Buffer->Count < AppendedCount && Budget > 0)
+        {
+            u64 Uploaded = Buffer->Count;
+            u64 InBlock = Uploaded % CATALOG_STREAM_BATCH_SIZE;
+            if (Stream->UploadBlock == nullptr)
+            {
+                Stream->UploadBlock = Stream->Appended;
+            }
+            else if (InBlock == 0)
+            {
+                Stream->UploadBlock = Stream->UploadBlock->Next;
+            }
+
+            u64 Count = CATALOG_STREAM_BATCH_SIZE - InBlock;
+            Count = AppendedCount - Uploaded < Count ? AppendedCount - Uploaded : Count;
+            Count = Budget < Count ? Budget : Count;
+
+            GrowGalaxyInstances(Buffer, Uploaded + Count);
+            UploadGalaxyInstanceRange(Buffer, Stream->UploadBlock->Sky + InBlock, Uploaded, Count);
+            Budget -= Count;
+        }
+    }
+}
+
+// Everything is loaded (or failed), nothing left for UpdateCatalogStreams to do
+internal bool
+IsCatalogLoaderDone(const CatalogLoader *Loader)
+{
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        const CatalogStream *Stream = Loader->Streams[i];
+        u32 Stage = Stream->Stage.load(std::memory_order_acquire);
+        if (Stage != CATALOG_STREAM_FAILED && !(Stage == CATALOG_STREAM_READY && Stream->IsIndexUploaded))
+        {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// @Note(Victor): In [0, 1]. Per catalog: reading is the first quarter, building and uploading the batches the
+// next half, sorting a tenth and uploading the sorted instances the rest.
+internal f32
+GetCatalogLoaderProgress(const CatalogLoader *Loader)
+{
+    if (Loader->StreamCount == 0)
+    {
+        return 1.0f;
+    }
+
+    f32 Progress = 0.0f;
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        const CatalogStream *Stream = Loader->Streams[i];
+        u32 Stage = Stream->Stage.load(std::memory_order_acquire);
+
+        if (Stage == CATALOG_STREAM_FAILED || (Stage == CATALOG_STREAM_READY && Stream->IsIndexUploaded))
+        {
+            Progress += 1.0f;
+        }
+        else if (Stage == CATALOG_STREAM_READY)
+        {
+            Progress += 0.85f + (Stream->Count > 0 ? 0.15f * (f32)Stream->SharedCount / (f32)Stream->Count : 0.15f);
+        }
+        else if (Stage == CATALOG_STREAM_INDEXING)
+        {
+            Progress += 0.75f;
+        }
+        else if (Stage >= CATALOG_STREAM_BUILDING)
+        {
+            u64 Done = Stream->BuiltCount.load(std::memory_order_acquire) + Stream->UploadedCount;
+            Progress += 0.25f + (Stream->Count > 0 ? 0.25f * (f32)Done / (f32)Stream->Count : 0.5f);
+        }
+    }
+
+    return Progress / (f32)Loader->StreamCount;
+}
+
+// Before CloseWindow, the loader has to be stopped first
+internal void
+UnloadCatalogStream(CatalogStream *Stream)
+{
+    UnloadGalaxyInstances(&Stream->Buffer);
+    Stream->SharedCount = 0;
+    Stream->IsIndexUploaded = false;
+
+    UnloadGalaxyInstances(&Stream->AppendedBuffer);
+    Stream->UploadBlock = nullptr;
+}
+
+// The GPU buffers of every catalog of the loader, the shared one too
+internal void
+UnloadCatalogLoader(CatalogLoader *Loader)
+{
+    for (u32 i = 0; i < Loader->StreamCount; ++i)
+    {
+        UnloadCatalogStream(Loader->Streams[i]);
+    }
+    UnloadGalaxyInstances(&Loader->Instances);
+}
+
+// Our memory behind the catalog on the CPU, from the parsed columns to the index
+internal u64
+GetCatalogStreamMemory(const CatalogStream *Stream)
+{
+    return Stream->Memory.Used + GetSpatialIndexMemory(&Stream->Index) + GetVisibleInstancesMemory(&Stream->Visible);
+}
+
+internal void
+FreeCatalogStream(CatalogStream *Stream)
+{
+    FreeCatalog(&Stream->Data);
+    FreeArena(&Stream->Memory);
+
+    Stream->Instances = nullptr;
+    Stream->Sky = nullptr;
+    Stream->Count = 0;
+
+    // The appended blocks were on the arena too
+    Stream->Appended = nullptr;
+    Stream->LastAppended = nullptr;
+    Stream->AppendedCount.store(0, std::memory_order_relaxed);
+    Stream->IsWatched = false;
+
+    FreeSpatialIndex(&Stream->Index);
+    FreeVisibleInstances(&Stream->Visible);
+}
+
+// Catalog registry --------------------------------------------------------------
+// @Note(Victor): Every catalog there is, in the order they were added, as many as the shaders have slots
+// for. The slot of a catalog is its id everywhere: in the loader, in its SkyInstances and in the uniform
+// arrays of the instancing shaders. Hiding a catalog only leaves its runs out of the draws.
+struct CatalogRegistry
+{
+    CatalogStream Streams[CATALOG_STREAM_MAX_COUNT];
+    bool IsVisible[CATALOG_STREAM_MAX_COUNT];
+    u32 Count;
+};
+
+// The reader, the counter and the redshift are up to the caller, nullptr once the registry is full
+internal CatalogStream *
+AddCatalog(CatalogRegistry *Registry, const char *FileName, Galaxy_Layout Layout, f64 LayoutScale, Color InstanceColor, bool IsVisible)
+{
+    if (Registry->Count == CATALOG_STREAM_MAX_COUNT)
+    {
+        printf("\tNo room for %s, at most %u catalogs\n", FileName, CATALOG_STREAM_MAX_COUNT);
+        return nullptr;
+    }
+
+    CatalogStream *Result = &Registry->Streams[Registry->Count];
+    Result->FileName = FileName;
+    Result->Layout = Layout;
+    Result->LayoutScale = LayoutScale;
+    Result->InstanceColor = InstanceColor;
+
+    Registry->IsVisible[Registry->Count++] = IsVisible;
+
+    return Result;
+}
+
+// Loads every catalog of the registry, their ids are their slots
+internal void
+StartCatalogRegistry(CatalogLoader *Loader, CatalogRegistry *Registry)
+{
+    CatalogStream *Streams[CATALOG_STREAM_MAX_COUNT] = {};
+    for (u32 i = 0; i < Registry->Count; ++i)
+    {
+        Streams[i] = &Registry->Streams[i];
+    }
+
+    StartCatalogLoader(Loader, Streams, Registry->Count);
+}
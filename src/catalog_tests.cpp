@@ -0,0 +1,567 @@
+// @Note(Victor): Regression tests for the parts of the catalog path that are easy to get subtly wrong,
+// no window and no raylib, run by ctest (or on its own, it writes its scratch files to the working directory).
+//
+//   - the header and line checks of the arcmin loader
+//   - the reads of the lines appended to a watched catalog
+//   - the .gcat cache round trip, f64 and fixed point, and its staleness check
+//   - the fixed point arc minutes of the compact catalogs
+//   - the AVX2 angle kernels against their scalar twins, bit for bit
+//   - the dual tree correlation against the brute force and the naive acos reference
+//
+// The same checks GALAXY_CORRELATION_CHECK and GALAXY_VERIFY_CACHE do at runtime, on small made up catalogs.
+// Every check prints what failed, the exit code is the number of failed tests.
+
+// Includes ----------------------------------------------------------------------
+#include "includes.h"
+
+#include <charconv>
+
+// Variables ---------------------------------------------------------------------
+std::atomic<u64> CPUMemory{0};
+
+constexpr f64 PIdividedBy180 = (3.14159265358979323846 / 180.0);
+
+// Modules -----------------------------------------------------------------------
+#include "parallel.cpp"
+#include "memory_arena.cpp"
+#include "catalog.cpp"
+#include "catalog_loader.cpp"
+#include "catalog_cache.cpp"
+#include "correlation.cpp"
+#include "angle_kernels.cpp"
+
+global_variable u32 CheckFailures = 0;
+
+#define Check(Expression)                                                    \
+    do                                                                       \
+    {                                                                        \
+        if (!(Expression))                                                   \
+        {                                                                    \
+            printf("\t%s:%d: %s failed\n", __FILE__, __LINE__, #Expression); \
+            CheckFailures++;                                                 \
+        }                                                                    \
+    } while (0)
+
+internal bool
+WriteTestFile(const char *FileName, const char *Text)
+{
+    FILE *f = fopen(FileName, "wb");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    bool Success = fwrite(Text, 1, strlen(Text), f) == strlen(Text);
+    return (fclose(f) == 0) && Success;
+}
+
+internal bool
+AppendTestFile(const char *FileName, const char *Text)
+{
+    FILE *f = fopen(FileName, "ab");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    bool Success = fwrite(Text, 1, strlen(Text), f) == strlen(Text);
+    return (fclose(f) == 0) && Success;
+}
+
+internal bool
+DoesFileExist(const char *FileName)
+{
+    struct stat FileStat;
+    return stat(FileName, &FileStat) == 0;
+}
+
+// Loader ------------------------------------------------------------------------
+internal bool
+ReadTestCatalog(const char *Text, Catalog *Result, MemoryArena *Arena, u64 Capacity, bool (*Reader)(const char *, Catalog *))
+{
+    const char *FileName = "catalog_tests_header.txt";
+    ResetArena(Arena);
+    bool Success = WriteTestFile(FileName, Text) && AllocateCatalog(Result, Arena, Capacity, false) && Reader(FileName, Result);
+    remove(FileName);
+
+    return (Success);
+}
+
+internal void
+TestCatalogHeader(void)
+{
+    MemoryArena Arena = {};
+    Catalog Data = {};
+
+    Check(ReadTestCatalog("3\n1.5\t2.25\n3 -4\n5.125 6\n", &Data, &Arena, 3, ReadInputDataFromFile));
+    Check(Data.Count == 3 && Data.RightAscension[0] == 1.5 && Data.Declination[0] == 2.25);
+    Check(Data.Declination[1] == -4.0 && Data.RightAscension[2] == 5.125);
+
+    // CRLF, blank lines and trailing blanks are not galaxies
+    Check(ReadTestCatalog("2\r\n1\t2\r\n\r\n3 4  \r\n\r\n", &Data, &Arena, 2, ReadInputDataFromFile));
+    Check(Data.Count == 2 && Data.RightAscension[1] == 3.0 && Data.Declination[1] == 4.0);
+
+    // The header has to match the lines, and fit the catalog
+    Check(!ReadTestCatalog("3\n1 2\n3 4\n", &Data, &Arena, 3, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("1\n1 2\n3 4\n", &Data, &Arena, 2, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("3\n1 2\n3 4\n5 6\n", &Data, &Arena, 2, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("three\n1 2\n", &Data, &Arena, 3, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("2\n1 2\n3 x\n", &Data, &Arena, 2, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("2\n1 2\n3 4 5\n", &Data, &Arena, 2, ReadInputDataFromFile));
+    Check(!ReadTestCatalog("", &Data, &Arena, 2, ReadInputDataFromFile));
+
+    u64 DeclaredCount = 0;
+    Check(WriteTestFile("catalog_tests_count.txt", " 42 \r\n1 2\n") && ReadCatalogDeclaredCount("catalog_tests_count.txt", &DeclaredCount));
+    Check(DeclaredCount == 42);
+    remove("catalog_tests_count.txt");
+
+    FreeCatalog(&Data);
+    FreeArena(&Arena);
+}
+
+// Watched catalogs --------------------------------------------------------------
+internal bool
+GetTestFileId(const char *FileName, CatalogFileId *Result)
+{
+    struct stat FileStat;
+    if (stat(FileName, &FileStat) != 0)
+    {
+        return (false);
+    }
+
+    *Result = GetCatalogFileId(&FileStat);
+    return (true);
+}
+
+internal void
+TestCatalogTail(void)
+{
+    const char *FileName = "catalog_tests_tail.txt";
+    MemoryArena Arena = {};
+    Catalog Data = {};
+
+    // Only a watched catalog takes the lines after the declared ones, and leaves them after SourceSize
+    Check(ReadTestCatalog("1\n1 2\n3 4\n", &Data, &Arena, 2, ReadWatchedInputDataFromFile));
+    Check(Data.Count == 1 && Data.SourceSize == strlen("1\n1 2\n"));
+
+    // The file is then fed in steps, the way a writer appends to it
+    ResetArena(&Arena);
+    Catalog Tail = {};
+    CatalogFileId FileId = {};
+    u64 TailSize = 0;
+    Check(WriteTestFile(FileName, "1\n1 2\n") && GetTestFileId(FileName, &FileId));
+    Check(AllocateCatalog(&Tail, &Arena, 2, false));
+    u64 Offset = strlen("1\n1 2\n");
+
+    // Nothing appended yet
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 0 && Offset == strlen("1\n1 2\n") && TailSize == 0);
+
+    // A line that is still being written stays where it is
+    Check(AppendTestFile(FileName, "3 4"));
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 0 && Offset == strlen("1\n1 2\n") && TailSize == strlen("3 4"));
+
+    Check(AppendTestFile(FileName, ".5\n5 6\n7"));
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 2 && Tail.RightAscension[0] == 3.0 && Tail.Declination[0] == 4.5 && Tail.RightAscension[1] == 5.0);
+    Check(Offset == strlen("1\n1 2\n3 4.5\n5 6\n") && TailSize == 1);
+
+    // A full block stops there, the next one goes on from the same offset
+    Check(AppendTestFile(FileName, " 8\n9 10\n"));
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 2 && Offset == strlen("1\n1 2\n3 4.5\n5 6\n") && TailSize == strlen("7 8\n9 10\n"));
+
+    Check(AllocateCatalog(&Tail, &Arena, 2, false));
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 2 && Tail.RightAscension[0] == 7.0 && Tail.Declination[1] == 10.0 && TailSize == 0);
+
+    // Blank and CRLF lines are not galaxies
+    Check(AllocateCatalog(&Tail, &Arena, 4, false));
+    Check(AppendTestFile(FileName, "\r\n\n11 -12\r\n  \t\n13 14\r\n"));
+    Check(ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 2 && Tail.Declination[0] == -12.0 && Tail.RightAscension[1] == 13.0 && TailSize == 0);
+
+    // A line that is not a galaxy stops the watch, as does a file that got shorter
+    u64 GoodOffset = Offset;
+    Check(AppendTestFile(FileName, "15 x\n"));
+    Check(!ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+
+    Offset = GoodOffset;
+    Check(WriteTestFile(FileName, "1\n1 2\n"));
+    Check(!ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+
+    // So does a file renamed over it, however long it is, and a deleted one
+    const char *NewFileName = "catalog_tests_tail_new.txt";
+    Offset = strlen("1\n1 2\n");
+    Check(WriteTestFile(NewFileName, "1\n1 2\n3 4\n5 -67.89\n") && rename(NewFileName, FileName) == 0);
+    Check(!ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+    Check(Tail.Count == 2);
+
+    remove(FileName);
+    Check(!DoesFileExist(NewFileName));
+    Check(!ReadCatalogTail(FileName, &FileId, &Offset, &Tail, &TailSize));
+
+    FreeCatalog(&Data);
+    FreeArena(&Arena);
+}
+
+// Catalog cache -----------------------------------------------------------------
+internal bool
+IsSameCatalog(const Catalog *A, const Catalog *B)
+{
+    if (A->Count != B->Count || IsCatalogCompact(A) != IsCatalogCompact(B) || (A->Redshift == nullptr) != (B->Redshift == nullptr))
+    {
+        return (false);
+    }
+
+    if (IsCatalogCompact(A))
+    {
+        return memcmp(A->RightAscensionFixed, B->RightAscensionFixed, A->Count * sizeof(i32)) == 0 &&
+               memcmp(A->DeclinationFixed, B->DeclinationFixed, A->Count * sizeof(i32)) == 0;
+    }
+
+    return memcmp(A->RightAscension, B->RightAscension, A->Count * sizeof(f64)) == 0 &&
+           memcmp(A->Declination, B->Declination, A->Count * sizeof(f64)) == 0 &&
+           (A->Redshift == nullptr || memcmp(A->Redshift, B->Redshift, A->Count * sizeof(f64)) == 0);
+}
+
+internal void
+FillTestCatalog(Catalog *Result, u64 Count)
+{
+    for (u64 i = 0; i < Count; ++i)
+    {
+        SetCatalogPosition(Result, i, (f64)(i * 7919 % 2160000) / 100.0, (f64)(i * 104729 % 1080000) / 100.0 - 5400.0);
+        if (Result->Redshift)
+        {
+            Result->Redshift[i] = (f64)i * 3.5 - 100.0;
+        }
+    }
+    Result->Count = Count;
+}
+
+internal void
+TestCatalogCache(void)
+{
+    const u64 Count = 1000;
+    const char *CacheFileName = "catalog_tests.gcat";
+    MemoryArena Arena = {};
+
+    // With and without redshift, and in fixed point, a catalog goes through a standalone .gcat and comes back the same
+    for (u32 Storage = 0; Storage < 3; ++Storage)
+    {
+        Catalog Source = {};
+        bool Allocated = Storage == 2 ? AllocateCompactCatalog(&Source, &Arena, Count) : AllocateCatalog(&Source, &Arena, Count, Storage == 1);
+        Check(Allocated);
+        FillTestCatalog(&Source, Count);
+
+        Catalog Mapped = {};
+        Check(WriteGcatFile(CacheFileName, &Source, nullptr));
+        Check(MapGcatFile(CacheFileName, nullptr, &Mapped));
+        Check(IsSameCatalog(&Source, &Mapped));
+        FreeCatalog(&Mapped);
+
+        // Cut short, the columns don't fit in the file any more
+        MappedFile File;
+        Check(MapFile(CacheFileName, &File));
+        usize HalfSize = File.Size / 2;
+        u8 *Half = (u8 *)malloc(HalfSize);
+        memcpy(Half, File.Data, HalfSize);
+        UnmapFile(&File);
+
+        FILE *f = fopen(CacheFileName, "wb");
+        Check(f && fwrite(Half, 1, HalfSize, f) == HalfSize);
+        if (f)
+        {
+            fclose(f);
+        }
+        Check(!MapGcatFile(CacheFileName, nullptr, &Mapped));
+        Check(WriteTestFile(CacheFileName, "") && !MapGcatFile(CacheFileName, nullptr, &Mapped));
+        free(Half);
+
+        remove(CacheFileName);
+    }
+
+    // The cache of a source is stamped with it, and stale once the source changes
+    const char *SourceFileName = "catalog_tests_source.txt";
+    char SourceCacheFileName[1024];
+    GetCatalogCacheFileName(SourceFileName, SourceCacheFileName, sizeof(SourceCacheFileName));
+    remove(SourceCacheFileName);
+
+    Catalog Loaded = {};
+    Catalog Mapped = {};
+    Check(WriteTestFile(SourceFileName, "2\n10.25 -20.5\n30 40\n"));
+
+    // Without WriteCache nothing is left next to the source
+    Check(LoadCatalog(SourceFileName, ReadInputDataFromFile, ReadCatalogDeclaredCount, false, false, &Arena, &Loaded));
+    Check(Loaded.Count == 2 && !DoesFileExist(SourceCacheFileName));
+
+    Check(LoadCatalog(SourceFileName, ReadInputDataFromFile, ReadCatalogDeclaredCount, false, true, &Arena, &Loaded));
+    Check(DoesFileExist(SourceCacheFileName));
+    Check(MapCatalogCache(SourceFileName, &Mapped) && IsSameCatalog(&Loaded, &Mapped));
+    Check(Mapped.SourceSize == strlen("2\n10.25 -20.5\n30 40\n"));
+    FreeCatalog(&Mapped);
+
+    // Same size and modified time, only the hash of GALAXY_VERIFY_CACHE notices
+#if defined(__linux__) || defined(__APPLE__)
+    struct stat SourceStat;
+    Check(stat(SourceFileName, &SourceStat) == 0);
+    Check(WriteTestFile(SourceFileName, "2\n10.25 -20.5\n30 41\n"));
+
+    struct timespec Times[2] = {};
+    Times[0].tv_nsec = UTIME_OMIT;
+#if defined(__APPLE__)
+    Times[1] = SourceStat.st_mtimespec;
+#else
+    Times[1] = SourceStat.st_mtim;
+#endif
+    Check(utimensat(AT_FDCWD, SourceFileName, Times, 0) == 0);
+
+    Check(MapCatalogCache(SourceFileName, &Mapped));
+    FreeCatalog(&Mapped);
+    VerifyCatalogCache = true;
+    Check(!MapCatalogCache(SourceFileName, &Mapped));
+    VerifyCatalogCache = false;
+#endif
+
+    Check(WriteTestFile(SourceFileName, "2\n10.25 -20.5\n30 41\n50 60\n"));
+    Check(!MapCatalogCache(SourceFileName, &Mapped));
+
+    FreeCatalog(&Loaded);
+    remove(SourceFileName);
+    remove(SourceCacheFileName);
+    FreeArena(&Arena);
+}
+
+// Fixed point -------------------------------------------------------------------
+internal void
+TestFixedPoint(void)
+{
+    // Up to four decimals are kept exactly, over the whole sky
+    for (i32 Hundredths = -540000; Hundredths <= 2160000; Hundredths += 37)
+    {
+        f64 Arcmin = Hundredths / 100.0;
+        i32 Steps = QuantizeArcmin(Arcmin);
+        Check(Steps == Hundredths * 100);
+        Check(fabs(DequantizeArcmin(Steps) - Arcmin) < 1e-9);
+    }
+    Check(QuantizeArcmin(1.2345) == 12345 && QuantizeArcmin(-1.2345) == -12345);
+
+    // Anything finer is at most half a step off
+    f64 MaxError = 0.0;
+    for (u32 i = 0; i < 100000; ++i)
+    {
+        f64 Arcmin = -5400.0 + (f64)i * 0.27000037;
+        MaxError = fmax(MaxError, fabs(DequantizeArcmin(QuantizeArcmin(Arcmin)) - Arcmin));
+    }
+    Check(MaxError <= 0.5 * CATALOG_FIXED_STEP + 1e-9);
+
+    // Far outside the sky it saturates instead of wrapping
+    Check(QuantizeArcmin(1e12) == 2147483647 && QuantizeArcmin(-1e12) == -2147483647);
+
+    // The columns and the accessors agree in both storages
+    MemoryArena Arena = {};
+    Catalog Exact = {};
+    Catalog Compact = {};
+    Check(AllocateCatalog(&Exact, &Arena, 4, false) && AllocateCompactCatalog(&Compact, &Arena, 4));
+    Check(GetCatalogGalaxySize(&Exact) == 16 && GetCatalogGalaxySize(&Compact) == 8);
+
+    const f64 Positions[4][2] = {{0.0, -5400.0}, {21599.99, 5400.0}, {4646.98, 3749.51}, {0.228299, -0.400053}};
+    for (u32 i = 0; i < 4; ++i)
+    {
+        SetCatalogPosition(&Exact, i, Positions[i][0], Positions[i][1]);
+        SetCatalogPosition(&Compact, i, Positions[i][0], Positions[i][1]);
+
+        Check(GetCatalogRightAscension(&Exact, i) == Positions[i][0] && GetCatalogDeclination(&Exact, i) == Positions[i][1]);
+        Check(fabs(GetCatalogRightAscension(&Compact, i) - Positions[i][0]) <= 0.5 * CATALOG_FIXED_STEP + 1e-9);
+        Check(fabs(GetCatalogDeclination(&Compact, i) - Positions[i][1]) <= 0.5 * CATALOG_FIXED_STEP + 1e-9);
+
+        // In radians the two storages are at most half a step and a float ulp apart
+        f32 ExactRadians = ArcminToRadians(Positions[i][0]);
+        f32 CompactRadians = ArcminToRadians(Compact.RightAscensionFixed[i]);
+        Check(fabsf(ExactRadians - CompactRadians) <= 0.5 * FIXED_ARCMIN_TO_RADIANS + fabsf(ExactRadians) * 1.2e-7f);
+    }
+
+    FreeArena(&Arena);
+}
+
+// Angle kernels -----------------------------------------------------------------
+#if ANGLE_KERNELS_HAS_AVX2
+__attribute__((target("avx2"))) internal u32
+CountSinCosMismatches(const f32 *Angles, u32 Count)
+{
+    u32 Mismatches = 0;
+    for (u32 i = 0; i + 8 <= Count; i += 8)
+    {
+        f32 Sin[8], Cos[8];
+        __m256 Sin8, Cos8;
+        SinCos8(_mm256_loadu_ps(Angles + i), &Sin8, &Cos8);
+        _mm256_storeu_ps(Sin, Sin8);
+        _mm256_storeu_ps(Cos, Cos8);
+
+        for (u32 Lane = 0; Lane < 8; ++Lane)
+        {
+            f32 ScalarSin, ScalarCos;
+            SinCos(Angles[i + Lane], &ScalarSin, &ScalarCos);
+            Mismatches += memcmp(&Sin[Lane], &ScalarSin, sizeof(f32)) != 0 || memcmp(&Cos[Lane], &ScalarCos, sizeof(f32)) != 0;
+        }
+    }
+
+    return Mismatches;
+}
+
+__attribute__((target("avx2"))) internal u32
+CountConversionMismatches(const f64 *Arcmin, const i32 *Steps, const f64 *Sexagesimal, u32 Count)
+{
+    u32 Mismatches = 0;
+    for (u32 i = 0; i + 8 <= Count; i += 8)
+    {
+        f32 FromArcmin[8], FromSteps[8], FromSexagesimal[8];
+        _mm256_storeu_ps(FromArcmin, ArcminToRadians8(Arcmin + i));
+        _mm256_storeu_ps(FromSteps, ArcminToRadians8(Steps + i));
+        _mm256_storeu_ps(FromSexagesimal, SexagesimalToRadians8(Sexagesimal + i, 15.0));
+
+        for (u32 Lane = 0; Lane < 8; ++Lane)
+        {
+            f32 ScalarArcmin = ArcminToRadians(Arcmin[i + Lane]);
+            f32 ScalarSteps = ArcminToRadians(Steps[i + Lane]);
+            f32 ScalarSexagesimal = SexagesimalToRadians(Sexagesimal[i + Lane], 15.0);
+            Mismatches += memcmp(&FromArcmin[Lane], &ScalarArcmin, sizeof(f32)) != 0;
+            Mismatches += memcmp(&FromSteps[Lane], &ScalarSteps, sizeof(f32)) != 0;
+            Mismatches += memcmp(&FromSexagesimal[Lane], &ScalarSexagesimal, sizeof(f32)) != 0;
+        }
+    }
+
+    return Mismatches;
+}
+#endif
+
+internal void
+TestAngleKernels(void)
+{
+    const u32 Count = 65536;
+    f32 *Angles = (f32 *)calloc(Count, sizeof(f32));
+    f64 *Arcmin = (f64 *)calloc(Count, sizeof(f64));
+    i32 *Steps = (i32 *)calloc(Count, sizeof(i32));
+    f64 *Sexagesimal = (f64 *)calloc(Count, sizeof(f64));
+
+    // The sky and a bit past it both ways, plus the octant edges and the signed zeros
+    for (u32 i = 0; i < Count; ++i)
+    {
+        Angles[i] = -8.0f + 16.0f * (f32)i / (f32)Count;
+        Arcmin[i] = -5400.0 + 27000.0 * (f64)i / (f64)Count;
+        Steps[i] = QuantizeArcmin(Arcmin[i]);
+
+        f64 Hours = floor(24.0 * i / Count);
+        f64 Minutes = (f64)(i % 60);
+        f64 Seconds = (f64)(i % 600) / 10.0;
+        Sexagesimal[i] = (i % 2 ? -1.0 : 1.0) * (Hours * 10000.0 + Minutes * 100.0 + Seconds);
+    }
+    const f32 Edges[] = {0.0f, -0.0f, 0.7853982f, -0.7853982f, 1.5707964f, 3.1415927f, -3.1415927f, 6.2831855f};
+    memcpy(Angles, Edges, sizeof(Edges));
+
+    // The scalar sincos is within a couple of float ulps of libm
+    f32 MaxError = 0.0f;
+    for (u32 i = 0; i < Count; ++i)
+    {
+        f32 Sin, Cos;
+        SinCos(Angles[i], &Sin, &Cos);
+        MaxError = fmaxf(MaxError, fmaxf(fabsf(Sin - sinf(Angles[i])), fabsf(Cos - cosf(Angles[i]))));
+    }
+    Check(MaxError < 4e-7f);
+
+#if ANGLE_KERNELS_HAS_AVX2
+    if (UseAngleKernelsAVX2())
+    {
+        Check(CountSinCosMismatches(Angles, Count) == 0);
+        Check(CountConversionMismatches(Arcmin, Steps, Sexagesimal, Count) == 0);
+    }
+    else
+    {
+        printf("\tNo AVX2 on this CPU, only the scalar kernels were tested\n");
+    }
+#endif
+
+    free(Angles);
+    free(Arcmin);
+    free(Steps);
+    free(Sexagesimal);
+}
+
+// Angular correlation -----------------------------------------------------------
+internal void
+TestAngularCorrelation(void)
+{
+    // @Note(Victor): Two decimals like the course data, so pairs on a bin edge happen here too. The real
+    // galaxies are bunched in a few clusters, the random ones spread over a cap, both cross RA 0.
+    const u64 Count = 2000;
+    MemoryArena Arena = {};
+
+    for (u32 Storage = 0; Storage < 2; ++Storage)
+    {
+        Catalog Data = {};
+        Catalog Random = {};
+        bool Allocated = Storage == 0 ? AllocateCatalog(&Data, &Arena, Count, false) && AllocateCatalog(&Random, &Arena, Count, false)
+                                      : AllocateCompactCatalog(&Data, &Arena, Count) && AllocateCompactCatalog(&Random, &Arena, Count);
+        Check(Allocated);
+
+        u64 State = 0x2545F4914F6CDD1DULL;
+        for (u64 i = 0; i < Count; ++i)
+        {
+            f64 Uniform[4];
+            for (u32 j = 0; j < 4; ++j)
+            {
+                State ^= State << 13;
+                State ^= State >> 7;
+                State ^= State << 17;
+                Uniform[j] = (f64)(State >> 11) / 9007199254740992.0;
+            }
+
+            f64 ClusterRightAscension = (f64)(i % 5) * 1200.0;
+            f64 ClusterDeclination = (f64)(i % 5) * 300.0 - 600.0;
+            f64 RightAscension = fmod(ClusterRightAscension + (Uniform[0] - 0.5) * 120.0 + 21600.0, 21600.0);
+            SetCatalogPosition(&Data, i, round(RightAscension * 100.0) / 100.0, round((ClusterDeclination + (Uniform[1] - 0.5) * 120.0) * 100.0) / 100.0);
+
+            RightAscension = fmod((Uniform[2] - 0.5) * 9000.0 + 21600.0, 21600.0);
+            SetCatalogPosition(&Random, i, round(RightAscension * 100.0) / 100.0, round((Uniform[3] - 0.5) * 3600.0 * 100.0) / 100.0);
+        }
+        Data.Count = Count;
+        Random.Count = Count;
+
+        Check(VerifyAngularCorrelation(&Data, &Random, Count));
+    }
+
+    FreeArena(&Arena);
+}
+
+i32 main(i32 argc, char **argv)
+{
+    struct
+    {
+        const char *Name;
+        void (*Run)(void);
+    } Tests[] = {
+        {"catalog header", TestCatalogHeader},
+        {"watched catalog", TestCatalogTail},
+        {"catalog cache", TestCatalogCache},
+        {"fixed point", TestFixedPoint},
+        {"angle kernels", TestAngleKernels},
+        {"angular correlation", TestAngularCorrelation},
+    };
+
+    i32 FailedTests = 0;
+    for (u32 i = 0; i < ArrayCount(Tests); ++i)
+    {
+        u32 FailuresBefore = CheckFailures;
+        Tests[i].Run();
+
+        bool Passed = CheckFailures == FailuresBefore;
+        printf("%s: %s\n", Passed ? "PASS" : "FAIL", Tests[i].Name);
+        FailedTests += Passed ? 0 : 1;
+    }
+
+    // @Note(Victor): Same as the programs, everything allocated is freed again
+    Check(CPUMemory == 0);
+
+    return FailedTests + (CPUMemory == 0 ? 0 : 1);
+}
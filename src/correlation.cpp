@@ -0,0 +1,965 @@
+// Angular two-point correlation ------------------------------------------------------
+// @Note(Victor): This is the calculation the course is about. DD, DR and RR are the histograms of the
+// angles between every (ordered) pair of galaxies, real-real, real-random and random-random.
+// Then omega(theta) = (DD - 2DR + RR) / RR tells how much more clustered the real galaxies are
+// than a uniform distribution at that angle.
+//
+// Instead of calling acos for every pair we compare the dot product of the unit vectors against
+// the precomputed cos(bin edge) values. A small lookup table gives a first guess of the bin and
+// one compare against each edge of that bin corrects it.
+//
+// The table is indexed by the chord length sqrt(2 - 2|dot|) (to the other point, or to its antipode
+// when dot < 0). Unlike the dot product itself the chord grows about linearly with the angle near
+// 0 and 180 degrees, so a cell never spans more than one bin edge and the whole table fits in L1.
+
+#include <algorithm>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CORRELATION_HAS_AVX2 1
+#else
+#define CORRELATION_HAS_AVX2 0
+#endif
+
+const u32 CORRELATION_BIN_COUNT = 720; // 0 to 180 degrees
+const f64 CORRELATION_BIN_WIDTH_DEGREES = 0.25;
+
+// @Note(Victor): Cells per unit of chord length. A cell is then at most 1.4e-3 radians wide, the bins are 4.4e-3.
+const f64 CORRELATION_LOOKUP_CELL_SCALE = 1000.0;
+const u32 CORRELATION_LOOKUP_HALF_CELLS = 1416 + 1; // sqrt(2) * CellScale, rounded up
+const u32 CORRELATION_LOOKUP_CELL_COUNT = 2 * CORRELATION_LOOKUP_HALF_CELLS;
+
+// @Note(Victor): Rows of the outer loop that one job block takes, and how many columns of the inner
+// loop we walk before moving to the next row (keeps the columns in L2)
+const u64 CORRELATION_ROW_BLOCK = 64;
+const u64 CORRELATION_COLUMN_TILE = 2048;
+
+// @Note(Victor): Each thread spreads its increments over a few copies of the histogram so that
+// back to back increments of the same bin don't wait on each other
+const u32 CORRELATION_HISTOGRAM_COPIES = 4;
+
+struct CorrelationResult
+{
+    u64 DD[CORRELATION_BIN_COUNT];
+    u64 DR[CORRELATION_BIN_COUNT];
+    u64 RR[CORRELATION_BIN_COUNT];
+    f64 Omega[CORRELATION_BIN_COUNT];
+
+    u64 DataCount;
+    u64 RandomCount;
+    f64 Seconds;
+};
+
+// Structure of arrays so the kernel can load 4 x, 4 y and 4 z at a time
+struct UnitVectors
+{
+    u64 Count;
+    f64 *X;
+    f64 *Y;
+    f64 *Z;
+};
+
+struct CorrelationLookup
+{
+    // CosEdge[k] = cos(k * BinWidth), with +-inf at the ends so the first and last bins have no outer edge
+    f64 CosEdge[CORRELATION_BIN_COUNT + 1];
+    // Bin of each cell center, cells [0, Half) are for dot >= 0 and [Half, 2 * Half) for dot < 0
+    i32 CellBin[CORRELATION_LOOKUP_CELL_COUNT];
+};
+
+internal void
+InitCorrelationLookup(CorrelationLookup *Lookup)
+{
+    for (u32 k = 0; k <= CORRELATION_BIN_COUNT; ++k)
+    {
+        Lookup->CosEdge[k] = cos(k * CORRELATION_BIN_WIDTH_DEGREES * PIdividedBy180);
+    }
+
+    Lookup->CosEdge[0] = INFINITY;
+    Lookup->CosEdge[CORRELATION_BIN_COUNT] = -INFINITY;
+
+    for (u32 Cell = 0; Cell < CORRELATION_LOOKUP_CELL_COUNT; ++Cell)
+    {
+        bool IsNegative = Cell >= CORRELATION_LOOKUP_HALF_CELLS;
+        f64 Chord = ((Cell % CORRELATION_LOOKUP_HALF_CELLS) + 0.5) / CORRELATION_LOOKUP_CELL_SCALE;
+        f64 AbsDot = 1.0 - 0.5 * Chord * Chord;
+        f64 CellCenter = IsNegative ? -AbsDot : AbsDot;
+
+        u32 Bin = 0;
+        while (CellCenter <= Lookup->CosEdge[Bin + 1])
+        {
+            Bin++;
+        }
+
+        Lookup->CellBin[Cell] = (i32)Bin;
+    }
+}
+
+// @Note(Victor): Bin of the angle with the given cosine. The correction is branchless and at most one step.
+internal inline u32
+CorrelationBin(const CorrelationLookup *Lookup, f64 Dot)
+{
+    f64 OneMinusAbsDot = 1.0 - fabs(Dot);
+    OneMinusAbsDot = OneMinusAbsDot < 0.0 ? 0.0 : OneMinusAbsDot;
+
+    u32 Cell = (u32)(sqrt(2.0 * OneMinusAbsDot) * CORRELATION_LOOKUP_CELL_SCALE);
+    Cell += (Dot < 0.0) ? CORRELATION_LOOKUP_HALF_CELLS : 0;
+
+    i32 Bin = Lookup->CellBin[Cell];
+    Bin += (Dot <= Lookup->CosEdge[Bin + 1]) - (Dot > Lookup->CosEdge[Bin]);
+
+    return (u32)Bin;
+}
+
+// The first Count galaxies of an arcmin catalog as unit vectors
+internal void
+ArcminToUnitVectors(const Catalog *DataPoints, u64 Count, UnitVectors *Vectors)
+{
+    Vectors->Count = Count;
+    Vectors->X = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    Vectors->Y = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    Vectors->Z = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    CPUMemory += 3 * Count * sizeof(f64);
+
+    ParallelFor(Count, 16384, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            f64 RightAscensionRad = (GetCatalogRightAscension(DataPoints, i) / 60.0) * PIdividedBy180;
+            f64 DeclinationRad = (GetCatalogDeclination(DataPoints, i) / 60.0) * PIdividedBy180;
+
+            Vectors->X[i] = cos(DeclinationRad) * cos(RightAscensionRad);
+            Vectors->Y[i] = cos(DeclinationRad) * sin(RightAscensionRad);
+            Vectors->Z[i] = sin(DeclinationRad);
+        } });
+}
+
+internal void
+FreeUnitVectors(UnitVectors *Vectors)
+{
+    AlignedFree(Vectors->X);
+    AlignedFree(Vectors->Y);
+    AlignedFree(Vectors->Z);
+    CPUMemory -= 3 * Vectors->Count * sizeof(f64);
+
+    *Vectors = {};
+}
+
+// Histogram the angles between row I and columns [Begin, End) of B
+internal void
+CorrelationRowScalar(const CorrelationLookup *Lookup, f64 Xi, f64 Yi, f64 Zi,
+                     const UnitVectors *B, u64 Begin, u64 End, u64 *Histograms)
+{
+    for (u64 j = Begin; j < End; ++j)
+    {
+        f64 Dot = Xi * B->X[j] + Yi * B->Y[j] + Zi * B->Z[j];
+        u32 Copy = j & (CORRELATION_HISTOGRAM_COPIES - 1);
+        Histograms[Copy * CORRELATION_BIN_COUNT + CorrelationBin(Lookup, Dot)]++;
+    }
+}
+
+#if CORRELATION_HAS_AVX2
+__attribute__((target("avx2"))) internal void
+CorrelationRowAVX2(const CorrelationLookup *Lookup, f64 Xi, f64 Yi, f64 Zi,
+                   const UnitVectors *B, u64 Begin, u64 End, u64 *Histograms)
+{
+    // Peel until j is a multiple of 4 so the loads are aligned and the copy index is the lane index
+    u64 j = Begin;
+    u64 Head = (Begin + 3) & ~3ULL;
+    Head = Head > End ? End : Head;
+    CorrelationRowScalar(Lookup, Xi, Yi, Zi, B, j, Head, Histograms);
+    j = Head;
+
+    const __m256d VXi = _mm256_set1_pd(Xi);
+    const __m256d VYi = _mm256_set1_pd(Yi);
+    const __m256d VZi = _mm256_set1_pd(Zi);
+    const __m256d One = _mm256_set1_pd(1.0);
+    const __m256d Two = _mm256_set1_pd(2.0);
+    const __m256d ZeroPd = _mm256_setzero_pd();
+    const __m256d SignBit = _mm256_set1_pd(-0.0);
+    const __m256d AllLanesPd = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    const __m256d CellScale = _mm256_set1_pd(CORRELATION_LOOKUP_CELL_SCALE);
+    const __m128i HalfCells = _mm_set1_epi32(CORRELATION_LOOKUP_HALF_CELLS);
+    const __m128i Zero = _mm_setzero_si128();
+    const __m128i AllLanes = _mm_set1_epi32(-1);
+    const __m128i BinOne = _mm_set1_epi32(1);
+
+    for (; j + 4 <= End; j += 4)
+    {
+        // @Note(Victor): No FMA on purpose, the dot product must round exactly like the scalar one
+        // so a pair lands in the same bin whichever kernel (or tail loop) handles it
+        __m256d Dot = _mm256_mul_pd(VXi, _mm256_load_pd(B->X + j));
+        Dot = _mm256_add_pd(Dot, _mm256_mul_pd(VYi, _mm256_load_pd(B->Y + j)));
+        Dot = _mm256_add_pd(Dot, _mm256_mul_pd(VZi, _mm256_load_pd(B->Z + j)));
+
+        // Chord length cell, clamped since rounding can push |dot| a hair above 1
+        __m256d OneMinusAbsDot = _mm256_max_pd(_mm256_sub_pd(One, _mm256_andnot_pd(SignBit, Dot)), ZeroPd);
+        __m256d Chord = _mm256_sqrt_pd(_mm256_mul_pd(Two, OneMinusAbsDot));
+        __m128i Cell = _mm256_cvttpd_epi32(_mm256_mul_pd(Chord, CellScale));
+
+        __m128i IsNegative = _mm256_cvtpd_epi32(_mm256_and_pd(_mm256_cmp_pd(Dot, ZeroPd, _CMP_LT_OQ), One));
+        Cell = _mm_add_epi32(Cell, _mm_mullo_epi32(IsNegative, HalfCells));
+
+        // @Note(Victor): The masked gathers with an explicit source, the plain ones trip -Wmaybe-uninitialized on GCC
+        __m128i Bin = _mm_mask_i32gather_epi32(Zero, Lookup->CellBin, Cell, AllLanes, 4);
+        __m256d Lower = _mm256_mask_i32gather_pd(ZeroPd, Lookup->CosEdge, _mm_add_epi32(Bin, BinOne), AllLanesPd, 8);
+        __m256d Upper = _mm256_mask_i32gather_pd(ZeroPd, Lookup->CosEdge, Bin, AllLanesPd, 8);
+
+        // 1.0 masked with a compare is 1 or 0 per lane: step one bin down or up from the cell's bin
+        __m128i StepDown = _mm256_cvtpd_epi32(_mm256_and_pd(_mm256_cmp_pd(Dot, Lower, _CMP_LE_OQ), One));
+        __m128i StepUp = _mm256_cvtpd_epi32(_mm256_and_pd(_mm256_cmp_pd(Dot, Upper, _CMP_GT_OQ), One));
+        Bin = _mm_sub_epi32(_mm_add_epi32(Bin, StepDown), StepUp);
+
+        alignas(16) i32 Bins[4];
+        _mm_store_si128((__m128i *)Bins, Bin);
+
+        Histograms[0 * CORRELATION_BIN_COUNT + Bins[0]]++;
+        Histograms[1 * CORRELATION_BIN_COUNT + Bins[1]]++;
+        Histograms[2 * CORRELATION_BIN_COUNT + Bins[2]]++;
+        Histograms[3 * CORRELATION_BIN_COUNT + Bins[3]]++;
+    }
+
+    CorrelationRowScalar(Lookup, Xi, Yi, Zi, B, j, End, Histograms);
+}
+#endif
+
+typedef void CorrelationRowKernel(const CorrelationLookup *Lookup, f64 Xi, f64 Yi, f64 Zi,
+                                  const UnitVectors *B, u64 Begin, u64 End, u64 *Histograms);
+
+internal CorrelationRowKernel *
+GetCorrelationRowKernel(void)
+{
+#if CORRELATION_HAS_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return CorrelationRowAVX2;
+    }
+#endif
+    return CorrelationRowScalar;
+}
+
+// @Note(Victor): Counts every ordered pair (i, j) of A x B into Histogram, including i == j when
+// IsAutoCorrelation. For the auto correlation only j > i is computed and then counted twice.
+internal void
+CountAngularPairs(const CorrelationLookup *Lookup, const UnitVectors *A, const UnitVectors *B,
+                  bool IsAutoCorrelation, u64 *Histogram)
+{
+    u32 ThreadCount = GetThreadCount();
+    u64 HistogramSize = CORRELATION_HISTOGRAM_COPIES * CORRELATION_BIN_COUNT;
+    u64 *ThreadHistograms = (u64 *)AlignedAlloc(64, ThreadCount * HistogramSize * sizeof(u64));
+    memset(ThreadHistograms, 0, ThreadCount * HistogramSize * sizeof(u64));
+
+    CorrelationRowKernel *RowKernel = GetCorrelationRowKernel();
+
+    ParallelFor(A->Count, CORRELATION_ROW_BLOCK, [&](u64 RowBegin, u64 RowEnd, u32 ThreadIndex)
+                {
+        u64 *Histograms = ThreadHistograms + ThreadIndex * HistogramSize;
+
+        u64 ColumnStart = IsAutoCorrelation ? RowBegin + 1 : 0;
+        for (u64 TileBegin = ColumnStart; TileBegin < B->Count; TileBegin += CORRELATION_COLUMN_TILE)
+        {
+            u64 TileEnd = TileBegin + CORRELATION_COLUMN_TILE;
+            TileEnd = TileEnd > B->Count ? B->Count : TileEnd;
+
+            for (u64 i = RowBegin; i < RowEnd; ++i)
+            {
+                u64 Begin = TileBegin;
+                if (IsAutoCorrelation && Begin < i + 1)
+                {
+                    Begin = i + 1;
+                }
+
+                if (Begin < TileEnd)
+                {
+                    RowKernel(Lookup, A->X[i], A->Y[i], A->Z[i], B, Begin, TileEnd, Histograms);
+                }
+            }
+        } });
+
+    memset(Histogram, 0, CORRELATION_BIN_COUNT * sizeof(u64));
+    for (u64 Copy = 0; Copy < ThreadCount * CORRELATION_HISTOGRAM_COPIES; ++Copy)
+    {
+        for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+        {
+            Histogram[Bin] += ThreadHistograms[Copy * CORRELATION_BIN_COUNT + Bin];
+        }
+    }
+
+    if (IsAutoCorrelation)
+    {
+        for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+        {
+            Histogram[Bin] *= 2;
+        }
+
+        // Every galaxy with itself, the angle is 0
+        Histogram[0] += A->Count;
+    }
+
+    AlignedFree(ThreadHistograms);
+}
+
+// Pair counting trees -------------------------------------------------------------------
+// @Note(Victor): CountAngularPairs looks at every pair, so twice the galaxies is four times the work.
+// With a tree over the unit vectors most of the pairs never have to be looked at one by one: a node
+// is a ball on the sphere (a center and the largest angle to any of its points), and when every
+// angle between the points of two nodes falls in the same bin the node pair goes into that bin as
+// A.Count * B.Count at once. Only the node pairs that straddle a bin edge are opened up, down to two
+// leaves that go through the same row kernel as the brute force.
+//
+// The tree counts exactly what CountAngularPairs counts, bit for bit:
+// - A pair's dot product is computed by the row kernel like before, x * x + y * y + z * z is the same
+//   whichever point is the row, so the order of the points in the tree doesn't matter.
+// - A node pair is only counted whole when its dot product range, widened by CORRELATION_TREE_DOT_MARGIN
+//   for the rounding of the bounds and of the kernel, sits in one bin.
+//
+// The node pairs only get small enough to fit in a bin where the galaxies are dense, so the more
+// galaxies on the same patch of sky the more of their pairs are counted whole. On the course catalogs
+// (100k galaxies on 1500 square degrees) it is about even with the brute force, the win is at millions.
+//
+// The traversal is split into tasks: the top node pairs are opened breadth first until there are
+// plenty of them, and then every task walks its own node pairs down on one thread.
+
+const u64 CORRELATION_TREE_LEAF_SIZE = 32;
+const u32 CORRELATION_TREE_TASKS_PER_THREAD = 64;
+
+// @Note(Victor): The rounding of the bounds and of the kernel's dot products is around 1e-15,
+// the bin edges are at least 1.9e-5 apart in dot product
+const f64 CORRELATION_TREE_DOT_MARGIN = 1e-12;
+
+// Half a bin in radians, two nodes whose radii add up to more span at least two bins
+const f64 CORRELATION_TREE_MAX_RADIUS_SUM = 0.5 * CORRELATION_BIN_WIDTH_DEGREES * PIdividedBy180;
+
+// @Note(Victor): Limits of IsDirectNodePair
+const u64 CORRELATION_TREE_DIRECT_PAIRS = 256 * 256;
+const f64 CORRELATION_TREE_DIRECT_RADIUS_SUM = 2.0 * CORRELATION_TREE_MAX_RADIUS_SUM;
+
+struct CorrelationTreeNode
+{
+    f64 Center[3];
+    f64 Radius; // Largest angle between the center and a point of the node
+    f64 CosRadius;
+    f64 SinRadius;
+
+    // Points [First, First + Count) of the tree ordered vectors
+    u64 First;
+    u64 Count;
+
+    // 0 for a leaf. The nodes are in depth first order, Left is the next node.
+    u32 Left;
+    u32 Right;
+};
+
+struct CorrelationTree
+{
+    UnitVectors Points; // In tree order, every node's points are next to each other
+    CorrelationTreeNode *Nodes;
+    u32 NodeCount;
+};
+
+struct CorrelationTreePoint
+{
+    f64 Position[3];
+};
+
+// @Note(Victor): Every split is at the median, so the size of a subtree only depends on its point count
+// and the whole tree can be laid out before it is built
+internal u32
+GetCorrelationTreeNodeCount(u64 Count)
+{
+    if (Count <= CORRELATION_TREE_LEAF_SIZE)
+    {
+        return 1;
+    }
+
+    return 1 + GetCorrelationTreeNodeCount(Count / 2) + GetCorrelationTreeNodeCount(Count - Count / 2);
+}
+
+// Fills the bounds of the node from its points and, unless it is a leaf, splits them in two at the
+// median of the widest axis and sets up the ranges of the two children
+internal void
+BuildCorrelationTreeNode(CorrelationTreePoint *Points, CorrelationTreeNode *Nodes, u32 NodeIndex)
+{
+    CorrelationTreeNode *Node = &Nodes[NodeIndex];
+    CorrelationTreePoint *First = Points + Node->First;
+    u64 Count = Node->Count;
+
+    f64 Sum[3] = {};
+    f64 Min[3] = {INFINITY, INFINITY, INFINITY};
+    f64 Max[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (u64 i = 0; i < Count; ++i)
+    {
+        for (u32 Axis = 0; Axis < 3; ++Axis)
+        {
+            f64 Value = First[i].Position[Axis];
+            Sum[Axis] += Value;
+            Min[Axis] = Value < Min[Axis] ? Value : Min[Axis];
+            Max[Axis] = Value > Max[Axis] ? Value : Max[Axis];
+        }
+    }
+
+    f64 SumLength = sqrt(Sum[0] * Sum[0] + Sum[1] * Sum[1] + Sum[2] * Sum[2]);
+    if (SumLength > 0.0)
+    {
+        Node->Center[0] = Sum[0] / SumLength;
+        Node->Center[1] = Sum[1] / SumLength;
+        Node->Center[2] = Sum[2] / SumLength;
+    }
+    else
+    {
+        // Points all around the sphere, any center will do
+        Node->Center[0] = 1.0;
+        Node->Center[1] = 0.0;
+        Node->Center[2] = 0.0;
+    }
+
+    // @Note(Victor): The radius from the longest chord, 2 asin(chord / 2) stays accurate for the tiny
+    // nodes where acos(dot) would lose half of its digits
+    f64 MaxChordSquared = 0.0;
+    for (u64 i = 0; i < Count; ++i)
+    {
+        f64 DX = First[i].Position[0] - Node->Center[0];
+        f64 DY = First[i].Position[1] - Node->Center[1];
+        f64 DZ = First[i].Position[2] - Node->Center[2];
+        f64 ChordSquared = DX * DX + DY * DY + DZ * DZ;
+        MaxChordSquared = ChordSquared > MaxChordSquared ? ChordSquared : MaxChordSquared;
+    }
+
+    f64 HalfChord = 0.5 * sqrt(MaxChordSquared);
+    Node->Radius = 2.0 * asin(HalfChord < 1.0 ? HalfChord : 1.0);
+    Node->CosRadius = cos(Node->Radius);
+    Node->SinRadius = sin(Node->Radius);
+
+    Node->Left = 0;
+    Node->Right = 0;
+    if (Count <= CORRELATION_TREE_LEAF_SIZE)
+    {
+        return;
+    }
+
+    u32 SplitAxis = 0;
+    for (u32 Axis = 1; Axis < 3; ++Axis)
+    {
+        if (Max[Axis] - Min[Axis] > Max[SplitAxis] - Min[SplitAxis])
+        {
+            SplitAxis = Axis;
+        }
+    }
+
+    u64 LeftCount = Count / 2;
+    std::nth_element(First, First + LeftCount, First + Count,
+                     [SplitAxis](const CorrelationTreePoint &A, const CorrelationTreePoint &B)
+                     { return A.Position[SplitAxis] < B.Position[SplitAxis]; });
+
+    Node->Left = NodeIndex + 1;
+    Node->Right = Node->Left + GetCorrelationTreeNodeCount(LeftCount);
+
+    Nodes[Node->Left].First = Node->First;
+    Nodes[Node->Left].Count = LeftCount;
+    Nodes[Node->Right].First = Node->First + LeftCount;
+    Nodes[Node->Right].Count = Count - LeftCount;
+}
+
+internal void
+BuildCorrelationSubtree(CorrelationTreePoint *Points, CorrelationTreeNode *Nodes, u32 NodeIndex)
+{
+    BuildCorrelationTreeNode(Points, Nodes, NodeIndex);
+
+    if (Nodes[NodeIndex].Left != 0)
+    {
+        BuildCorrelationSubtree(Points, Nodes, Nodes[NodeIndex].Left);
+        BuildCorrelationSubtree(Points, Nodes, Nodes[NodeIndex].Right);
+    }
+}
+
+internal void
+BuildCorrelationTree(const UnitVectors *Vectors, CorrelationTree *Tree)
+{
+    u64 Count = Vectors->Count;
+
+    CorrelationTreePoint *Points = (CorrelationTreePoint *)malloc((Count > 0 ? Count : 1) * sizeof(CorrelationTreePoint));
+    CPUMemory += Count * sizeof(CorrelationTreePoint);
+
+    ParallelFor(Count, 16384, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            Points[i].Position[0] = Vectors->X[i];
+            Points[i].Position[1] = Vectors->Y[i];
+            Points[i].Position[2] = Vectors->Z[i];
+        } });
+
+    Tree->NodeCount = GetCorrelationTreeNodeCount(Count);
+    Tree->Nodes = (CorrelationTreeNode *)malloc(Tree->NodeCount * sizeof(CorrelationTreeNode));
+    CPUMemory += Tree->NodeCount * sizeof(CorrelationTreeNode);
+
+    Tree->Nodes[0].First = 0;
+    Tree->Nodes[0].Count = Count;
+
+    // @Note(Victor): The top of the tree one node at a time (each one is a pass over many points anyway),
+    // then the subtrees below it in parallel
+    u32 SubtreeTarget = 8 * GetThreadCount();
+    u32 SubtreeCapacity = 4 * SubtreeTarget + 2; // Breadth first, the top levels are at most 2 * Target nodes
+    u32 *Subtrees = (u32 *)malloc(SubtreeCapacity * sizeof(u32));
+    u32 SubtreeCount = 0;
+    u32 FirstSubtree = 0;
+    Subtrees[SubtreeCount++] = 0;
+
+    while (FirstSubtree < SubtreeCount && SubtreeCount - FirstSubtree < SubtreeTarget)
+    {
+        u32 NodeIndex = Subtrees[FirstSubtree++];
+        BuildCorrelationTreeNode(Points, Tree->Nodes, NodeIndex);
+
+        if (Tree->Nodes[NodeIndex].Left != 0)
+        {
+            Assert(SubtreeCount + 2 <= SubtreeCapacity);
+            Subtrees[SubtreeCount++] = Tree->Nodes[NodeIndex].Left;
+            Subtrees[SubtreeCount++] = Tree->Nodes[NodeIndex].Right;
+        }
+    }
+
+    ParallelFor(SubtreeCount - FirstSubtree, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 s = Begin; s < End; ++s)
+        {
+            BuildCorrelationSubtree(Points, Tree->Nodes, Subtrees[FirstSubtree + s]);
+        } });
+
+    free(Subtrees);
+
+    Tree->Points.Count = Count;
+    Tree->Points.X = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    Tree->Points.Y = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    Tree->Points.Z = (f64 *)AlignedAlloc(64, Count * sizeof(f64));
+    CPUMemory += 3 * Count * sizeof(f64);
+
+    ParallelFor(Count, 16384, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            Tree->Points.X[i] = Points[i].Position[0];
+            Tree->Points.Y[i] = Points[i].Position[1];
+            Tree->Points.Z[i] = Points[i].Position[2];
+        } });
+
+    free(Points);
+    CPUMemory -= Count * sizeof(CorrelationTreePoint);
+}
+
+internal void
+FreeCorrelationTree(CorrelationTree *Tree)
+{
+    FreeUnitVectors(&Tree->Points);
+
+    free(Tree->Nodes);
+    CPUMemory -= Tree->NodeCount * sizeof(CorrelationTreeNode);
+
+    *Tree = {};
+}
+
+// @Note(Victor): The bin that every pair of points of the two nodes falls in, or -1 when they may
+// spread over more than one. With c the angle between the centers and r the sum of the radii the
+// angles are within [c - r, c + r], as dot products cos(c -+ r) = cos c cos r +- sin c sin r.
+internal i32
+GetNodePairBin(const CorrelationLookup *Lookup, const CorrelationTreeNode *A, const CorrelationTreeNode *B)
+{
+    if (A->Radius + B->Radius >= CORRELATION_TREE_MAX_RADIUS_SUM)
+    {
+        return -1;
+    }
+
+    f64 CosRadii = A->CosRadius * B->CosRadius - A->SinRadius * B->SinRadius;
+    f64 SinRadii = A->SinRadius * B->CosRadius + A->CosRadius * B->SinRadius;
+
+    const f64 *P = A->Center;
+    const f64 *Q = B->Center;
+    f64 CosCenters = P[0] * Q[0] + P[1] * Q[1] + P[2] * Q[2];
+    f64 CrossX = P[1] * Q[2] - P[2] * Q[1];
+    f64 CrossY = P[2] * Q[0] - P[0] * Q[2];
+    f64 CrossZ = P[0] * Q[1] - P[1] * Q[0];
+    f64 SinCenters = sqrt(CrossX * CrossX + CrossY * CrossY + CrossZ * CrossZ);
+
+    // c - r below 0 or c + r above 180 degrees, the range reaches the end of the dot products
+    f64 DotMax = (CosCenters >= CosRadii) ? 1.0 : CosCenters * CosRadii + SinCenters * SinRadii;
+    f64 DotMin = (CosCenters <= -CosRadii) ? -1.0 : CosCenters * CosRadii - SinCenters * SinRadii;
+
+    u32 SmallestBin = CorrelationBin(Lookup, DotMax + CORRELATION_TREE_DOT_MARGIN);
+    u32 LargestBin = CorrelationBin(Lookup, DotMin - CORRELATION_TREE_DOT_MARGIN);
+
+    return (SmallestBin == LargestBin) ? (i32)SmallestBin : -1;
+}
+
+// Two leaves, or nodes too wide to be counted whole even a level or two down where opening them up
+// would only make the rows shorter, go point by point
+internal bool
+IsDirectNodePair(const CorrelationTreeNode *A, const CorrelationTreeNode *B)
+{
+    bool IsLeafPair = A->Left == 0 && B->Left == 0;
+    bool IsSmall = A->Count * B->Count <= CORRELATION_TREE_DIRECT_PAIRS;
+    bool IsWide = A->Radius + B->Radius >= CORRELATION_TREE_DIRECT_RADIUS_SUM;
+
+    return IsLeafPair || (IsSmall && IsWide);
+}
+
+struct CorrelationNodePair
+{
+    u32 A;
+    u32 B;
+};
+
+struct CorrelationTreePass
+{
+    const CorrelationLookup *Lookup;
+    CorrelationRowKernel *RowKernel;
+    const CorrelationTree *A;
+    const CorrelationTree *B;
+
+    // A and B are the same tree, only the node pairs with A <= B are visited and a node with itself
+    // only counts its pairs i < j, like CountAngularPairs
+    bool IsAutoCorrelation;
+};
+
+// @Note(Victor): One step of the traversal. A pair that falls in one bin is counted whole and a direct
+// pair point by point, then it returns 0. Otherwise the pairs of its children go in Children
+// and it returns how many (3 for a node with itself, else 2).
+internal u32
+VisitNodePair(const CorrelationTreePass *Pass, CorrelationNodePair Pair, u64 *Histograms,
+              CorrelationNodePair *Children)
+{
+    const CorrelationTreeNode *A = &Pass->A->Nodes[Pair.A];
+    const CorrelationTreeNode *B = &Pass->B->Nodes[Pair.B];
+    bool IsSelf = Pass->IsAutoCorrelation && Pair.A == Pair.B;
+
+    i32 Bin = GetNodePairBin(Pass->Lookup, A, B);
+    if (Bin >= 0)
+    {
+        Histograms[Bin] += IsSelf ? A->Count * (A->Count - 1) / 2 : A->Count * B->Count;
+        return 0;
+    }
+
+    if (!IsDirectNodePair(A, B))
+    {
+        if (IsSelf)
+        {
+            Children[0] = {A->Left, A->Left};
+            Children[1] = {A->Left, A->Right};
+            Children[2] = {A->Right, A->Right};
+            return 3;
+        }
+
+        // Open up the wider node, as long as it isn't a leaf
+        if (A->Left != 0 && (B->Left == 0 || A->Radius >= B->Radius))
+        {
+            Children[0] = {A->Left, Pair.B};
+            Children[1] = {A->Right, Pair.B};
+            return 2;
+        }
+
+        Children[0] = {Pair.A, B->Left};
+        Children[1] = {Pair.A, B->Right};
+        return 2;
+    }
+
+    const UnitVectors *PointsA = &Pass->A->Points;
+    const UnitVectors *PointsB = &Pass->B->Points;
+    for (u64 i = A->First; i < A->First + A->Count; ++i)
+    {
+        u64 Begin = IsSelf ? i + 1 : B->First;
+        Pass->RowKernel(Pass->Lookup, PointsA->X[i], PointsA->Y[i], PointsA->Z[i], PointsB,
+                        Begin, B->First + B->Count, Histograms);
+    }
+
+    return 0;
+}
+
+internal void
+CountNodePair(const CorrelationTreePass *Pass, CorrelationNodePair Pair, u64 *Histograms)
+{
+    CorrelationNodePair Children[3];
+    u32 ChildCount = VisitNodePair(Pass, Pair, Histograms, Children);
+
+    for (u32 Child = 0; Child < ChildCount; ++Child)
+    {
+        CountNodePair(Pass, Children[Child], Histograms);
+    }
+}
+
+// @Note(Victor): Same result as CountAngularPairs on the vectors the trees were built from
+internal void
+CountAngularPairsTree(const CorrelationLookup *Lookup, const CorrelationTree *A, const CorrelationTree *B,
+                      bool IsAutoCorrelation, u64 *Histogram)
+{
+    u32 ThreadCount = GetThreadCount();
+    u64 HistogramSize = CORRELATION_HISTOGRAM_COPIES * CORRELATION_BIN_COUNT;
+    u64 *ThreadHistograms = (u64 *)AlignedAlloc(64, ThreadCount * HistogramSize * sizeof(u64));
+    memset(ThreadHistograms, 0, ThreadCount * HistogramSize * sizeof(u64));
+
+    CorrelationTreePass Pass = {};
+    Pass.Lookup = Lookup;
+    Pass.RowKernel = GetCorrelationRowKernel();
+    Pass.A = A;
+    Pass.B = B;
+    Pass.IsAutoCorrelation = IsAutoCorrelation;
+
+    // Breadth first until there are enough tasks to go around, a step at most triples them
+    u32 TaskTarget = CORRELATION_TREE_TASKS_PER_THREAD * ThreadCount;
+    u32 TaskCapacity = 3 * TaskTarget + 3;
+    CorrelationNodePair *Tasks = (CorrelationNodePair *)malloc(TaskCapacity * sizeof(CorrelationNodePair));
+    CorrelationNodePair *NextTasks = (CorrelationNodePair *)malloc(TaskCapacity * sizeof(CorrelationNodePair));
+    u32 TaskCount = 0;
+    if (A->Points.Count > 0 && B->Points.Count > 0)
+    {
+        Tasks[TaskCount++] = {0, 0};
+    }
+
+    bool Opened = true;
+    while (TaskCount < TaskTarget && Opened)
+    {
+        Opened = false;
+        u32 NextCount = 0;
+        for (u32 t = 0; t < TaskCount; ++t)
+        {
+            CorrelationNodePair Pair = Tasks[t];
+            if (IsDirectNodePair(&A->Nodes[Pair.A], &B->Nodes[Pair.B]))
+            {
+                // Nothing to open, the row kernel takes it in its task
+                NextTasks[NextCount++] = Pair;
+                continue;
+            }
+
+            NextCount += VisitNodePair(&Pass, Pair, ThreadHistograms, NextTasks + NextCount);
+            Opened = true;
+        }
+
+        CorrelationNodePair *Swap = Tasks;
+        Tasks = NextTasks;
+        NextTasks = Swap;
+        TaskCount = NextCount;
+    }
+
+    // The biggest tasks first so no thread is left with one at the end
+    std::sort(Tasks, Tasks + TaskCount, [A, B](const CorrelationNodePair &P, const CorrelationNodePair &Q)
+              { return A->Nodes[P.A].Count * B->Nodes[P.B].Count > A->Nodes[Q.A].Count * B->Nodes[Q.B].Count; });
+
+    ParallelFor(TaskCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        u64 *Histograms = ThreadHistograms + ThreadIndex * HistogramSize;
+        for (u64 t = Begin; t < End; ++t)
+        {
+            CountNodePair(&Pass, Tasks[t], Histograms);
+        } });
+
+    free(Tasks);
+    free(NextTasks);
+
+    memset(Histogram, 0, CORRELATION_BIN_COUNT * sizeof(u64));
+    for (u64 Copy = 0; Copy < ThreadCount * CORRELATION_HISTOGRAM_COPIES; ++Copy)
+    {
+        for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+        {
+            Histogram[Bin] += ThreadHistograms[Copy * CORRELATION_BIN_COUNT + Bin];
+        }
+    }
+
+    if (IsAutoCorrelation)
+    {
+        for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+        {
+            Histogram[Bin] *= 2;
+        }
+
+        // Every galaxy with itself, the angle is 0
+        Histogram[0] += A->Points.Count;
+    }
+
+    AlignedFree(ThreadHistograms);
+}
+
+internal void
+ComputeOmega(CorrelationResult *Result)
+{
+    // @Note(Victor): Normalized by the pair counts so catalogs of different sizes can be compared,
+    // with equal sizes this is the plain (DD - 2DR + RR) / RR from the course
+    f64 DataPairs = (f64)Result->DataCount * (f64)Result->DataCount;
+    f64 CrossPairs = (f64)Result->DataCount * (f64)Result->RandomCount;
+    f64 RandomPairs = (f64)Result->RandomCount * (f64)Result->RandomCount;
+
+    for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+    {
+        f64 DD = Result->DD[Bin] / DataPairs;
+        f64 DR = Result->DR[Bin] / CrossPairs;
+        f64 RR = Result->RR[Bin] / RandomPairs;
+
+        Result->Omega[Bin] = (Result->RR[Bin] > 0) ? (DD - 2.0 * DR + RR) / RR : 0.0;
+    }
+}
+
+// The brute force is kept as the reference the tree has to match
+enum Correlation_Counting
+{
+    CORRELATION_TREE,
+    CORRELATION_BRUTE_FORCE,
+};
+
+// Fills all three histograms and omega(theta) for the real (DataPoints) vs random (RandomPoints) catalog
+internal void
+ComputeAngularCorrelation(const Catalog *DataPoints, u64 DataCount,
+                          const Catalog *RandomPoints, u64 RandomCount,
+                          CorrelationResult *Result, Correlation_Counting Counting)
+{
+    f64 StartTime = GetWallClockSeconds();
+
+    CorrelationLookup *Lookup = (CorrelationLookup *)AlignedAlloc(64, sizeof(CorrelationLookup));
+    InitCorrelationLookup(Lookup);
+
+    UnitVectors Data = {};
+    UnitVectors Random = {};
+    ArcminToUnitVectors(DataPoints, DataCount, &Data);
+    ArcminToUnitVectors(RandomPoints, RandomCount, &Random);
+
+    Result->DataCount = DataCount;
+    Result->RandomCount = RandomCount;
+
+    if (Counting == CORRELATION_BRUTE_FORCE)
+    {
+        CountAngularPairs(Lookup, &Data, &Data, true, Result->DD);
+        CountAngularPairs(Lookup, &Data, &Random, false, Result->DR);
+        CountAngularPairs(Lookup, &Random, &Random, true, Result->RR);
+    }
+    else
+    {
+        CorrelationTree DataTree = {};
+        CorrelationTree RandomTree = {};
+        BuildCorrelationTree(&Data, &DataTree);
+        BuildCorrelationTree(&Random, &RandomTree);
+
+        CountAngularPairsTree(Lookup, &DataTree, &DataTree, true, Result->DD);
+        CountAngularPairsTree(Lookup, &DataTree, &RandomTree, false, Result->DR);
+        CountAngularPairsTree(Lookup, &RandomTree, &RandomTree, true, Result->RR);
+
+        FreeCorrelationTree(&DataTree);
+        FreeCorrelationTree(&RandomTree);
+    }
+
+    ComputeOmega(Result);
+
+    FreeUnitVectors(&Data);
+    FreeUnitVectors(&Random);
+    AlignedFree(Lookup);
+
+    Result->Seconds = GetWallClockSeconds() - StartTime;
+}
+
+internal void
+PrintCorrelationResult(const CorrelationResult *Result, u32 BinsToPrint)
+{
+    f64 Pairs = (f64)Result->DataCount * Result->DataCount +
+                (f64)Result->DataCount * Result->RandomCount +
+                (f64)Result->RandomCount * Result->RandomCount;
+
+    printf("\n\tAngular correlation of %lu real and %lu random galaxies\n",
+           (unsigned long)Result->DataCount, (unsigned long)Result->RandomCount);
+    printf("\t%.3e pairs in %.3f seconds (%.3e pairs/s)\n", Pairs, Result->Seconds, Pairs / Result->Seconds);
+    printf("\t%10s %14s %14s %14s %12s\n", "theta", "DD", "DR", "RR", "omega");
+
+    for (u32 Bin = 0; Bin < BinsToPrint && Bin < CORRELATION_BIN_COUNT; ++Bin)
+    {
+        printf("\t%10.2f %14lu %14lu %14lu %12.6f\n", Bin * CORRELATION_BIN_WIDTH_DEGREES,
+               (unsigned long)Result->DD[Bin], (unsigned long)Result->DR[Bin], (unsigned long)Result->RR[Bin],
+               Result->Omega[Bin]);
+    }
+}
+
+// Reference ---------------------------------------------------------------------------
+// @Note(Victor): The straightforward version, one acos per ordered pair. Only used to check the
+// engine on a subset of the catalogs, it is far too slow for the full ones.
+internal void
+NaiveAngularHistogram(const UnitVectors *A, const UnitVectors *B, u64 *Histogram)
+{
+    memset(Histogram, 0, CORRELATION_BIN_COUNT * sizeof(u64));
+
+    for (u64 i = 0; i < A->Count; ++i)
+    {
+        for (u64 j = 0; j < B->Count; ++j)
+        {
+            f64 Dot = A->X[i] * B->X[j] + A->Y[i] * B->Y[j] + A->Z[i] * B->Z[j];
+            Dot = Dot > 1.0 ? 1.0 : (Dot < -1.0 ? -1.0 : Dot);
+
+            f64 AngleDegrees = acos(Dot) / PIdividedBy180;
+            u32 Bin = (u32)(AngleDegrees / CORRELATION_BIN_WIDTH_DEGREES);
+            Bin = Bin >= CORRELATION_BIN_COUNT ? CORRELATION_BIN_COUNT - 1 : Bin;
+
+            Histogram[Bin]++;
+        }
+    }
+}
+
+// @Note(Victor): Pairs that sit exactly on a bin edge (it happens, the course data only has two
+// decimals) can land on either side depending on whether acos or cos rounds, so we allow a tiny
+// amount of pairs to move to a neighbouring bin. Everything else must match exactly.
+internal bool
+VerifyAngularCorrelation(const Catalog *DataPoints, const Catalog *RandomPoints, u64 SampleCount)
+{
+    CorrelationResult *Result = (CorrelationResult *)calloc(1, sizeof(CorrelationResult));
+    ComputeAngularCorrelation(DataPoints, SampleCount, RandomPoints, SampleCount, Result, CORRELATION_TREE);
+
+    // The tree has to count exactly what the brute force counts
+    CorrelationResult *BruteForce = (CorrelationResult *)calloc(1, sizeof(CorrelationResult));
+    ComputeAngularCorrelation(DataPoints, SampleCount, RandomPoints, SampleCount, BruteForce, CORRELATION_BRUTE_FORCE);
+
+    bool SameAsBruteForce = memcmp(Result->DD, BruteForce->DD, sizeof(Result->DD)) == 0 &&
+                            memcmp(Result->DR, BruteForce->DR, sizeof(Result->DR)) == 0 &&
+                            memcmp(Result->RR, BruteForce->RR, sizeof(Result->RR)) == 0;
+    printf("\tTree: %.3f seconds, brute force: %.3f seconds, histograms %s\n", Result->Seconds, BruteForce->Seconds,
+           SameAsBruteForce ? "identical: OK" : "differ: FAILED");
+
+    UnitVectors Data = {};
+    UnitVectors Random = {};
+    ArcminToUnitVectors(DataPoints, SampleCount, &Data);
+    ArcminToUnitVectors(RandomPoints, SampleCount, &Random);
+
+    f64 StartTime = GetWallClockSeconds();
+
+    u64 Reference[3][CORRELATION_BIN_COUNT];
+    NaiveAngularHistogram(&Data, &Data, Reference[0]);
+    NaiveAngularHistogram(&Data, &Random, Reference[1]);
+    NaiveAngularHistogram(&Random, &Random, Reference[2]);
+
+    f64 ReferenceSeconds = GetWallClockSeconds() - StartTime;
+
+    const u64 *Engine[3] = {Result->DD, Result->DR, Result->RR};
+    const char *Names[3] = {"DD", "DR", "RR"};
+
+    bool Success = SameAsBruteForce;
+    for (u32 h = 0; h < 3; ++h)
+    {
+        u64 EngineTotal = 0;
+        u64 ReferenceTotal = 0;
+        u64 MovedPairs = 0;
+        for (u32 Bin = 0; Bin < CORRELATION_BIN_COUNT; ++Bin)
+        {
+            EngineTotal += Engine[h][Bin];
+            ReferenceTotal += Reference[h][Bin];
+            MovedPairs += Engine[h][Bin] > Reference[h][Bin] ? Engine[h][Bin] - Reference[h][Bin]
+                                                             : Reference[h][Bin] - Engine[h][Bin];
+        }
+
+        // Every moved pair is counted once where it left and once where it arrived
+        MovedPairs /= 2;
+
+        bool HistogramOk = (EngineTotal == ReferenceTotal) && (MovedPairs * 1000000ULL <= ReferenceTotal);
+        printf("\t%s: %lu pairs, %lu on a different bin than the reference: %s\n", Names[h],
+               (unsigned long)ReferenceTotal, (unsigned long)MovedPairs, HistogramOk ? "OK" : "FAILED");
+
+        Success = Success && HistogramOk;
+    }
+
+    printf("\tEngine: %.3f seconds, reference: %.3f seconds\n", Result->Seconds, ReferenceSeconds);
+
+    FreeUnitVectors(&Data);
+    FreeUnitVectors(&Random);
+    free(BruteForce);
+    free(Result);
+
+    return Success;
+}
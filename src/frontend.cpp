@@ -6,22 +6,10 @@
 #include "raylib_includes.h"
 
 // Types -------------------------------------------------------------------------
-struct ArcminData
+enum Galaxy_Render_Mode
 {
-    f64 right_ascension = 0.0f;
-    f64 declination = 0.0f;
-    f64 redshift = 0.0f;
-};
-
-enum Draw_Data
-{
-    // Draw the data from the files from the ÅA course
-    DRAW_DATA_A,
-    DRAW_DATA_B,
-    DRAW_ALL_DATA,
-
-    // Draw the redshift data, not from the course
-    DRAW_REDSHIFT_DATA,
+    RENDER_MESHES,
+    RENDER_IMPOSTORS,
 };
 
 // Variables ---------------------------------------------------------------------
@@ -31,8 +19,10 @@ i32 SCREEN_HEIGHT = 360 * 2;
 bool Debug = false;
 bool DataAIsLoaded = false;
 bool IsPaused = false;
+bool RunCorrelation = false;
+bool RunCorrelationCheck = false;
 
-u64 CPUMemory = 0L;
+std::atomic<u64> CPUMemory{0}; // @Note(Victor): Atomic, the loader thread allocates too
 
 constexpr f64 PIdividedBy180 = (PI / 180.0);
 
@@ -45,86 +35,149 @@ Font MainFont = {0};
 Camera3D MainCamera = {};
 f64 Zoom = 1.0f * PI;
 
-const unsigned long int MAX_DATA_POINTS = 100000UL;
-unsigned long int MAX_REDSHIFT_DATA_POINTS = 100000UL; // @Note(Victor): This is set when we read the redshift data
-
-// @Note(Victor): Data from the course, only celestial coordinates, no redshift (distance)
-ArcminData *DataPointsA = nullptr;
-ArcminData *DataPointsB = nullptr;
-
-// @Note(Victor): Data from the redshift file with the appriximated distances to the galaxies
-ArcminData *RedshiftData = nullptr;
-
-// Batch rendering in Raylib with a custom shader
-Matrix *MatrixTransformsA = nullptr;
-Matrix *MatrixTransformsB = nullptr;
-Matrix *MatrixTransformsRedshift = nullptr;
-
-Shader CustomShader = {0};
-
-Draw_Data DataToDraw = DRAW_ALL_DATA;
-
 // Define mesh to be instanced
 Material matInstances;
-Mesh SphereMesh;
+
+// @Note(Victor): Camera facing quads with a sphere drawn on them by the fragment shader
+Material matImpostors;
+Mesh ImpostorMesh;
+Galaxy_Render_Mode RenderMode = RENDER_MESHES;
 
 // 3D Models
 Model EarthModel;
 
-// Redshift data calculations
-// ----------------------------------------------------------------------------------
-// Function to convert RA from HHMMSS to degrees
-internal f64
-ConvertRaToDegrees(f64 raHHMMSS)
+// Modules -----------------------------------------------------------------------
+#include "parallel.cpp"
+#include "profiler.cpp"
+#include "memory_arena.cpp"
+#include "catalog.cpp"
+#include "catalog_loader.cpp"
+#include "redshift_catalog.cpp"
+#include "catalog_cache.cpp"
+#include "catalog_generator.cpp"
+#include "correlation.cpp"
+#include "instancing.cpp"
+#include "shading.cpp"
+#include "angle_kernels.cpp"
+#include "instance_builder.cpp"
+#include "spatial_index.cpp"
+#include "catalog_streaming.cpp"
+#include "sky_density.cpp"
+#include "bench.cpp"
+#include "camera_replay.cpp"
+
+// Catalogs ----------------------------------------------------------------------
+// @Note(Victor): Everything of every catalog, from the parsed columns to the GPU buffers, filled in by the
+// loader thread while the window is up (see catalog_streaming.cpp). 1 to 9 show and hide them.
+CatalogRegistry Catalogs = {};
+CatalogLoader Loader = {};
+
+// The catalogs every run has, their ids in the registry
+const u32 CATALOG_A = 0;        // Data from the course, only celestial coordinates, no redshift (distance)
+const u32 CATALOG_B = 1;
+const u32 CATALOG_REDSHIFT = 2; // Data from the redshift file with the appriximated distances to the galaxies
+
+// @Note(Victor): GALAXY_CATALOG=file (arcmin or .gcat) and GALAXY_REDSHIFT_CATALOG=file add more catalogs
+// after those, colored from CATALOG_PALETTE
+struct ExtraCatalog
 {
-    int hours = (int)(raHHMMSS / 10000);
-    int minutes = (int)((raHHMMSS - (hours * 10000)) / 100);
-    f64 seconds = raHHMMSS - (hours * 10000) - (minutes * 100);
-
-    return 15.0 * (hours + (minutes / 60.0) + (seconds / 3600.0)); // 1 hour = 15 degrees
-}
+    const char *FileName;
+    bool HasRedshift;
+};
 
-// Function to convert DEC from DDMMSS to degrees
-// DEC: Declination
-// DDMMSS: Degrees, minutes, seconds
-internal f64
-ConvertDecToDegrees(f64 decDDMMSS)
+ExtraCatalog ExtraCatalogs[CATALOG_STREAM_MAX_COUNT] = {};
+u32 ExtraCatalogCount = 0;
+
+global_variable const Color CATALOG_PALETTE[] = {GREEN, ORANGE, SKYBLUE, YELLOW, LIME, PINK, GOLD, VIOLET, BEIGE, MAROON, DARKGREEN, BROWN, LIGHTGRAY};
+
+// The runs of every visible catalog in the shared instance buffer, per LOD, see DrawVisibleGalaxies
+InstanceRangeList FrameRanges[GALAXY_LOD_COUNT] = {};
+
+// @Note(Victor): GALAXY_RANDOM generates catalog B in memory instead of reading DataBFilename
+bool GenerateDataB = false;
+RandomCatalogOptions RandomDataB = {RANDOM_CATALOG_BOUNDS, 0, RANDOM_CATALOG_DEFAULT_SEED, nullptr};
+
+// @Note(Victor): 0 (or GALAXY_DENSITY=<columns>) draws catalogs A and B as a density map instead of the
+// galaxies, see sky_density.cpp. It is filled in while it is shown, at most SKY_DENSITY_FRAME_BUDGET
+// galaxies per frame.
+const u64 SKY_DENSITY_FRAME_BUDGET = 1ULL << 22;
+bool ShowSkyDensity = false;
+SkyDensityMap SkyDensity = {};
+u32 SkyDensityColumns = SKY_DENSITY_DEFAULT_COLUMNS;
+
+// @Note(Victor): --bench runs bench.cpp instead of opening the window
+bool BenchMode = false;
+BenchOptions Benchmark = {};
+
+// @Note(Victor): Every shading tier of both galaxy shaders is loaded at start, L (or GALAXY_SHADING=unlit)
+// only swaps the shader of the materials, see shading.cpp
+Shader GalaxyShaders[SHADING_TIER_COUNT] = {};
+Shader ImpostorShaders[SHADING_TIER_COUNT] = {};
+InstanceShaderLocations GalaxyShaderLocations[SHADING_TIER_COUNT] = {};
+InstanceShaderLocations ImpostorShaderLocations[SHADING_TIER_COUNT] = {};
+Shading_Tier ShadingTier = SHADING_PHONG;
+
+InstanceShaderLocations GalaxyInstanceLocations = {};
+InstanceShaderLocations ImpostorInstanceLocations = {};
+
+// @Note(Victor): The scale of every galaxy of a catalog, applied in the instancing shader
+const f32 DATA_POINT_SCALE = 0.1f;
+const f32 REDSHIFT_DATA_POINT_SCALE = 5.0f; // A megaparsec across, the redshift scene is in Mpc
+
+// Radius of the sphere (and the impostor) of one galaxy before that scale
+const f32 GALAXY_MESH_RADIUS = 0.2f;
+
+// @Note(Victor): Uniforms of the instancing shaders, changing them moves the galaxies without touching the
+// instance buffers. V sends the redshift galaxies between their distance and the sky sphere, + and - grow
+// and shrink the sphere. Both ease towards their target.
+const f32 SKY_RADIUS = 50.0f;
+const f32 SKY_RADIUS_STEP = 1.25f;      // Factor per key press
+const f32 PROJECTION_MORPH_SECONDS = 1.5f; // From the sky to the redshift distance
+f32 SkyRadius = SKY_RADIUS;
+f32 SkyRadiusTarget = SKY_RADIUS;
+f32 RedshiftBlend = 1.0f; // 0 on the sky sphere, 1 at the redshift distance
+f32 RedshiftBlendTarget = 1.0f;
+
+// @Note(Victor): P shows the profiler, T writes what it has to TraceFilename, so does GALAXY_TRACE=file at exit
+bool ShowProfiler = false;
+bool TraceAtExit = false;
+const char *TraceFilename = "galaxy_trace.json";
+
+// @Note(Victor): GALAXY_REPLAY=path.txt flies a scripted camera path and writes its frame times, see camera_replay.cpp
+CameraReplay Replay = {nullptr, "galaxy_replay.json", nullptr, 60};
+
+bool FrustumCulling = true;
+CullingStats FrameCulling = {};
+
+// @Note(Victor): The galaxy under the mouse, or under the center of the screen in free look, found every
+// frame through the spatial index (see PickSpatialIndex). A galaxy that is only a point is picked when the
+// mouse is within PICK_TOLERANCE_PIXELS of it.
+const f32 PICK_TOLERANCE_PIXELS = 4.0f;
+
+struct PickedGalaxy
 {
-    int degrees = (int)(decDDMMSS / 10000);
-    int minutes = (int)((decDDMMSS - (degrees * 10000)) / 100);
-    f64 seconds = decDDMMSS - (degrees * 10000) - (minutes * 100);
-
-    f64 decDegrees = abs(degrees) + (minutes / 60.0) + (seconds / 3600.0);
-    return (degrees < 0) ? -decDegrees : decDegrees;
-}
+    const CatalogStream *Stream; // nullptr when there is no galaxy under the mouse
+    PickResult Pick;
+    f32 Radius;
+
+    // Of the walks over every drawn catalog, for the debug overlay
+    f64 Seconds;
+    u32 NodeCount;
+    u64 TestedCount;
+};
 
-// Assuming speed of light in km/s for converting redshift to distance (simplified calculation)
-const f64 speedOfLight = 299792.458; // Speed of light in km/s
-const f64 hubbleConstant = 70.0;     // Hubble constant in km/s/Mpc
+PickedGalaxy Picked = {};
 
-internal f64
-RedshiftToDistance(f64 redshift)
-{
-    // Distance in Megaparsecs (Mpc)
-    return (speedOfLight * redshift) / hubbleConstant;
-}
-
-// Convert spherical coordinates (RA, Dec, distance) to Cartesian (X, Y, Z)
-internal void
-CalculatePosition(f64 ra, f64 dec, f64 redshift, f64 &X, f64 &Y, f64 &Z)
-{
-    f64 distance = RedshiftToDistance(redshift); // Convert redshift to distance (Mpc)
+// @Note(Victor): Levels of detail, the spheres get coarser with the distance and the last one is a point
+Mesh GalaxyLodMeshes[GALAXY_LOD_COUNT];
+const i32 GALAXY_LOD_RESOLUTIONS[GALAXY_LOD_COUNT - 1] = {16, 8, 4};
 
-    // Convert degrees to radians
-    f64 raRad = ra * PIdividedBy180;
-    f64 decRad = dec * PIdividedBy180;
+// In radii of the galaxy, so they work for every scale, set with GALAXY_LOD=near,middle,far
+f32 GalaxyLodDistances[GALAXY_LOD_COUNT - 1] = {250.0f, 750.0f, 2000.0f};
 
-    // Calculate Cartesian coordinates
-    X = distance * cos(decRad) * cos(raRad);
-    Y = distance * cos(decRad) * sin(raRad);
-    Z = distance * sin(decRad);
-}
-// ----------------------------------------------------------------------------------
+// Profiler scopes of the draw batches, one per LOD
+const char *GALAXY_LOD_SCOPES[GALAXY_LOD_COUNT] = {"Draw LOD 16x16", "Draw LOD 8x8", "Draw LOD 4x4", "Draw LOD point"};
+const char *IMPOSTOR_LOD_SCOPES[GALAXY_LOD_COUNT - 1] = {"Draw impostors near", "Draw impostors middle", "Draw impostors far"};
 
 internal void
 ParseInputArgs(i32 argc, char **argv)
@@ -143,6 +196,218 @@ ParseInputArgs(i32 argc, char **argv)
             printf("\tRunning in DEBUG mode !!!\n");
             Debug = true;
         }
+        else if (strcmp(argv[i], "GALAXY_CORRELATION") == 0)
+        {
+            printf("\tComputing the angular correlation before starting\n");
+            RunCorrelation = true;
+        }
+        else if (strcmp(argv[i], "GALAXY_CORRELATION_CHECK") == 0)
+        {
+            printf("\tChecking the angular correlation against the naive reference before starting\n");
+            RunCorrelationCheck = true;
+        }
+        else if (strcmp(argv[i], "GALAXY_IMPOSTORS") == 0)
+        {
+            printf("\tDrawing the galaxies as impostors\n");
+            RenderMode = RENDER_IMPOSTORS;
+        }
+        else if (strncmp(argv[i], "GALAXY_SHADING=", strlen("GALAXY_SHADING=")) == 0)
+        {
+            // @Note(Victor): GALAXY_SHADING=phong|lambert|unlit
+            if (ParseShadingTier(argv[i] + strlen("GALAXY_SHADING="), &ShadingTier))
+            {
+                printf("\tShading the galaxies with %s\n", ShadingTierNames[ShadingTier]);
+            }
+            else
+            {
+                printf("\tIgnoring %s, expected phong, lambert or unlit\n", argv[i]);
+            }
+        }
+        else if (strcmp(argv[i], "GALAXY_DENSITY") == 0 || strncmp(argv[i], "GALAXY_DENSITY=", strlen("GALAXY_DENSITY=")) == 0)
+        {
+            // @Note(Victor): GALAXY_DENSITY=1440, the cells in RA (half as many in Dec), 720 by default
+            ShowSkyDensity = true;
+            if (argv[i][strlen("GALAXY_DENSITY")] == '=')
+            {
+                SkyDensityColumns = (u32)atoi(argv[i] + strlen("GALAXY_DENSITY="));
+            }
+            printf("\tDrawing the sky density map, %u cells in RA\n", SkyDensityColumns);
+        }
+        else if (strncmp(argv[i], "GALAXY_LOD=", strlen("GALAXY_LOD=")) == 0)
+        {
+            // @Note(Victor): GALAXY_LOD=250,750,2000 the distances (in galaxy radii) where the next LOD starts
+            f32 Distances[GALAXY_LOD_COUNT - 1] = {};
+            const char *At = argv[i] + strlen("GALAXY_LOD=");
+            u32 DistanceCount = 0;
+            while (DistanceCount < GALAXY_LOD_COUNT - 1)
+            {
+                char *End = nullptr;
+                Distances[DistanceCount] = strtof(At, &End);
+                if (End == At)
+                {
+                    break;
+                }
+
+                DistanceCount++;
+                At = (*End == ',') ? End + 1 : End;
+            }
+
+            bool IsAscending = DistanceCount == GALAXY_LOD_COUNT - 1 && Distances[0] > 0.0f;
+            for (u32 Lod = 1; IsAscending && Lod < DistanceCount; ++Lod)
+            {
+                IsAscending = Distances[Lod] > Distances[Lod - 1];
+            }
+
+            if (IsAscending)
+            {
+                memcpy(GalaxyLodDistances, Distances, sizeof(GalaxyLodDistances));
+                printf("\tLOD distances: %.1f %.1f %.1f galaxy radii\n", GalaxyLodDistances[0], GalaxyLodDistances[1], GalaxyLodDistances[2]);
+            }
+            else
+            {
+                printf("\tIgnoring %s, expected %u increasing distances\n", argv[i], GALAXY_LOD_COUNT - 1);
+            }
+        }
+        else if (strcmp(argv[i], "GALAXY_TRACE") == 0 || strncmp(argv[i], "GALAXY_TRACE=", strlen("GALAXY_TRACE=")) == 0)
+        {
+            // @Note(Victor): GALAXY_TRACE=my_trace.json, a Chrome trace of the last frames written at exit
+            TraceAtExit = true;
+            if (argv[i][strlen("GALAXY_TRACE")] == '=')
+            {
+                TraceFilename = argv[i] + strlen("GALAXY_TRACE=");
+            }
+            printf("\tWriting a Chrome trace to %s at exit\n", TraceFilename);
+        }
+        else if (strncmp(argv[i], "GALAXY_REPLAY=", strlen("GALAXY_REPLAY=")) == 0)
+        {
+            Replay.PathFileName = argv[i] + strlen("GALAXY_REPLAY=");
+        }
+        else if (strncmp(argv[i], "GALAXY_REPLAY_OUT=", strlen("GALAXY_REPLAY_OUT=")) == 0)
+        {
+            Replay.OutFileName = argv[i] + strlen("GALAXY_REPLAY_OUT=");
+        }
+        else if (strncmp(argv[i], "GALAXY_REPLAY_SHOTS=", strlen("GALAXY_REPLAY_SHOTS=")) == 0)
+        {
+            // @Note(Victor): GALAXY_REPLAY_SHOTS=shots, a PNG of every GALAXY_REPLAY_SHOT_EVERY'th frame of the replay
+            Replay.ShotDirectory = argv[i] + strlen("GALAXY_REPLAY_SHOTS=");
+        }
+        else if (strncmp(argv[i], "GALAXY_REPLAY_SHOT_EVERY=", strlen("GALAXY_REPLAY_SHOT_EVERY=")) == 0)
+        {
+            i32 Every = atoi(argv[i] + strlen("GALAXY_REPLAY_SHOT_EVERY="));
+            Replay.ShotEvery = Every > 0 ? (u32)Every : Replay.ShotEvery;
+        }
+        else if (strcmp(argv[i], "GALAXY_RANDOM") == 0 || strncmp(argv[i], "GALAXY_RANDOM=", strlen("GALAXY_RANDOM=")) == 0)
+        {
+            // @Note(Victor): GALAXY_RANDOM=sphere|bounds|footprint, where on the sky, bounds (of catalog A) by default
+            GenerateDataB = true;
+            const char *Region = argv[i][strlen("GALAXY_RANDOM")] == '=' ? argv[i] + strlen("GALAXY_RANDOM=") : "bounds";
+            for (u32 Name = 0; Name < ArrayCount(RandomCatalogRegionNames); ++Name)
+            {
+                if (strcmp(Region, RandomCatalogRegionNames[Name]) == 0)
+                {
+                    RandomDataB.Region = (Random_Catalog_Region)Name;
+                }
+            }
+            printf("\tGenerating the random catalog (%s)\n", RandomCatalogRegionNames[RandomDataB.Region]);
+        }
+        else if (strncmp(argv[i], "GALAXY_RANDOM_COUNT=", strlen("GALAXY_RANDOM_COUNT=")) == 0)
+        {
+            // As many as catalog A by default
+            RandomDataB.Count = strtoull(argv[i] + strlen("GALAXY_RANDOM_COUNT="), nullptr, 10);
+        }
+        else if (strncmp(argv[i], "GALAXY_SEED=", strlen("GALAXY_SEED=")) == 0)
+        {
+            RandomDataB.Seed = strtoull(argv[i] + strlen("GALAXY_SEED="), nullptr, 0);
+        }
+        else if (strncmp(argv[i], "GALAXY_DATA_A=", strlen("GALAXY_DATA_A=")) == 0)
+        {
+            // @Note(Victor): Any arcmin catalog, or a .gcat from generate_catalog
+            DataAFilename = argv[i] + strlen("GALAXY_DATA_A=");
+        }
+        else if (strncmp(argv[i], "GALAXY_DATA_B=", strlen("GALAXY_DATA_B=")) == 0)
+        {
+            DataBFilename = argv[i] + strlen("GALAXY_DATA_B=");
+        }
+        else if (strncmp(argv[i], "GALAXY_DATA_REDSHIFT=", strlen("GALAXY_DATA_REDSHIFT=")) == 0)
+        {
+            RedshiftDataFilename = argv[i] + strlen("GALAXY_DATA_REDSHIFT=");
+        }
+        else if (strncmp(argv[i], "GALAXY_CATALOG=", strlen("GALAXY_CATALOG=")) == 0 ||
+                 strncmp(argv[i], "GALAXY_REDSHIFT_CATALOG=", strlen("GALAXY_REDSHIFT_CATALOG=")) == 0)
+        {
+            // @Note(Victor): The three catalogs above take the first slots
+            if (ExtraCatalogCount < CATALOG_STREAM_MAX_COUNT - 3)
+            {
+                ExtraCatalog *Extra = &ExtraCatalogs[ExtraCatalogCount++];
+                Extra->HasRedshift = argv[i][strlen("GALAXY_")] == 'R';
+                Extra->FileName = strchr(argv[i], '=') + 1;
+            }
+            else
+            {
+                printf("\tIgnoring %s, at most %u catalogs\n", argv[i], CATALOG_STREAM_MAX_COUNT);
+            }
+        }
+        else if (strcmp(argv[i], "GALAXY_WATCH") == 0)
+        {
+            // @Note(Victor): Follows the arcmin catalogs once they are loaded and draws what is appended to them
+            printf("\tWatching the catalogs for appended galaxies\n");
+            Loader.IsWatching = true;
+        }
+        else if (strcmp(argv[i], "GALAXY_HUGE_PAGES") == 0)
+        {
+            // @Note(Victor): Transparent huge pages for the catalog arenas, pays off from a few million galaxies
+            printf("\tBacking the catalogs with huge pages\n");
+            MemoryArenaHugePages = true;
+        }
+        else if (strcmp(argv[i], "GALAXY_COMPACT") == 0)
+        {
+            // @Note(Victor): Fixed point RA/Dec for the arcmin and random catalogs, half the memory, see catalog.cpp
+            printf("\tStoring the arcmin catalogs in fixed point\n");
+            CompactCatalogs = true;
+        }
+        else if (strcmp(argv[i], "GALAXY_VERIFY_CACHE") == 0)
+        {
+            printf("\tHashing the catalogs to verify their caches\n");
+            VerifyCatalogCache = true;
+        }
+        else if (strcmp(argv[i], "--bench") == 0 || strncmp(argv[i], "--bench=", strlen("--bench=")) == 0)
+        {
+            // @Note(Victor): --bench=10 for 10 repetitions of every stage
+            BenchMode = true;
+            Benchmark.Repetitions = argv[i][strlen("--bench")] == '=' ? (u32)atoi(argv[i] + strlen("--bench=")) : 5;
+        }
+        else if (strncmp(argv[i], "--bench-file=", strlen("--bench-file=")) == 0)
+        {
+            if (Benchmark.FileCount < BENCH_MAX_CATALOGS)
+            {
+                Benchmark.Files[Benchmark.FileCount++] = argv[i] + strlen("--bench-file=");
+            }
+        }
+        else if (strncmp(argv[i], "--bench-correlation=", strlen("--bench-correlation=")) == 0)
+        {
+            // @Note(Victor): One size or a comma separated list of them
+            const char *At = argv[i] + strlen("--bench-correlation=");
+            Benchmark.CorrelationSizeCount = 0;
+            while (*At && Benchmark.CorrelationSizeCount < BENCH_MAX_CORRELATION_SIZES)
+            {
+                char *End = nullptr;
+                u64 Size = strtoull(At, &End, 10);
+                if (End == At)
+                {
+                    break;
+                }
+
+                if (Size > 0)
+                {
+                    Benchmark.CorrelationSizes[Benchmark.CorrelationSizeCount++] = Size;
+                }
+                At = (*End == ',') ? End + 1 : End;
+            }
+        }
+        else if (strcmp(argv[i], "--bench-correlation-brute") == 0)
+        {
+            Benchmark.CorrelationBruteForce = true;
+        }
     }
 }
 
@@ -295,9 +560,45 @@ RotateCameraAroundOrigo(f64 DeltaTime)
     // printf("Up:        x=%f, y=%f, z=%f\n", up.x, up.y, up.z);
 }
 
+// Points the galaxy materials at the shaders of Tier
+internal void
+SetShadingTier(Shading_Tier Tier)
+{
+    ShadingTier = Tier;
+    matInstances.shader = GalaxyShaders[Tier];
+    matImpostors.shader = ImpostorShaders[Tier];
+    GalaxyInstanceLocations = GalaxyShaderLocations[Tier];
+    ImpostorInstanceLocations = ImpostorShaderLocations[Tier];
+}
+
+// @Note(Victor): Bins what the loader has read of A and B and the density map doesn't have yet
+internal void
+UpdateSkyDensity(void)
+{
+    CatalogStream *Streams[SKY_DENSITY_LAYER_COUNT] = {&Catalogs.Streams[CATALOG_A], &Catalogs.Streams[CATALOG_B]};
+    u64 Budget = SKY_DENSITY_FRAME_BUDGET;
+
+    for (u32 Layer = 0; Layer < SKY_DENSITY_LAYER_COUNT && Budget > 0; ++Layer)
+    {
+        CatalogStream *Stream = Streams[Layer];
+        u32 Stage = Stream->Stage.load(std::memory_order_acquire);
+        if (Stage < CATALOG_STREAM_BUILDING || Stage == CATALOG_STREAM_FAILED)
+        {
+            continue;
+        }
+
+        u64 First = SkyDensity.Totals[Layer];
+        u64 Count = Stream->Data.Count - First < Budget ? Stream->Data.Count - First : Budget;
+        AddSkyDensityPoints(&SkyDensity, (Sky_Density_Layer)Layer, &Stream->Data, First, Count);
+        Budget -= Count;
+    }
+}
+
 internal void
 GameUpdate(f64 DeltaTime)
 {
+    ProfileScope("GameUpdate");
+
     HandleWindowResize();
 
     if (IsKeyPressed(KEY_ESCAPE))
@@ -310,26 +611,81 @@ GameUpdate(f64 DeltaTime)
         ToggleFullscreen();
     }
 
-    if (IsKeyPressed(KEY_ONE))
+    if (IsKeyPressed(KEY_C))
+    {
+        FrustumCulling = !FrustumCulling;
+    }
+
+    if (IsKeyPressed(KEY_M))
+    {
+        RenderMode = RenderMode == RENDER_MESHES ? RENDER_IMPOSTORS : RENDER_MESHES;
+    }
+
+    if (IsKeyPressed(KEY_L))
     {
-        DataToDraw = DRAW_DATA_A;
+        SetShadingTier((Shading_Tier)((ShadingTier + 1) % SHADING_TIER_COUNT));
     }
 
-    if (IsKeyPressed(KEY_TWO))
+    if (IsKeyPressed(KEY_P))
     {
-        DataToDraw = DRAW_DATA_B;
+        ShowProfiler = !ShowProfiler;
     }
 
-    if (IsKeyPressed(KEY_THREE))
+    if (IsKeyPressed(KEY_T))
     {
-        DataToDraw = DRAW_ALL_DATA;
+        WriteChromeTrace(TraceFilename);
     }
 
-    // @Note(Victor): This is not working as intended, yet
-    // if (IsKeyPressed(KEY_FOUR))
-    // {
-    //     DataToDraw = DRAW_REDSHIFT_DATA;
-    // }
+    // 1 to 9 show and hide the catalogs in the order they were added. Out of the density map
+    // they first go back to the catalogs as they were.
+    for (u32 i = 0; i < Catalogs.Count && i < 9; ++i)
+    {
+        if (IsKeyPressed(KEY_ONE + i))
+        {
+            if (ShowSkyDensity)
+            {
+                ShowSkyDensity = false;
+            }
+            else
+            {
+                Catalogs.IsVisible[i] = !Catalogs.IsVisible[i];
+            }
+        }
+    }
+
+    // Again switches between the difference and the ratio
+    if (IsKeyPressed(KEY_ZERO))
+    {
+        if (ShowSkyDensity)
+        {
+            SetSkyDensityMeasure(&SkyDensity, (Sky_Density_Measure)((SkyDensity.Measure + 1) % SKY_DENSITY_MEASURE_COUNT));
+        }
+        ShowSkyDensity = true;
+    }
+
+    if (IsKeyPressed(KEY_V))
+    {
+        RedshiftBlendTarget = RedshiftBlendTarget > 0.5f ? 0.0f : 1.0f;
+    }
+
+    if (IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD))
+    {
+        SkyRadiusTarget *= SKY_RADIUS_STEP;
+    }
+
+    if (IsKeyPressed(KEY_MINUS) || IsKeyPressed(KEY_KP_SUBTRACT))
+    {
+        SkyRadiusTarget /= SKY_RADIUS_STEP;
+    }
+
+    {
+        f32 Step = (f32)DeltaTime / PROJECTION_MORPH_SECONDS;
+        RedshiftBlend = RedshiftBlend < RedshiftBlendTarget ? fminf(RedshiftBlend + Step, RedshiftBlendTarget)
+                                                            : fmaxf(RedshiftBlend - Step, RedshiftBlendTarget);
+
+        // Exponential, so every press takes the same time however big the sphere is
+        SkyRadius += (SkyRadiusTarget - SkyRadius) * fminf(1.0f, 4.0f * (f32)DeltaTime);
+    }
 
     if (IsKeyPressed(KEY_SPACE))
     {
@@ -337,7 +693,10 @@ GameUpdate(f64 DeltaTime)
         printf("\tIsPaused: %s\n", IsPaused ? "true" : "false");
     }
 
-    RotateCameraAroundOrigo(DeltaTime);
+    {
+        ProfileScope("RotateCameraAroundOrigo");
+        RotateCameraAroundOrigo(DeltaTime);
+    }
 
     f64 Scroll = GetMouseWheelMove();
     if (Scroll != 0.0f)
@@ -348,17 +707,198 @@ GameUpdate(f64 DeltaTime)
     }
 }
 
+// Only the catalogs with a redshift have somewhere to go off the sphere
+internal f32
+GetStreamRedshiftBlend(const CatalogStream *Stream)
+{
+    return Stream->HasRedshift ? RedshiftBlend : 0.0f;
+}
+
+// Where the instancing shaders put the galaxies of the stream, for the walks of its spatial index.
+// The sphere layout built the index at its radius, the redshift layout at the redshift distance.
+internal IndexProjection
+GetStreamIndexProjection(const CatalogStream *Stream, f32 Scale)
+{
+    f32 Blend = GetStreamRedshiftBlend(Stream);
+
+    IndexProjection Result = {};
+    Result.SkyRadius = SkyRadius * (1.0f - Blend);
+    Result.PlacedScale = Stream->Layout == GALAXY_LAYOUT_REDSHIFT ? Blend : 0.0f;
+    Result.Padding = GALAXY_MESH_RADIUS * Scale;
+
+    return Result;
+}
+
+// The galaxies of the redshift catalogs grow to a megaparsec on the way to their distance
+internal f32
+GetStreamScale(const CatalogStream *Stream)
+{
+    return Stream->HasRedshift ? Lerp(DATA_POINT_SCALE, REDSHIFT_DATA_POINT_SCALE, RedshiftBlend) : DATA_POINT_SCALE;
+}
+
+// @Note(Victor): Every visible catalog is culled on its own, then the runs of all of them are drawn
+// together out of the shared instance buffer, one batch per LOD with the uniforms of every catalog set
+// once. Hidden catalogs just have no runs. The impostors replace the sphere LODs, the point LOD is the
+// same for both. A catalog that is still streaming in has no index yet, so whatever is uploaded of it is
+// drawn from its own buffer as points, unculled.
 internal void
-GameRender(f64 DeltaTime)
+DrawVisibleGalaxies(const FrustumPlanes *Frustum)
 {
-    BeginDrawing();
-    ClearBackground(BLACK);
+    InstanceUniforms Uniforms = {};
+    Uniforms.SphereRadius = SkyRadius;
+    for (u32 i = 0; i < Catalogs.Count; ++i)
+    {
+        const CatalogStream *Stream = &Catalogs.Streams[i];
+        SetCatalogUniforms(&Uniforms, Stream->Id, GetStreamScale(Stream), Stream->InstanceColor, (f32)Stream->LayoutScale, GetStreamRedshiftBlend(Stream));
+    }
 
-    if (!DataAIsLoaded)
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
     {
-        return;
+        FrameRanges[Lod].Count = 0;
+    }
+
+    for (u32 i = 0; i < Catalogs.Count; ++i)
+    {
+        CatalogStream *Stream = &Catalogs.Streams[i];
+        if (!Catalogs.IsVisible[i])
+        {
+            continue;
+        }
+
+        f32 Scale = GetStreamScale(Stream);
+        if (!Stream->IsIndexUploaded)
+        {
+            ProfileScope(GALAXY_LOD_SCOPES[GALAXY_LOD_COUNT - 1]);
+
+            const GalaxyInstanceBuffer *Buffer = &Stream->Buffer;
+            InstanceRange Uploaded = {0, Buffer->Count};
+            DrawGalaxyPoints(GalaxyLodMeshes[GALAXY_LOD_COUNT - 1], matInstances, GalaxyInstanceLocations, Buffer, &Uploaded, Buffer->Count > 0 ? 1 : 0, &Uniforms);
+
+            FrameCulling.SubmittedCount += Buffer->Count;
+            FrameCulling.TotalCount += Buffer->Count;
+            FrameCulling.LodCount[GALAXY_LOD_COUNT - 1] += Buffer->Count;
+            FrameCulling.DrawCount += Buffer->Count > 0 ? 1 : 0;
+            continue;
+        }
+
+        const SpatialIndex *Index = &Stream->Index;
+        VisibleInstances *Visible = &Stream->Visible;
+
+        LodDistances Lods = {};
+        for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT - 1; ++Lod)
+        {
+            Lods.Distances[Lod] = GalaxyLodDistances[Lod] * GALAXY_MESH_RADIUS * Scale;
+        }
+
+        IndexProjection Projection = GetStreamIndexProjection(Stream, Scale);
+
+        {
+            ProfileScope("Cull");
+            f64 CullStart = GetWallClockSeconds();
+            CullSpatialIndex(Index, &Projection, Frustum, MainCamera.position, &Lods, Visible);
+            FrameCulling.Seconds += GetWallClockSeconds() - CullStart;
+        }
+
+        FrameCulling.SubmittedCount += Visible->VisibleCount;
+        FrameCulling.TotalCount += Index->Count;
+        FrameCulling.VisibleLeafCount += Visible->VisibleLeafCount;
+        FrameCulling.LeafCount += Index->LeafCount;
+
+        // Into the shared buffer, the runs of the next catalog can continue the last ones of this one
+        for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+        {
+            FrameCulling.LodCount[Lod] += Visible->LodCount[Lod];
+            AppendInstanceRanges(&FrameRanges[Lod], Visible->Ranges[Lod], Visible->RangeCount[Lod], Stream->SharedFirst);
+        }
     }
 
+    // @Note(Victor): What was appended to a watched catalog is not in its index, so it is drawn like a
+    // catalog that is still streaming in, as points out of its own buffer
+    for (u32 i = 0; i < Catalogs.Count; ++i)
+    {
+        const GalaxyInstanceBuffer *Appended = &Catalogs.Streams[i].AppendedBuffer;
+        if (!Catalogs.IsVisible[i] || Appended->Count == 0)
+        {
+            continue;
+        }
+
+        ProfileScope(GALAXY_LOD_SCOPES[GALAXY_LOD_COUNT - 1]);
+
+        InstanceRange Uploaded = {0, Appended->Count};
+        DrawGalaxyPoints(GalaxyLodMeshes[GALAXY_LOD_COUNT - 1], matInstances, GalaxyInstanceLocations, Appended, &Uploaded, 1, &Uniforms);
+
+        FrameCulling.SubmittedCount += Appended->Count;
+        FrameCulling.TotalCount += Appended->Count;
+        FrameCulling.LodCount[GALAXY_LOD_COUNT - 1] += Appended->Count;
+        FrameCulling.DrawCount += 1;
+    }
+
+    const GalaxyInstanceBuffer *Buffer = &Loader.Instances;
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+    {
+        const InstanceRangeList *Ranges = &FrameRanges[Lod];
+        FrameCulling.DrawCount += Ranges->Count;
+
+        ProfileScope(Lod < GALAXY_LOD_COUNT - 1 && RenderMode == RENDER_IMPOSTORS ? IMPOSTOR_LOD_SCOPES[Lod] : GALAXY_LOD_SCOPES[Lod]);
+
+        if (Lod == GALAXY_LOD_COUNT - 1)
+        {
+            DrawGalaxyPoints(GalaxyLodMeshes[Lod], matInstances, GalaxyInstanceLocations, Buffer, Ranges->Ranges, Ranges->Count, &Uniforms);
+        }
+        else if (RenderMode == RENDER_IMPOSTORS)
+        {
+            DrawGalaxyInstanceRanges(ImpostorMesh, matImpostors, ImpostorInstanceLocations, Buffer, Ranges->Ranges, Ranges->Count, &Uniforms);
+        }
+        else
+        {
+            DrawGalaxyInstanceRanges(GalaxyLodMeshes[Lod], matInstances, GalaxyInstanceLocations, Buffer, Ranges->Ranges, Ranges->Count, &Uniforms);
+        }
+    }
+}
+
+// @Note(Victor): Picks from the catalogs that are drawn, only once they are indexed
+internal void
+PickGalaxyUnderMouse(void)
+{
+    f64 StartTime = GetWallClockSeconds();
+
+    // Free look has no cursor, it picks at the center of the screen
+    Vector2 Cursor = IsPaused ? Vector2{SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f} : GetMousePosition();
+    Ray PickRay = GetMouseRay(Cursor, MainCamera);
+
+    // The tangent of the angle PICK_TOLERANCE_PIXELS cover at the center of the screen
+    f32 Tolerance = 2.0f * tanf(0.5f * MainCamera.fovy * DEG2RAD) * PICK_TOLERANCE_PIXELS / (f32)SCREEN_HEIGHT;
+
+    Picked = {};
+    for (u32 i = 0; i < Catalogs.Count && !ShowSkyDensity; ++i)
+    {
+        CatalogStream *Stream = &Catalogs.Streams[i];
+        if (!Catalogs.IsVisible[i] || !Stream->IsIndexUploaded)
+        {
+            continue;
+        }
+
+        IndexProjection Projection = GetStreamIndexProjection(Stream, GetStreamScale(Stream));
+        PickResult Pick = PickSpatialIndex(&Stream->Index, Stream->Instances, Stream->Sky, &Projection, PickRay, Tolerance);
+        Picked.NodeCount += Pick.NodeCount;
+        Picked.TestedCount += Pick.TestedCount;
+        if (Pick.Hit && (Picked.Stream == nullptr || Pick.Distance < Picked.Pick.Distance))
+        {
+            Picked.Stream = Stream;
+            Picked.Pick = Pick;
+            Picked.Radius = Projection.Padding;
+        }
+    }
+
+    Picked.Seconds = GetWallClockSeconds() - StartTime;
+}
+
+internal void
+GameRender(f64 DeltaTime)
+{
+    BeginDrawing();
+    ClearBackground(BLACK);
+
     // Draw the data around a sphere in 3D
     BeginMode3D(MainCamera);
 
@@ -386,40 +926,58 @@ GameRender(f64 DeltaTime)
         rlLoadIdentity();
     } */
 
+    BeginGpuPass("Earth");
     DrawSphere({0.0f, 0.0f, 0.0f}, 1.0f, BLUE);
 
     // Draw the Earth model at the origin (0, 0, 0)
     Vector3 EarthPosition = {0.0f, 0.0f, 0.0f};
     const f64 EarthScale = 1.0f;
     DrawModel(EarthModel, EarthPosition, EarthScale, WHITE);
+    EndGpuPass();
 
-    // Draw instanced meshes
-    if (DataToDraw == DRAW_DATA_A || DataToDraw == DRAW_ALL_DATA)
+    // Draw instanced meshes, or impostors, only the parts of the catalogs that are in front of the camera
+    FrustumPlanes Frustum = GetInfiniteFrustum();
+    if (FrustumCulling)
     {
-        Color MyDARKBLUE = {0, 0, 255, 255};
-        matInstances.maps[MATERIAL_MAP_DIFFUSE].color = MyDARKBLUE;
-        DrawMeshInstanced(SphereMesh, matInstances, MatrixTransformsA, MAX_DATA_POINTS);
+        Frustum = GetFrustumPlanes(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
     }
+    FrameCulling = {};
 
-    if (DataToDraw == DRAW_DATA_B || DataToDraw == DRAW_ALL_DATA)
+    // @Note(Victor): One pass per shading tier, so the overlay shows what each costs
+    BeginGpuPass(ShadingTierPasses[ShadingTier]);
+
+    if (!ShowSkyDensity)
     {
-        matInstances.maps[MATERIAL_MAP_DIFFUSE].color = RED;
-        DrawMeshInstanced(SphereMesh, matInstances, MatrixTransformsB, MAX_DATA_POINTS);
+        DrawVisibleGalaxies(&Frustum);
     }
 
-    if (DataToDraw == DRAW_REDSHIFT_DATA)
+    EndGpuPass();
+
+    if (Picked.Stream)
     {
-        matInstances.maps[MATERIAL_MAP_DIFFUSE].color = MAGENTA;
-        DrawMeshInstanced(SphereMesh, matInstances, MatrixTransformsRedshift, MAX_REDSHIFT_DATA_POINTS);
+        DrawSphereWires(Picked.Pick.Position, 2.0f * Picked.Radius, 8, 8, YELLOW);
+    }
+
+    if (ShowSkyDensity)
+    {
+        ProfileScope("Sky density");
+        BeginGpuPass("Sky density");
+        DrawSkyDensityMap(&SkyDensity, SkyRadius);
+        EndGpuPass();
     }
 
     EndMode3D();
 
     // UI ------------------------------------------------------
+    BeginGpuPass("UI");
+    f64 UIStart = GetWallClockSeconds();
 
     // Draw the FPS with our font
     DrawTextEx(MainFont, TextFormat("FPS: %i", GetFPS()), {10, 10}, 20, 2, WHITE);
 
+    // How many galaxies made it through the frustum culling, press C to toggle it
+    DrawTextEx(MainFont, TextFormat("Galaxies drawn: %lu / %lu%s", (unsigned long)FrameCulling.SubmittedCount, (unsigned long)FrameCulling.TotalCount, FrustumCulling ? "" : " (C: culling off)"), {10, 32}, 16, 2, WHITE);
+
     if (!IsPaused)
     {
         // Scroll to zoom
@@ -429,20 +987,28 @@ GameRender(f64 DeltaTime)
     // Press F11 to toggle fullscreen
     DrawTextEx(MainFont, TextFormat("Press F11 to toggle fullscreen"), {10, 70}, 16, 2, WHITE);
 
-    // Press 1, 2 or 3 to toggle which data to draw
-    DrawTextEx(MainFont, TextFormat("Press 1, 2, 3 or 4 to toggle which data to draw"), {10, 90}, 16, 2, WHITE);
+    // Press 1 to 9 to show or hide a catalog, 0 for the density map
+    DrawTextEx(MainFont, TextFormat("Press 1 to 9 to show or hide a catalog, 0 for the density map"), {10, 90}, 16, 2, WHITE);
 
-    // Red are uniformly distributed, blue are real data
-    DrawTextEx(MainFont, TextFormat("Red are uniformly distributed"), {10, 110}, 16, 2, RED);
-    DrawTextEx(MainFont, TextFormat("Blue are real data"), {10, 130}, 16, 2, BLUE);
+    // Every catalog in its color, the hidden ones in gray
+    f32 TextY = 110.0f;
+    for (u32 i = 0; i < Catalogs.Count; ++i)
+    {
+        const CatalogStream *Stream = &Catalogs.Streams[i];
+        bool IsShown = Catalogs.IsVisible[i] && !ShowSkyDensity;
+        char Key = i < 9 ? (char)('1' + i) : ' ';
+        u64 Appended = Stream->AppendedBuffer.Count;
+        DrawTextEx(MainFont, TextFormat("%c: %s%s%s", Key, GetFileName(Stream->FileName), Appended ? TextFormat(" +%lu appended", (unsigned long)Appended) : "", IsShown ? "" : " (hidden)"),
+                   {10, TextY}, 16, 2, IsShown ? Stream->InstanceColor : GRAY);
+        TextY += 20.0f;
+    }
 
-    // @Note(Victor): This is not working as intended
-    // DrawTextEx(MainFont, TextFormat("Magenta are redshift data"), {10, 160}, 16, 2, MAGENTA);
+    DrawTextEx(MainFont, TextFormat("V puts the redshift data on the sky, + and - size the sky"), {10, TextY}, 16, 2, WHITE);
 
     if (IsPaused)
     {
-        DrawTextEx(MainFont, TextFormat("Press W, A, S, D, Q, E to move the camera + Mouse"), {10, 150}, 16, 2, WHITE);
-        DrawTextEx(MainFont, TextFormat("Press LShift to move slower"), {10, 170}, 16, 2, WHITE);
+        DrawTextEx(MainFont, TextFormat("Press W, A, S, D, Q, E to move the camera + Mouse"), {10, TextY + 20.0f}, 16, 2, WHITE);
+        DrawTextEx(MainFont, TextFormat("Press LShift to move slower"), {10, TextY + 40.0f}, 16, 2, WHITE);
     }
 
     // Press space to pause in the center bottom
@@ -471,281 +1037,273 @@ GameRender(f64 DeltaTime)
         DrawTextEx(MainFont, IsPausedText, {SCREEN_WIDTH - 64.0f - 128.0f - 32.0f, 30}, 20, 2, GREEN);
     }
 
-    EndDrawing();
-}
+    // Press M to switch between meshes and impostors
+    const char *RenderModeText = RenderMode == RENDER_IMPOSTORS ? "Impostors (M)" : "Meshes (M)";
+    DrawTextEx(MainFont, RenderModeText, {SCREEN_WIDTH - 64.0f - 128.0f - 32.0f, 55}, 16, 2, WHITE);
 
-internal void
-PrintMemoryUsage(void)
-{
-    printf("\n\tMemory used in GigaBytes: %f\n", (f64)CPUMemory / (f64)Gigabytes(1));
-    printf("\tMemory used in MegaBytes: %f\n", (f64)CPUMemory / (f64)Megabytes(1));
-}
+    // Press L to go through the shading tiers
+    DrawTextEx(MainFont, TextFormat("Shading: %s (L)", ShadingTierNames[ShadingTier]), {SCREEN_WIDTH - 64.0f - 128.0f - 32.0f, 75}, 16, 2, WHITE);
 
-internal void
-CleanupOurStuff(void)
-{
-    CloseWindow(); // Close window and OpenGL context
-    printf("\n\tClosed window and OpenGL context\n");
-
-    free(DataPointsA);
-    CPUMemory -= MAX_DATA_POINTS * sizeof(ArcminData);
-    printf("\n\tFreeing DataPointsA %lu\n", MAX_DATA_POINTS * sizeof(ArcminData));
-    PrintMemoryUsage();
-
-    free(DataPointsB);
-    CPUMemory -= MAX_DATA_POINTS * sizeof(ArcminData);
-    printf("\n\tFreeing DataPointsB: %lu\n", MAX_DATA_POINTS * sizeof(ArcminData));
-    PrintMemoryUsage();
-
-    free(MatrixTransformsA);
-    CPUMemory -= MAX_DATA_POINTS * sizeof(Matrix);
-    printf("\n\tFreeing MatrixTransformsA: %lu\n", MAX_DATA_POINTS * sizeof(Matrix));
-    PrintMemoryUsage();
-
-    free(MatrixTransformsB);
-    CPUMemory -= MAX_DATA_POINTS * sizeof(Matrix);
-    printf("\n\tFreeing MatrixTransformsB: %lu\n", MAX_DATA_POINTS * sizeof(Matrix));
-    PrintMemoryUsage();
-
-    free(RedshiftData);
-    CPUMemory -= MAX_REDSHIFT_DATA_POINTS * sizeof(ArcminData);
-    printf("\n\tFreeing RedshiftData: %lu\n", MAX_REDSHIFT_DATA_POINTS * sizeof(ArcminData));
-    PrintMemoryUsage();
-
-    free(MatrixTransformsRedshift);
-    CPUMemory -= MAX_REDSHIFT_DATA_POINTS * sizeof(Matrix);
-    printf("\n\tFreeing MatrixTransformsRedshift: %lu\n", MAX_REDSHIFT_DATA_POINTS * sizeof(Matrix));
-    PrintMemoryUsage();
-
-    // @Note(Victor): There should be no allocated memory left
-    Assert(CPUMemory == 0);
-}
-
-internal void
-SigIntHandler(i32 Signal)
-{
-    printf("\tCaught SIGINT, exiting peacefully!\n");
-
-    CleanupOurStuff();
-
-    exit(0);
-}
-
-internal bool
-ReadInputDataFromRedshiftFile(const char *FileName, ArcminData *DataPointsLocation)
-{
-    // Data format:
-    // Name: Galaxy name
-    // RA (1950): Right ascension (celestial longitude) in the 1950 epoch (format: HHMMSS.s)
-    // DEC: Declination (celestial latitude) in the 1950 epoch (format: DDMMSS)
-    // VH/VE/VS: Heliocentric velocity or redshift-related data.
-    // Other columns: Additional parameters like magnitude, velocity types, or uncertainties.
-
-    FILE *f = fopen(FileName, "r");
-    if (f == NULL)
+    // Blue where the real galaxies are denser than the random ones, red where they are sparser
+    if (ShowSkyDensity)
     {
-        printf("Error opening redshift file: %s\n", FileName);
-        return false;
+        DrawTextEx(MainFont, TextFormat("Density: %s (0)", SkyDensityMeasureNames[SkyDensity.Measure]), {SCREEN_WIDTH - 64.0f - 128.0f - 32.0f, 95}, 16, 2, WHITE);
     }
 
-    const int bufferSize = 4096;
-    char Line[bufferSize]; // Buffer to store each line from the file
-
-    // Skip the header lines (13 lines in this case)
-    const int HeaderLines = 13;
-    for (int i = 0; i < HeaderLines; ++i)
+    // The catalog, index and place on the sky of the picked galaxy, next to the cursor
+    if (Picked.Stream)
     {
-        if (fgets(Line, sizeof(Line), f) == NULL)
+        const CatalogStream *Stream = Picked.Stream;
+        const SkyInstance *Sky = &Stream->Sky[Picked.Pick.Instance];
+        Vector2 Cursor = IsPaused ? Vector2{SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT / 2.0f} : GetMousePosition();
+        Vector2 At = {Cursor.x + 16.0f, Cursor.y + 16.0f};
+
+        DrawTextEx(MainFont, TextFormat("%s #%lu", GetFileName(Stream->FileName), (unsigned long)Picked.Pick.CatalogIndex), At, 16, 2, YELLOW);
+        DrawTextEx(MainFont, TextFormat("RA %.4f, Dec %.4f degrees", Sky->RightAscension * RAD2DEG, Sky->Declination * RAD2DEG), {At.x, At.y + 18.0f}, 16, 2, YELLOW);
+        if (Stream->HasRedshift)
         {
-            printf("Error reading header!\n");
-            fclose(f);
-            return false;
+            DrawTextEx(MainFont, TextFormat("cz %.0f km/s, %.1f Mpc away", Sky->Velocity, Sky->Velocity / HUBBLE_CONSTANT), {At.x, At.y + 36.0f}, 16, 2, YELLOW);
         }
     }
 
-    unsigned long int i = 0;
-    while (fgets(Line, sizeof(Line), f) != NULL && i < MAX_REDSHIFT_DATA_POINTS)
+    if (Debug)
     {
-        // Remove leading/trailing whitespace (if any)
-        char *trimmedLine = strtok(Line, "\n");
+        // @Note(Victor): The instances are static, so this should stay at 0 bytes after the first frame
+        f32 DebugY = (f32)SCREEN_HEIGHT - 140.0f;
+        DrawTextEx(MainFont, TextFormat("Instance upload: %lu bytes/frame", (unsigned long)InstanceUploads.LastFrameBytes), {10, DebugY}, 16, 2, YELLOW);
+        DrawTextEx(MainFont, TextFormat("GPU instance memory: %.2f MB", (f64)InstanceUploads.GPUMemory / (f64)Megabytes(1)), {10, DebugY + 20.0f}, 16, 2, YELLOW);
+        DrawTextEx(MainFont, TextFormat("Culling: %.3f ms, %u / %u tiles, %u draws", FrameCulling.Seconds * 1000.0, FrameCulling.VisibleLeafCount, FrameCulling.LeafCount, FrameCulling.DrawCount), {10, DebugY + 40.0f}, 16, 2, YELLOW);
+        DrawTextEx(MainFont, TextFormat("LOD 16x16: %lu  8x8: %lu  4x4: %lu  point: %lu", (unsigned long)FrameCulling.LodCount[0], (unsigned long)FrameCulling.LodCount[1], (unsigned long)FrameCulling.LodCount[2], (unsigned long)FrameCulling.LodCount[3]), {10, DebugY + 60.0f}, 16, 2, YELLOW);
+        DrawTextEx(MainFont, TextFormat("Pick: %.3f ms, %u nodes, %lu galaxies tested", Picked.Seconds * 1000.0, Picked.NodeCount, (unsigned long)Picked.TestedCount), {10, DebugY + 80.0f}, 16, 2, YELLOW);
+    }
 
-        // Skip empty lines
-        if (trimmedLine == NULL || strlen(trimmedLine) == 0)
-            continue;
+    // @Note(Victor): The catalogs stream in while we already draw, see catalog_streaming.cpp
+    if (!DataAIsLoaded)
+    {
+        f32 Progress = GetCatalogLoaderProgress(&Loader);
+        f32 BarWidth = SCREEN_WIDTH / 3.0f;
+        Rectangle Bar = {(SCREEN_WIDTH - BarWidth) / 2.0f, SCREEN_HEIGHT - 70.0f, BarWidth, 12.0f};
 
-        // Tokenize the line assuming space-separated values
-        char *Token = strtok(trimmedLine, " ");
-        int j = 0;
+        DrawTextEx(MainFont, TextFormat("Loading galaxies: %i%%", (i32)(Progress * 100.0f)), {Bar.x, Bar.y - 22.0f}, 16, 2, WHITE);
+        DrawRectangleRec({Bar.x, Bar.y, Bar.width * Progress, Bar.height}, GREEN);
+        DrawRectangleLinesEx(Bar, 1.0f, WHITE);
+    }
 
-        while (Token != NULL)
+    for (u32 i = 0; i < Loader.StreamCount; ++i)
+    {
+        if (Loader.Streams[i]->Stage.load(std::memory_order_acquire) == CATALOG_STREAM_FAILED)
         {
-            switch (j)
-            {
-            case 1: // RA (1950)
-                DataPointsLocation[i].right_ascension = atof(Token);
-                break;
-            case 2: // DEC
-                DataPointsLocation[i].declination = atof(Token);
-                break;
-            case 4: // Redshift (VH)
-                DataPointsLocation[i].redshift = atof(Token);
-                break;
-            default:
-                break;
-            }
-
-            Token = strtok(NULL, " "); // Continue to the next token
-            j++;
+            DrawTextEx(MainFont, TextFormat("Could not load %s", Loader.Streams[i]->FileName), {10, SCREEN_HEIGHT - 150.0f - 20.0f * i}, 16, 2, RED);
         }
-
-        i++;
     }
 
-    if (f != NULL)
+    if (ShowProfiler)
     {
-        fclose(f);
+        DrawProfilerOverlay(GetFontDefault(), {SCREEN_WIDTH - 440.0f, 90.0f});
     }
 
-    printf("\tSuccessfully read %ld redshift data points from %s\n", i, FileName);
+    EndProfileScope("UI", UIStart);
+    EndGpuPass();
 
-    return true;
+    TakeCameraReplayShot(&Replay);
+
+    // @Note(Victor): Its own scope, the swap is where the CPU waits for the GPU (or vsync)
+    {
+        ProfileScope("Present");
+        EndDrawing();
+    }
 }
 
-internal bool
-ReadInputDataFromFile(const char *FileName, ArcminData *DataPointsLocation)
+// @Note(Victor): rlights numbers the lights globally, so a second shader gets the same lights by hand
+internal void
+ShareLights(const Light *Lights, i32 LightCount, Shader Target)
 {
-    FILE *f = fopen(FileName, "r");
-    if (f == NULL)
+    for (i32 i = 0; i < LightCount; ++i)
     {
-        printf("Error opening file!\n");
-        return (false);
+        Light Shared = Lights[i];
+        Shared.enabledLoc = GetShaderLocation(Target, TextFormat("lights[%i].enabled", i));
+        Shared.typeLoc = GetShaderLocation(Target, TextFormat("lights[%i].type", i));
+        Shared.positionLoc = GetShaderLocation(Target, TextFormat("lights[%i].position", i));
+        Shared.targetLoc = GetShaderLocation(Target, TextFormat("lights[%i].target", i));
+        Shared.colorLoc = GetShaderLocation(Target, TextFormat("lights[%i].color", i));
+
+        UpdateLightValues(Target, Shared);
     }
+}
 
-    // read the header
-    char Line[1024]; // Adjust size as needed
+internal void
+PrintMemoryUsage(void)
+{
+    printf("\n\tMemory used in GigaBytes: %f\n", (f64)CPUMemory / (f64)Gigabytes(1));
+    printf("\tMemory used in MegaBytes: %f\n", (f64)CPUMemory / (f64)Megabytes(1));
+    printf("\tGPU instance memory in MegaBytes: %f\n", (f64)InstanceUploads.GPUMemory / (f64)Megabytes(1));
+}
 
-    if (fgets(Line, sizeof(Line), f) == NULL)
+internal void
+CleanupOurStuff(void)
+{
+    // @Note(Victor): The loader may still be busy with the catalogs
+    StopCatalogLoader(&Loader);
+
+    if (TraceAtExit)
     {
-        printf("Error reading header!\n");
-        return (false);
+        WriteChromeTrace(TraceFilename);
     }
+    FreeProfilerGpuTimers();
+
+    UnloadCatalogLoader(&Loader);
+    UnloadSkyDensityMap(&SkyDensity);
 
-    // Read the data into the DataPointsLocation the data is in arcmin declination and right ascension \t separated
-    i32 i = 0;
-    while (fgets(Line, sizeof(Line), f) != NULL)
+    CloseWindow(); // Close window and OpenGL context
+    printf("\n\tClosed window and OpenGL context\n");
+
+    for (u32 i = 0; i < Catalogs.Count; ++i)
     {
-        // printf("Retrieved line of length %zu:\n", Read);
-        // printf("%s", Line);
+        CatalogStream *Stream = &Catalogs.Streams[i];
+        printf("\n\tFreeing %s: %lu (arena peak %lu)\n", GetFileName(Stream->FileName), (unsigned long)GetCatalogStreamMemory(Stream),
+               (unsigned long)Stream->Memory.Peak);
+        FreeCatalogStream(Stream);
+        PrintMemoryUsage();
+    }
 
-        // @Note(Victor): We expect the input data to be separated by tabs !!!
-        // Parse the line
-        char *Token = strtok(Line, "\t");
-        i32 j = 0;
-        while (Token != NULL)
-        {
-            // printf("Token: %s\n", Token);
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+    {
+        FreeInstanceRangeList(&FrameRanges[Lod]);
+    }
 
-            if (j == 0)
-            {
-                DataPointsLocation[i].right_ascension = atof(Token);
-            }
-            else if (j == 1)
-            {
-                DataPointsLocation[i].declination = atof(Token);
-            }
-            else
-            {
-                printf("Error parsing line!\n");
-                return (false);
-            }
+    FreeCameraReplay(&Replay);
 
-            Token = strtok(NULL, "\t");
-            j++;
-        }
+    printf("\n\tFreeing SkyDensity: %lu\n", (unsigned long)GetSkyDensityMemory(&SkyDensity));
+    FreeSkyDensityMap(&SkyDensity);
+    PrintMemoryUsage();
 
-        i++;
-    }
+    // @Note(Victor): There should be no allocated memory left
+    Assert(CPUMemory == 0);
+}
 
-    fclose(f);
+// @Note(Victor): Only the handler sets it. Locking the loader mutex or joining its thread in the handler could
+// deadlock on a main thread that holds the mutex, so the main loop leaves and cleans up the normal way.
+// A second SIGINT (e.g. while a catalog is still being waited for) ends the program right away.
+global_variable volatile sig_atomic_t QuitRequested = 0;
 
-    return (true);
+internal void
+SigIntHandler(i32 Signal)
+{
+    QuitRequested = 1;
+    signal(SIGINT, SIG_DFL);
 }
 
 i32 main(i32 argc, char **argv)
 {
     signal(SIGINT, SigIntHandler);
 
-    ParseInputArgs(argc, argv);
-
-    // Allocate the memory for the data with calloc
-    DataPointsA = (ArcminData *)calloc(MAX_DATA_POINTS, sizeof(ArcminData));
-    CPUMemory += MAX_DATA_POINTS * sizeof(ArcminData);
+    // @Note(Victor): Before anything is printed, so stdout is only the JSON of the benchmark
+    FILE *BenchJson = IsBenchRequested(argc, argv) ? BeginBenchOutput() : nullptr;
 
-    DataPointsB = (ArcminData *)calloc(MAX_DATA_POINTS, sizeof(ArcminData));
-    CPUMemory += MAX_DATA_POINTS * sizeof(ArcminData);
-
-    RedshiftData = (ArcminData *)calloc(MAX_REDSHIFT_DATA_POINTS, sizeof(ArcminData));
+    ParseInputArgs(argc, argv);
 
-    if (ReadInputDataFromFile(DataAFilename, DataPointsA))
+    if (BenchMode)
     {
-        printf("\tReadInputDataFromFile: %s succeeded!\n", DataAFilename);
-    }
-    else
-    {
-        printf("\tReadInputDataFromFile: %s failed!\n", DataAFilename);
-        CleanupOurStuff();
-        return (1);
-    }
+        // The course catalogs, unless --bench-file says otherwise
+        if (Benchmark.FileCount == 0)
+        {
+            Benchmark.Files[Benchmark.FileCount++] = DataAFilename;
+            Benchmark.Files[Benchmark.FileCount++] = DataBFilename;
+        }
 
-    if (ReadInputDataFromFile(DataBFilename, DataPointsB))
-    {
-        printf("\tReadInputDataFromFile: %s succeeded!\n", DataBFilename);
+        return RunHeadlessBenchmark(&Benchmark, BenchJson);
     }
-    else
+
+    if (Replay.PathFileName && !LoadCameraReplay(&Replay))
     {
-        printf("\tReadInputDataFromFile: %s failed!\n", DataBFilename);
-        CleanupOurStuff();
         return (1);
     }
 
-    if (ReadInputDataFromRedshiftFile(RedshiftDataFilename, RedshiftData)) // or another appropriate data structure
+    // Start loading the catalogs on the loader thread, the window opens meanwhile
     {
-        printf("\tSuccessfully loaded redshift data from %s\n", RedshiftDataFilename);
-        CPUMemory += MAX_REDSHIFT_DATA_POINTS * sizeof(ArcminData);
-    }
-    else
-    {
-        printf("Failed to load redshift data from %s\n", RedshiftDataFilename);
-        CleanupOurStuff();
-        return 1;
+        Color MyDARKBLUE = {0, 0, 255, 255};
+
+        // DataPointsA real galaxies and DataPointsB uniformly distributed (galaxies), on a sphere of radius 50
+        CatalogStream *StreamA = AddCatalog(&Catalogs, DataAFilename, GALAXY_LAYOUT_SPHERE, SKY_RADIUS, MyDARKBLUE, true);
+        StreamA->Reader = ReadInputDataFromFile;
+        StreamA->Counter = ReadCatalogDeclaredCount;
+
+        CatalogStream *StreamB = AddCatalog(&Catalogs, DataBFilename, GALAXY_LAYOUT_SPHERE, SKY_RADIUS, RED, true);
+        StreamB->Reader = ReadInputDataFromFile;
+        StreamB->Counter = ReadCatalogDeclaredCount;
+        if (GenerateDataB)
+        {
+            // @Note(Victor): The loader reads A before it gets to B, so A is there to take the bounds from
+            RandomDataB.Reference = &StreamA->Data;
+            StreamB->FileName = "the random catalog";
+            StreamB->Random = &RandomDataB;
+        }
+
+        // Redshift data points with distance from the earth, one unit of the scene is a megaparsec (Mpc).
+        // Hidden at start, it is far bigger than the sky sphere until V puts it on the sky.
+        CatalogStream *StreamRedshift = AddCatalog(&Catalogs, RedshiftDataFilename, GALAXY_LAYOUT_REDSHIFT, 1.0 / HUBBLE_CONSTANT, MAGENTA, false);
+        StreamRedshift->Reader = ReadInputDataFromRedshiftFile;
+        StreamRedshift->Counter = CountRedshiftDataPoints;
+        StreamRedshift->HasRedshift = true;
+
+        for (u32 i = 0; i < ExtraCatalogCount; ++i)
+        {
+            const ExtraCatalog *Extra = &ExtraCatalogs[i];
+            Color ExtraColor = CATALOG_PALETTE[i % ArrayCount(CATALOG_PALETTE)];
+            CatalogStream *Stream = Extra->HasRedshift ? AddCatalog(&Catalogs, Extra->FileName, GALAXY_LAYOUT_REDSHIFT, 1.0 / HUBBLE_CONSTANT, ExtraColor, true)
+                                                       : AddCatalog(&Catalogs, Extra->FileName, GALAXY_LAYOUT_SPHERE, SKY_RADIUS, ExtraColor, true);
+            if (Stream)
+            {
+                Stream->Reader = Extra->HasRedshift ? ReadInputDataFromRedshiftFile : ReadInputDataFromFile;
+                Stream->Counter = Extra->HasRedshift ? CountRedshiftDataPoints : ReadCatalogDeclaredCount;
+                Stream->HasRedshift = Extra->HasRedshift;
+            }
+        }
+
+        StartCatalogRegistry(&Loader, &Catalogs);
     }
 
     printf("\tHello from raylib_galaxy_application!\n\n");
 
-    unsigned long int Count = 0;
-    for (unsigned long int i = 0; i < MAX_DATA_POINTS; ++i)
+    // @Note(Victor): The correlation prints before the window opens, so it waits for the two course catalogs
+    if (RunCorrelation || RunCorrelationCheck)
     {
-        if (DataPointsA[i].right_ascension != 0.0f)
+        if (!WaitForCatalogStream(&Loader, &Catalogs.Streams[CATALOG_A]) || !WaitForCatalogStream(&Loader, &Catalogs.Streams[CATALOG_B]))
         {
-            Count++;
+            printf("\tThe course catalogs could not be loaded!\n");
+            CleanupOurStuff();
+            return (1);
         }
     }
 
-    Assert(Count == MAX_DATA_POINTS);
-    Assert(DataPointsB != NULL);
-
-    Count = 0;
-    for (unsigned long int i = 0; i < MAX_DATA_POINTS; ++i)
+    if (RunCorrelationCheck)
     {
-        if (DataPointsB[i].right_ascension != 0.0f)
+        // @Note(Victor): The reference does one acos per pair, so only a subset of the catalogs
+        const u64 SampleCount = 10000;
+        if (!VerifyAngularCorrelation(&Catalogs.Streams[CATALOG_A].Data, &Catalogs.Streams[CATALOG_B].Data, SampleCount))
         {
-            Count++;
+            printf("\tAngular correlation check failed!\n");
+            CleanupOurStuff();
+            return (1);
         }
     }
 
-    Assert(Count == MAX_DATA_POINTS);
+    if (RunCorrelation)
+    {
+        CorrelationResult *Correlation = (CorrelationResult *)calloc(1, sizeof(CorrelationResult));
+        const Catalog *DataA = &Catalogs.Streams[CATALOG_A].Data;
+        const Catalog *DataB = &Catalogs.Streams[CATALOG_B].Data;
+        ComputeAngularCorrelation(DataA, DataA->Count, DataB, DataB->Count, Correlation, CORRELATION_TREE);
+        PrintCorrelationResult(Correlation, 20);
+        free(Correlation);
+    }
 
-    DataAIsLoaded = true;
+    if (QuitRequested)
+    {
+        printf("\tCaught SIGINT, exiting peacefully!\n");
+        CleanupOurStuff();
+        return (0);
+    }
 
     // Set the camera to rotate around the center of the data
     // MainCamera.position = {0.0f, 60.0f, 100.0f};
@@ -755,85 +1313,6 @@ i32 main(i32 argc, char **argv)
     MainCamera.fovy = 65.0f; // Adjust if necessary
     MainCamera.projection = CAMERA_PERSPECTIVE;
 
-    // Define transforms to be uploaded to GPU for instances
-    {
-        MatrixTransformsA = (Matrix *)calloc(MAX_DATA_POINTS, sizeof(Matrix));
-        CPUMemory += MAX_DATA_POINTS * sizeof(Matrix);
-
-        MatrixTransformsB = (Matrix *)calloc(MAX_DATA_POINTS, sizeof(Matrix));
-        CPUMemory += MAX_DATA_POINTS * sizeof(Matrix);
-
-        MatrixTransformsRedshift = (Matrix *)calloc(MAX_REDSHIFT_DATA_POINTS, sizeof(Matrix));
-        CPUMemory += MAX_REDSHIFT_DATA_POINTS * sizeof(Matrix);
-
-        Matrix rotation = MatrixRotateXYZ({0.0f, 0.0f, 0.0f});
-
-        for (unsigned long int i = 0; i < MAX_DATA_POINTS; ++i)
-        {
-            // DataPointsA real galaxies
-            {
-                // Transform the arc minutes into radians that the trigonometric functions take as input. (sinf, cosf, tanf)
-                f64 RightAscensionRad = (DataPointsA[i].right_ascension / 60.0f) * PIdividedBy180;
-                f64 DeclinationRad = (DataPointsA[i].declination / 60.0f) * PIdividedBy180;
-
-                // Calculate the position on the sphere using spherical coordinates
-                f64 Radius = 50.0f;
-                f64 X = Radius * cosf(RightAscensionRad) * cosf(DeclinationRad);
-                f64 Y = Radius * sinf(DeclinationRad);
-                f64 Z = Radius * sinf(RightAscensionRad) * cosf(DeclinationRad);
-
-                // Create a model matrix for each data point to position it
-                MatrixTransformsA[i] = MatrixIdentity();
-                MatrixTransformsA[i] = MatrixMultiply(MatrixTransformsA[i], MatrixScale(0.1f, 0.1f, 0.1f));
-                MatrixTransformsA[i] = MatrixMultiply(MatrixTransformsA[i], MatrixTranslate(X, Y, Z));
-            }
-
-            // DataPointsB uniformly distributed (galaxies)
-            {
-                f64 RightAscensionRad = (DataPointsB[i].right_ascension / 60.0f) * PIdividedBy180;
-                f64 DeclinationRad = (DataPointsB[i].declination / 60.0f) * PIdividedBy180;
-
-                // Calculate the position on the sphere using spherical coordinates
-                f64 Radius = 50.0f;
-                f64 X = Radius * cosf(RightAscensionRad) * cosf(DeclinationRad);
-                f64 Y = Radius * sinf(DeclinationRad);
-                f64 Z = Radius * sinf(RightAscensionRad) * cosf(DeclinationRad);
-
-                // Create a model matrix for each data point to position it
-                MatrixTransformsB[i] = MatrixIdentity();
-                MatrixTransformsB[i] = MatrixMultiply(MatrixTransformsB[i], MatrixScale(0.1f, 0.1f, 0.1f));
-                MatrixTransformsB[i] = MatrixMultiply(MatrixTransformsB[i], MatrixTranslate(X, Y, Z));
-            }
-        } // end of for loop for the course data
-
-        // Redshift data points with distance from the earth
-        // Redshift can be mapped to a distance value in megaparsecs (Mpc) or another suitable unit for distance.
-        // Assuming Redshift has already been scaled to represent the distance directly, we use it as the radius.
-        for (unsigned long int i = 0; i < MAX_REDSHIFT_DATA_POINTS; ++i)
-        {
-            // Convert RA and DEC to radians
-            f64 rightAscensionRad = (RedshiftData[i].right_ascension / 60.0f) * PIdividedBy180;
-            f64 declinationRad = (RedshiftData[i].declination / 60.0f) * PIdividedBy180;
-
-            // Convert redshift to distance in Megaparsecs
-            f64 distanceMpc = RedshiftToDistance(RedshiftData[i].redshift);
-
-            // Convert distance to some meaningful scale for your simulation
-            // For example, if you want to work in parsecs instead of megaparsecs:
-            f64 distance = distanceMpc * hubbleConstant; // Convert Mpc to parsecs
-
-            // Calculate the position in 3D space using spherical to Cartesian conversion
-            f64 X = distance * cos(declinationRad) * cos(rightAscensionRad);
-            f64 Y = distance * cos(declinationRad) * sin(rightAscensionRad);
-            f64 Z = distance * sin(declinationRad);
-
-            // Apply this position to your model matrix (for example)
-            MatrixTransformsRedshift[i] = MatrixIdentity();
-            MatrixTransformsRedshift[i] = MatrixMultiply(MatrixTransformsRedshift[i], MatrixScale(10000.0f, 10000.0f, 10000.0f));
-            MatrixTransformsRedshift[i] = MatrixMultiply(MatrixTransformsRedshift[i], MatrixTranslate(X, Y, Z));
-        }
-    }
-
     // Raylib
     {
         SetTraceLogLevel(LOG_WARNING);
@@ -843,39 +1322,84 @@ i32 main(i32 argc, char **argv)
 #if defined(PLATFORM_WEB)
         emscripten_set_main_loop(UpdateDrawFrame, 0, 1);
 #else
-        SetTargetFPS(60);
+        // @Note(Victor): The replay measures how fast a frame can be, so no frame cap
+        SetTargetFPS(Replay.PathFileName ? 0 : 60);
     }
 
+    InitProfilerGpuTimers();
+
+    // @Note(Victor): Empty until it is first shown, 0 fills it in from the catalogs
+    AllocateSkyDensityMap(&SkyDensity, SkyDensityColumns);
+    UploadSkyDensityMap(&SkyDensity);
+
     MainFont = LoadFontEx("./resources/fonts/SuperMarioBros2.ttf", 32, 0, 250);
-    CustomShader = LoadShader("./shaders/lighting_instancing.vs", "./shaders/lighting.fs");
-    SphereMesh = GenMeshSphere(0.2f, 16, 16);
+    for (u32 Tier = 0; Tier < SHADING_TIER_COUNT; ++Tier)
+    {
+        GalaxyShaders[Tier] = LoadTieredShader("./shaders/lighting_instancing.vs", "./shaders/lighting.fs", (Shading_Tier)Tier);
+        ImpostorShaders[Tier] = LoadTieredShader("./shaders/lighting_impostor.vs", "./shaders/lighting_impostor.fs", (Shading_Tier)Tier);
+    }
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT - 1; ++Lod)
+    {
+        GalaxyLodMeshes[Lod] = GenMeshSphere(GALAXY_MESH_RADIUS, GALAXY_LOD_RESOLUTIONS[Lod], GALAXY_LOD_RESOLUTIONS[Lod]);
+    }
+    GalaxyLodMeshes[GALAXY_LOD_COUNT - 1] = GenMeshGalaxyPoint();
+    ImpostorMesh = GenMeshImpostorQuad(GALAXY_MESH_RADIUS);
 
     // Get shader locations
-    CustomShader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(CustomShader, "mvp");
-    CustomShader.locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(CustomShader, "viewPos");
-    CustomShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(CustomShader, "instanceTransform");
+    for (u32 Tier = 0; Tier < SHADING_TIER_COUNT; ++Tier)
+    {
+        Shader *Galaxy = &GalaxyShaders[Tier];
+        Galaxy->locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(*Galaxy, "mvp");
+        Galaxy->locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(*Galaxy, "viewPos");
+        GalaxyShaderLocations[Tier] = GetInstanceShaderLocations(*Galaxy);
+
+        Shader *Impostor = &ImpostorShaders[Tier];
+        Impostor->locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(*Impostor, "mvp");
+        Impostor->locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(*Impostor, "matView");
+        Impostor->locs[SHADER_LOC_VECTOR_VIEW] = GetShaderLocation(*Impostor, "viewPos");
+        ImpostorShaderLocations[Tier] = GetInstanceShaderLocations(*Impostor);
+    }
 
     // Lighting
     {
-        // Setting shader values
-        i32 AmbientLoc = GetShaderLocation(CustomShader, "ambient");
-        f64 AmbientValue[4] = {1.0, 1.0, 1.0, 1.0};
-        SetShaderValue(CustomShader, AmbientLoc, &AmbientValue, SHADER_UNIFORM_VEC4);
+        // @Note(Victor): The meshes and the impostors are lit the same way, in every tier that is lit
+        for (u32 Tier = 0; Tier < SHADING_UNLIT; ++Tier)
+        {
+            Shader LitShaders[] = {GalaxyShaders[Tier], ImpostorShaders[Tier]};
+            for (u32 i = 0; i < ArrayCount(LitShaders); ++i)
+            {
+                // Setting shader values
+                i32 AmbientLoc = GetShaderLocation(LitShaders[i], "ambient");
+                f64 AmbientValue[4] = {1.0, 1.0, 1.0, 1.0};
+                SetShaderValue(LitShaders[i], AmbientLoc, &AmbientValue, SHADER_UNIFORM_VEC4);
+
+                i32 ColorDiffuseLoc = GetShaderLocation(LitShaders[i], "colorDiffuse");
+                f64 DiffuseValue[4] = {1.0, 1.0, 1.0, 1.0};
+                SetShaderValue(LitShaders[i], ColorDiffuseLoc, &DiffuseValue, SHADER_UNIFORM_VEC4);
+            }
+        }
+
+        Shader CustomShader = GalaxyShaders[SHADING_PHONG];
 
-        i32 ColorDiffuseLoc = GetShaderLocation(CustomShader, "colorDiffuse");
-        f64 DiffuseValue[4] = {1.0, 1.0, 1.0, 1.0};
-        SetShaderValue(CustomShader, ColorDiffuseLoc, &DiffuseValue, SHADER_UNIFORM_VEC4);
+        Light GalaxyLights[5] = {};
 
         // Like the sun shining on the earth
-        CreateLight(LIGHT_DIRECTIONAL, {1000.0f, 1000.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
+        GalaxyLights[0] = CreateLight(LIGHT_DIRECTIONAL, {1000.0f, 1000.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
 
         // @Note(Victor): We can add more lights to the scene to better show the colors of the galaxies
-        CreateLight(LIGHT_DIRECTIONAL, {-1000.0f, -1000.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
-        CreateLight(LIGHT_DIRECTIONAL, {0.0f, 0.0f, 1000.0f}, Vector3Zero(), WHITE, CustomShader);
-        CreateLight(LIGHT_DIRECTIONAL, {0.0f, 0.0f, -1000.0f}, Vector3Zero(), WHITE, CustomShader);
+        GalaxyLights[1] = CreateLight(LIGHT_DIRECTIONAL, {-1000.0f, -1000.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
+        GalaxyLights[2] = CreateLight(LIGHT_DIRECTIONAL, {0.0f, 0.0f, 1000.0f}, Vector3Zero(), WHITE, CustomShader);
+        GalaxyLights[3] = CreateLight(LIGHT_DIRECTIONAL, {0.0f, 0.0f, -1000.0f}, Vector3Zero(), WHITE, CustomShader);
 
         // We can also add a point light at the center of the earth
-        CreateLight(LIGHT_POINT, {0.0f, 0.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
+        GalaxyLights[4] = CreateLight(LIGHT_POINT, {0.0f, 0.0f, 0.0f}, Vector3Zero(), WHITE, CustomShader);
+
+        ShareLights(GalaxyLights, ArrayCount(GalaxyLights), ImpostorShaders[SHADING_PHONG]);
+
+        // The lambert tier gets them all in one uniform
+        Matrix LightSum = GetLightSum(GalaxyLights, ArrayCount(GalaxyLights));
+        SetShaderValueMatrix(GalaxyShaders[SHADING_LAMBERT], GetShaderLocation(GalaxyShaders[SHADING_LAMBERT], "lightSum"), LightSum);
+        SetShaderValueMatrix(ImpostorShaders[SHADING_LAMBERT], GetShaderLocation(ImpostorShaders[SHADING_LAMBERT], "lightSum"), LightSum);
     }
 
     // Material
@@ -883,7 +1407,7 @@ i32 main(i32 argc, char **argv)
         // NOTE: We are assigning the intancing shader to material.shader
         // to be used on mesh drawing with DrawMeshInstanced()
         Material GalaxyMaterial = LoadMaterialDefault();
-        GalaxyMaterial.shader = CustomShader;
+        GalaxyMaterial.shader = GalaxyShaders[SHADING_PHONG];
 
         GalaxyMaterial.maps[MATERIAL_MAP_DIFFUSE].texture = LoadTexture("./resources/images/galaxy_test_texture_diffuse.png");
         GalaxyMaterial.maps[MATERIAL_MAP_SPECULAR].texture = LoadTexture("./resources/images/galaxy_test_texture_specular.png");
@@ -895,9 +1419,16 @@ i32 main(i32 argc, char **argv)
         float shininess = 32.0f;
         SetShaderValue(GalaxyMaterial.shader, GetShaderLocation(GalaxyMaterial.shader, "shininess"), &shininess, SHADER_UNIFORM_FLOAT);
 
+        SetShaderValue(ImpostorShaders[SHADING_PHONG], GetShaderLocation(ImpostorShaders[SHADING_PHONG], "shininess"), &shininess, SHADER_UNIFORM_FLOAT);
+
         matInstances = GalaxyMaterial;
-        matInstances.shader = CustomShader;
         matInstances.maps[MATERIAL_MAP_DIFFUSE].color = WHITE;
+
+        // @Note(Victor): Same textures and colors, only the shader differs
+        matImpostors = matInstances;
+
+        // GALAXY_SHADING may have picked another tier than phong
+        SetShadingTier(ShadingTier);
     }
 
     printf("\n\tMemory usage before we start the game loop\n");
@@ -911,11 +1442,55 @@ i32 main(i32 argc, char **argv)
     EarthModel.transform = MatrixMultiply(EarthModel.transform, scaleMatrix);
 
     // Main loop
-    while (!WindowShouldClose()) // Detect window close button or ESC key
+    while (!WindowShouldClose() && !Replay.IsDone && !QuitRequested) // Detect window close button or ESC key
     {
-        f64 DeltaTime = GetFrameTime();
+        BeginProfileFrame();
+
+        // @Note(Victor): Uploads what the loader finished since the last frame, never waits for it
+        if (!DataAIsLoaded)
+        {
+            ProfileScope("UpdateCatalogStreams");
+            UpdateCatalogStreams(&Loader);
+            DataAIsLoaded = IsCatalogLoaderDone(&Loader);
+        }
+        else if (Loader.IsWatching)
+        {
+            ProfileScope("UpdateAppendedGalaxies");
+            UpdateAppendedGalaxies(&Loader);
+        }
+
+        if (ShowSkyDensity)
+        {
+            ProfileScope("UpdateSkyDensity");
+            UpdateSkyDensity();
+        }
+
+        // @Note(Victor): The replay starts once every catalog is loaded, then the frames go by its timestep and
+        // the camera by its path. Nothing is picked, the mouse would make the frames differ from run to run.
+        Replay.IsRunning = Replay.PathFileName && DataAIsLoaded && !Replay.IsDone;
+
+        f64 DeltaTime = Replay.IsRunning ? Replay.Path.TimeStep : GetFrameTime();
         GameUpdate(DeltaTime);
+
+        if (Replay.IsRunning)
+        {
+            GetCameraPathPose(&Replay.Path, Replay.Frame, &MainCamera);
+        }
+        else
+        {
+            ProfileScope("Pick");
+            PickGalaxyUnderMouse();
+        }
+
         GameRender(DeltaTime);
+        EndInstanceUploadFrame();
+        EndProfileFrame();
+        EndCameraReplayFrame(&Replay);
+    }
+
+    if (QuitRequested)
+    {
+        printf("\tCaught SIGINT, exiting peacefully!\n");
     }
 #endif
         CleanupOurStuff();
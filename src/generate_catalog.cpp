@@ -0,0 +1,192 @@
+// @Note(Victor): Standalone random catalog writer for stress testing, no window and no raylib.
+//
+//   generate_catalog <count> <output> [--seed=N] [--bounds=<catalog>] [--footprint=<catalog>] [--threads=N] [--compact]
+//
+// The output is the arcmin text format of the course catalogs, or a standalone .gcat (binary, mapped
+// straight in by the visualization) when <output> ends with .gcat. With --compact the galaxies are
+// quantized to fixed point (see catalog.cpp), and a .gcat keeps them that way, 8 bytes per galaxy. Same seed, same catalog, on any
+// number of threads. See catalog_generator.cpp.
+
+// Includes ----------------------------------------------------------------------
+#include "includes.h"
+
+#include <charconv>
+
+// Variables ---------------------------------------------------------------------
+std::atomic<u64> CPUMemory{0};
+
+// Modules -----------------------------------------------------------------------
+#include "parallel.cpp"
+#include "memory_arena.cpp"
+#include "catalog.cpp"
+#include "catalog_loader.cpp"
+#include "catalog_cache.cpp"
+#include "catalog_generator.cpp"
+
+// Longest "ra\tdec\n" line, in arc minutes with 6 decimals
+const u64 GENERATOR_MAX_LINE_SIZE = 48;
+const u64 GENERATOR_BLOCK_SIZE = 262144; // Galaxies formatted by one job
+
+internal bool
+WriteCatalogText(const char *FileName, const Catalog *Source)
+{
+    FILE *f = fopen(FileName, "wb");
+    if (f == NULL)
+    {
+        return (false);
+    }
+
+    bool Success = fprintf(f, "%lu\r\n", (unsigned long)Source->Count) > 0;
+
+    // @Note(Victor): Formatted in parallel one batch of blocks at a time, then written in order
+    u64 BlockCount = (Source->Count + GENERATOR_BLOCK_SIZE - 1) / GENERATOR_BLOCK_SIZE;
+    u64 BatchSize = GetThreadCount() * 2;
+    char *Text = (char *)malloc(BatchSize * GENERATOR_BLOCK_SIZE * GENERATOR_MAX_LINE_SIZE);
+    u64 *TextSize = (u64 *)calloc(BatchSize, sizeof(u64));
+
+    for (u64 FirstBlock = 0; Success && FirstBlock < BlockCount; FirstBlock += BatchSize)
+    {
+        u64 Blocks = BlockCount - FirstBlock < BatchSize ? BlockCount - FirstBlock : BatchSize;
+
+        ParallelFor(Blocks, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                    {
+            for (u64 Block = Begin; Block < End; ++Block)
+            {
+                char *BlockText = Text + Block * GENERATOR_BLOCK_SIZE * GENERATOR_MAX_LINE_SIZE;
+                char *At = BlockText;
+
+                u64 First = (FirstBlock + Block) * GENERATOR_BLOCK_SIZE;
+                u64 Last = First + GENERATOR_BLOCK_SIZE < Source->Count ? First + GENERATOR_BLOCK_SIZE : Source->Count;
+                for (u64 i = First; i < Last; ++i)
+                {
+                    At = std::to_chars(At, At + 24, GetCatalogRightAscension(Source, i), std::chars_format::fixed, 6).ptr;
+                    *At++ = '\t';
+                    At = std::to_chars(At, At + 20, GetCatalogDeclination(Source, i), std::chars_format::fixed, 6).ptr;
+                    *At++ = '\r';
+                    *At++ = '\n';
+                }
+
+                TextSize[Block] = At - BlockText;
+            } });
+
+        for (u64 Block = 0; Success && Block < Blocks; ++Block)
+        {
+            const char *BlockText = Text + Block * GENERATOR_BLOCK_SIZE * GENERATOR_MAX_LINE_SIZE;
+            Success = fwrite(BlockText, 1, TextSize[Block], f) == TextSize[Block];
+        }
+    }
+
+    free(Text);
+    free(TextSize);
+
+    return (fclose(f) == 0) && Success;
+}
+
+internal void
+PrintUsage(void)
+{
+    printf("Usage: generate_catalog <count> <output> [--seed=N] [--bounds=<catalog>] [--footprint=<catalog>] [--threads=N] [--compact]\n");
+    printf("\tWrites <count> random galaxies, uniform on the sphere or inside the bounds/footprint of <catalog>,\n");
+    printf("\tas an arcmin text catalog, or as a binary catalog when <output> ends with .gcat\n");
+    printf("\t--compact stores them in fixed point, a .gcat is then half the size\n");
+}
+
+i32 main(i32 argc, char **argv)
+{
+    if (argc < 3)
+    {
+        PrintUsage();
+        return (1);
+    }
+
+    RandomCatalogOptions Options = {};
+    Options.Region = RANDOM_CATALOG_SPHERE;
+    Options.Count = strtoull(argv[1], nullptr, 10);
+    Options.Seed = RANDOM_CATALOG_DEFAULT_SEED;
+
+    const char *OutputFileName = argv[2];
+    const char *ReferenceFileName = nullptr;
+
+    for (i32 i = 3; i < argc; ++i)
+    {
+        if (strncmp(argv[i], "--seed=", strlen("--seed=")) == 0)
+        {
+            Options.Seed = strtoull(argv[i] + strlen("--seed="), nullptr, 0);
+        }
+        else if (strncmp(argv[i], "--bounds=", strlen("--bounds=")) == 0)
+        {
+            Options.Region = RANDOM_CATALOG_BOUNDS;
+            ReferenceFileName = argv[i] + strlen("--bounds=");
+        }
+        else if (strncmp(argv[i], "--footprint=", strlen("--footprint=")) == 0)
+        {
+            Options.Region = RANDOM_CATALOG_FOOTPRINT;
+            ReferenceFileName = argv[i] + strlen("--footprint=");
+        }
+        else if (strncmp(argv[i], "--threads=", strlen("--threads=")) == 0)
+        {
+            ThreadCountOverride = (u32)atoi(argv[i] + strlen("--threads="));
+        }
+        else if (strcmp(argv[i], "--compact") == 0)
+        {
+            CompactCatalogs = true;
+        }
+        else
+        {
+            PrintUsage();
+            return (1);
+        }
+    }
+
+    if (Options.Count == 0)
+    {
+        PrintUsage();
+        return (1);
+    }
+
+    // Both catalogs live until the end
+    MemoryArena Memory = {};
+
+    // @Note(Victor): The reference is only read, no cache is written next to it (e.g. into input_data)
+    Catalog Reference = {};
+    if (ReferenceFileName)
+    {
+        if (!LoadCatalog(ReferenceFileName, ReadInputDataFromFile, ReadCatalogDeclaredCount, false, false, &Memory, &Reference))
+        {
+            printf("\tCould not load the reference catalog %s\n", ReferenceFileName);
+            FreeArena(&Memory);
+            return (1);
+        }
+        Options.Reference = &Reference;
+    }
+
+    Catalog Random = {};
+    if (!LoadRandomCatalog(&Options, &Memory, &Random))
+    {
+        FreeCatalog(&Reference);
+        FreeArena(&Memory);
+        return (1);
+    }
+
+    f64 StartTime = GetWallClockSeconds();
+
+    usize NameLength = strlen(OutputFileName);
+    bool IsBinary = NameLength > 5 && strcmp(OutputFileName + NameLength - 5, ".gcat") == 0;
+    bool Success = IsBinary ? WriteGcatFile(OutputFileName, &Random, nullptr) : WriteCatalogText(OutputFileName, &Random);
+
+    if (Success)
+    {
+        printf("\tWrote %s in %.3f s\n", OutputFileName, GetWallClockSeconds() - StartTime);
+    }
+    else
+    {
+        printf("\tCould not write %s\n", OutputFileName);
+    }
+
+    FreeCatalog(&Random);
+    FreeCatalog(&Reference);
+    FreeArena(&Memory);
+    Assert(CPUMemory == 0);
+
+    return Success ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+// Instance builder --------------------------------------------------------------
+// @Note(Victor): Turns the catalog columns into SkyInstances for the GPU and GalaxyInstances for the
+// spatial index. The catalogs are in blocks across the
+// worker pool, and inside a block 8 galaxies at a time go through the AVX2 sincos of angle_kernels.cpp.
+// The scalar fallback does the exact same float operations in the same order, so the two kernels give
+// bit identical positions and the tail of a block can use either.
+//
+// A compact catalog (GALAXY_COMPACT) goes through the same kernels, its fixed point i32 arc minutes are
+// widened to doubles 4 at a time and scaled to radians in one multiply. Half the bytes per galaxy are read.
+//
+// The redshift catalog is still in HHMMSS.s / +-DDMMSS and cz (see redshift_catalog.cpp), it is taken
+// apart into degrees in doubles, 4 at a time, on the way into the same sincos.
+
+const u64 INSTANCE_BUILD_BLOCK_SIZE = 16384;
+
+// cz to distance, blueshifted galaxies (a few nearby ones) sit at the origin
+internal inline f32
+VelocityToDistance(f64 Velocity, f64 DistancePerVelocity)
+{
+    return (f32)((Velocity > 0.0 ? Velocity : 0.0) * DistancePerVelocity);
+}
+
+// Coordinate is f64 arc minutes, or the i32 fixed point of a compact catalog
+template <typename Coordinate>
+internal void
+BuildSphereInstancesScalar(const Coordinate *RightAscension, const Coordinate *Declination, u64 Begin, u64 End,
+                           f32 Radius, Color InstanceColor, f32 CatalogId, GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    for (u64 i = Begin; i < End; ++i)
+    {
+        f32 Ra = ArcminToRadians(RightAscension[i]);
+        f32 Dec = ArcminToRadians(Declination[i]);
+
+        f32 SinRa, CosRa, SinDec, CosDec;
+        SinCos(Ra, &SinRa, &CosRa);
+        SinCos(Dec, &SinDec, &CosDec);
+
+        SetGalaxyInstance(&Instances[i], Radius * CosRa * CosDec, Radius * SinDec, Radius * SinRa * CosDec, InstanceColor);
+        SetSkyInstance(&Sky[i], Ra, Dec, 0.0f, CatalogId);
+    }
+}
+
+// @Note(Victor): Same axes as the sphere, so the redshift galaxies line up with the course catalogs
+internal void
+BuildRedshiftInstancesScalar(const f64 *RightAscension, const f64 *Declination, const f64 *Velocity, u64 Begin, u64 End,
+                             f64 DistancePerVelocity, Color InstanceColor, f32 CatalogId, GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    for (u64 i = Begin; i < End; ++i)
+    {
+        f32 Ra = SexagesimalToRadians(RightAscension[i], 15.0);
+        f32 Dec = SexagesimalToRadians(Declination[i], 1.0);
+
+        f32 SinRa, CosRa, SinDec, CosDec;
+        SinCos(Ra, &SinRa, &CosRa);
+        SinCos(Dec, &SinDec, &CosDec);
+
+        f32 Distance = VelocityToDistance(Velocity[i], DistancePerVelocity);
+        SetGalaxyInstance(&Instances[i], Distance * CosRa * CosDec, Distance * SinDec, Distance * SinRa * CosDec, InstanceColor);
+        SetSkyInstance(&Sky[i], Ra, Dec, (f32)Velocity[i], CatalogId);
+    }
+}
+
+#if ANGLE_KERNELS_HAS_AVX2
+__attribute__((target("avx2"))) internal inline __m128
+VelocityToDistance4(const f64 *Velocity, f64 DistancePerVelocity)
+{
+    __m256d Receding = _mm256_max_pd(_mm256_loadu_pd(Velocity), _mm256_setzero_pd());
+    return _mm256_cvtpd_ps(_mm256_mul_pd(Receding, _mm256_set1_pd(DistancePerVelocity)));
+}
+
+// Interleaves 8 of each of 4 columns into 8 rows of 4 floats, GalaxyInstances and SkyInstances alike
+__attribute__((target("avx2"))) internal inline void
+StoreInterleaved8(f32 *Out, __m256 A, __m256 B, __m256 C, __m256 D)
+{
+    __m256 ABLow = _mm256_unpacklo_ps(A, B);
+    __m256 ABHigh = _mm256_unpackhi_ps(A, B);
+    __m256 CDLow = _mm256_unpacklo_ps(C, D);
+    __m256 CDHigh = _mm256_unpackhi_ps(C, D);
+
+    // Row 0 and 4, 1 and 5, ... in the two halves
+    __m256 Row04 = _mm256_shuffle_ps(ABLow, CDLow, 0x44);
+    __m256 Row15 = _mm256_shuffle_ps(ABLow, CDLow, 0xEE);
+    __m256 Row26 = _mm256_shuffle_ps(ABHigh, CDHigh, 0x44);
+    __m256 Row37 = _mm256_shuffle_ps(ABHigh, CDHigh, 0xEE);
+
+    _mm256_storeu_ps(Out + 0, _mm256_permute2f128_ps(Row04, Row15, 0x20));
+    _mm256_storeu_ps(Out + 8, _mm256_permute2f128_ps(Row26, Row37, 0x20));
+    _mm256_storeu_ps(Out + 16, _mm256_permute2f128_ps(Row04, Row15, 0x31));
+    _mm256_storeu_ps(Out + 24, _mm256_permute2f128_ps(Row26, Row37, 0x31));
+}
+
+__attribute__((target("avx2"))) internal __m256
+GetColor8(Color InstanceColor)
+{
+    GalaxyInstance Packed = {};
+    SetGalaxyInstance(&Packed, 0.0, 0.0, 0.0, InstanceColor);
+
+    f32 ColorBits;
+    memcpy(&ColorBits, Packed.Color, sizeof(ColorBits));
+    return _mm256_set1_ps(ColorBits);
+}
+
+template <typename Coordinate>
+__attribute__((target("avx2"))) internal void
+BuildSphereInstancesAVX2(const Coordinate *RightAscension, const Coordinate *Declination, u64 Begin, u64 End,
+                         f32 Radius, Color InstanceColor, f32 CatalogId, GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    const __m256 VRadius = _mm256_set1_ps(Radius);
+    const __m256 Colors = GetColor8(InstanceColor);
+    const __m256 Catalogs = _mm256_set1_ps(CatalogId);
+
+    u64 i = Begin;
+    for (; i + 8 <= End; i += 8)
+    {
+        __m256 Ra = ArcminToRadians8(RightAscension + i);
+        __m256 Dec = ArcminToRadians8(Declination + i);
+
+        __m256 SinRa, CosRa, SinDec, CosDec;
+        SinCos8(Ra, &SinRa, &CosRa);
+        SinCos8(Dec, &SinDec, &CosDec);
+
+        __m256 X = _mm256_mul_ps(_mm256_mul_ps(VRadius, CosRa), CosDec);
+        __m256 Y = _mm256_mul_ps(VRadius, SinDec);
+        __m256 Z = _mm256_mul_ps(_mm256_mul_ps(VRadius, SinRa), CosDec);
+
+        StoreInterleaved8((f32 *)(Instances + i), X, Y, Z, Colors);
+        StoreInterleaved8((f32 *)(Sky + i), Ra, Dec, _mm256_setzero_ps(), Catalogs);
+    }
+
+    BuildSphereInstancesScalar(RightAscension, Declination, i, End, Radius, InstanceColor, CatalogId, Instances, Sky);
+}
+
+__attribute__((target("avx2"))) internal void
+BuildRedshiftInstancesAVX2(const f64 *RightAscension, const f64 *Declination, const f64 *Velocity, u64 Begin, u64 End,
+                           f64 DistancePerVelocity, Color InstanceColor, f32 CatalogId, GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    const __m256 Colors = GetColor8(InstanceColor);
+    const __m256 Catalogs = _mm256_set1_ps(CatalogId);
+
+    u64 i = Begin;
+    for (; i + 8 <= End; i += 8)
+    {
+        __m256 Ra = SexagesimalToRadians8(RightAscension + i, 15.0);
+        __m256 Dec = SexagesimalToRadians8(Declination + i, 1.0);
+
+        __m256 SinRa, CosRa, SinDec, CosDec;
+        SinCos8(Ra, &SinRa, &CosRa);
+        SinCos8(Dec, &SinDec, &CosDec);
+
+        __m256 Distance = _mm256_set_m128(VelocityToDistance4(Velocity + i + 4, DistancePerVelocity),
+                                          VelocityToDistance4(Velocity + i, DistancePerVelocity));
+
+        __m256 X = _mm256_mul_ps(_mm256_mul_ps(Distance, CosRa), CosDec);
+        __m256 Y = _mm256_mul_ps(Distance, SinDec);
+        __m256 Z = _mm256_mul_ps(_mm256_mul_ps(Distance, SinRa), CosDec);
+
+        __m256 Velocity8 = _mm256_set_m128(_mm256_cvtpd_ps(_mm256_loadu_pd(Velocity + i + 4)), _mm256_cvtpd_ps(_mm256_loadu_pd(Velocity + i)));
+
+        StoreInterleaved8((f32 *)(Instances + i), X, Y, Z, Colors);
+        StoreInterleaved8((f32 *)(Sky + i), Ra, Dec, Velocity8, Catalogs);
+    }
+
+    BuildRedshiftInstancesScalar(RightAscension, Declination, Velocity, i, End, DistancePerVelocity, InstanceColor, CatalogId, Instances, Sky);
+}
+#endif
+
+template <typename Coordinate>
+internal void
+BuildSphereInstanceBlock(const Coordinate *RightAscension, const Coordinate *Declination, u64 Begin, u64 End, bool UseAVX2,
+                         f32 Radius, Color InstanceColor, f32 CatalogId, GalaxyInstance *Instances, SkyInstance *Sky)
+{
+#if ANGLE_KERNELS_HAS_AVX2
+    if (UseAVX2)
+    {
+        BuildSphereInstancesAVX2(RightAscension, Declination, Begin, End, Radius, InstanceColor, CatalogId, Instances, Sky);
+        return;
+    }
+#endif
+    BuildSphereInstancesScalar(RightAscension, Declination, Begin, End, Radius, InstanceColor, CatalogId, Instances, Sky);
+}
+
+// @Note(Victor): Galaxies [First, First + Count) of a catalog on a sphere of Radius around the origin.
+// CatalogId goes into every SkyInstance, see InstanceUniforms.
+internal void
+BuildSphereInstances(const Catalog *Source, u64 First, u64 Count, f32 Radius, Color InstanceColor, u32 CatalogId,
+                     GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    Assert(First + Count <= Source->Count);
+
+    bool UseAVX2 = UseAngleKernelsAVX2();
+    ParallelFor(Count, INSTANCE_BUILD_BLOCK_SIZE, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        Begin += First;
+        End += First;
+        if (IsCatalogCompact(Source))
+        {
+            BuildSphereInstanceBlock(Source->RightAscensionFixed, Source->DeclinationFixed, Begin, End, UseAVX2,
+                                     Radius, InstanceColor, (f32)CatalogId, Instances, Sky);
+            return;
+        }
+        BuildSphereInstanceBlock(Source->RightAscension, Source->Declination, Begin, End, UseAVX2,
+                                 Radius, InstanceColor, (f32)CatalogId, Instances, Sky); });
+}
+
+// @Note(Victor): Galaxies [First, First + Count) of a redshift catalog, at cz * DistancePerVelocity from the origin
+internal void
+BuildRedshiftInstances(const Catalog *Source, u64 First, u64 Count, f64 DistancePerVelocity, Color InstanceColor, u32 CatalogId,
+                       GalaxyInstance *Instances, SkyInstance *Sky)
+{
+    Assert(First + Count <= Source->Count && Source->Redshift != nullptr);
+
+    bool UseAVX2 = UseAngleKernelsAVX2();
+    ParallelFor(Count, INSTANCE_BUILD_BLOCK_SIZE, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        Begin += First;
+        End += First;
+#if ANGLE_KERNELS_HAS_AVX2
+        if (UseAVX2)
+        {
+            BuildRedshiftInstancesAVX2(Source->RightAscension, Source->Declination, Source->Redshift, Begin, End,
+                                       DistancePerVelocity, InstanceColor, (f32)CatalogId, Instances, Sky);
+            return;
+        }
+#endif
+        BuildRedshiftInstancesScalar(Source->RightAscension, Source->Declination, Source->Redshift, Begin, End,
+                                     DistancePerVelocity, InstanceColor, (f32)CatalogId, Instances, Sky); });
+}
@@ -0,0 +1,565 @@
+// Instancing --------------------------------------------------------------------
+// @Note(Victor): DrawMeshInstanced wants a full 4x4 Matrix per instance, but every galaxy is just a
+// translation with the same uniform scale. So we send 16 bytes per galaxy instead of 64, its raw RA and
+// Dec (radians), cz and the id of its catalog, and the instancing shaders project it themselves from
+// uniforms: the radius of the sky sphere, the distance per km/s and a blend between the two. Moving the
+// galaxies between the sky and their redshift distance, or growing the sphere, is a uniform change, no
+// instance is rebuilt or uploaded.
+//
+// Everything that belongs to a catalog (color, scale, distance per km/s, blend) is in uniform arrays
+// indexed by the catalog id of the instance, so the galaxies of every catalog can share one buffer and
+// one draw, and recoloring a catalog is still only a uniform.
+//
+// The instances live in static GPU buffers that are uploaded once after they are built
+// (and again only when a catalog changes), the draw just points the mesh at them. A buffer is split
+// over as many GPU buffers of GALAXY_INSTANCE_CHUNK_SIZE instances as it needs, so 100M galaxies never
+// ask the driver for one 1.6 GB buffer, and every instanced draw stays inside one chunk.
+//
+// GalaxyInstance is the same galaxy placed on the CPU, where the spatial index is built from.
+
+struct GalaxyInstance
+{
+    f32 X;
+    f32 Y;
+    f32 Z;
+    u8 Color[4]; // RGBA
+};
+
+struct SkyInstance
+{
+    f32 RightAscension; // Radians
+    f32 Declination;    // Radians
+    f32 Velocity;       // cz in km/s, 0 for the catalogs without redshift
+    f32 Catalog;        // Catalog id, the slot of its uniforms (a float, GL 3.3 has no integer attributes in rlgl)
+};
+
+static_assert(sizeof(SkyInstance) == 16, "SkyInstance is uploaded as is, keep it 16 bytes");
+static_assert(sizeof(SkyInstance) <= sizeof(GalaxyInstance), "ApplySpatialOrder sorts the SkyInstances in the scratch of the GalaxyInstances");
+
+const u64 GALAXY_INSTANCE_CHUNK_SIZE = 1ULL << 22; // 64 MB of instances per GPU buffer
+
+// @Note(Victor): Size of the uniform arrays of the instancing shaders, keep MAX_CATALOGS in the .vs files the same
+const u32 INSTANCE_CATALOG_MAX_COUNT = 16;
+
+struct GalaxyInstanceBuffer
+{
+    u32 *Ids; // One GPU buffer per chunk, nullptr until something is reserved
+    u32 ChunkCount;
+    u64 Count;
+    u64 Capacity;
+};
+
+// A run of consecutive instances in a GalaxyInstanceBuffer
+struct InstanceRange
+{
+    u64 First;
+    u64 Count;
+};
+
+// The runs of several catalogs that are drawn together, grows to the most runs a frame had
+struct InstanceRangeList
+{
+    InstanceRange *Ranges;
+    u32 Count;
+    u32 Capacity;
+};
+
+struct InstanceUploadStats
+{
+    u64 FrameBytes;     // Uploaded since the last EndInstanceUploadFrame
+    u64 LastFrameBytes; // What the debug output shows
+    u64 TotalBytes;
+    u64 GPUMemory;      // Capacity of all instance buffers
+};
+
+global_variable InstanceUploadStats InstanceUploads = {};
+
+struct InstanceShaderLocations
+{
+    i32 Sky;
+    i32 Color;
+    i32 Scale;
+    i32 SphereRadius;
+    i32 DistanceScale;
+    i32 RedshiftBlend;
+};
+
+// @Note(Victor): Where and how the catalogs are drawn, the uniforms of the instancing shaders. All but the
+// sphere are per catalog, a galaxy of catalog c goes to
+// direction * mix(SphereRadius, cz * DistancePerVelocity[c], RedshiftBlend[c]).
+struct InstanceUniforms
+{
+    f32 SphereRadius;
+    u32 CatalogCount; // Only the slots up to here are sent
+
+    f32 Scale[INSTANCE_CATALOG_MAX_COUNT];
+    f32 Color[INSTANCE_CATALOG_MAX_COUNT][4];
+    f32 DistancePerVelocity[INSTANCE_CATALOG_MAX_COUNT];
+    f32 RedshiftBlend[INSTANCE_CATALOG_MAX_COUNT]; // 0 on the sky sphere, 1 at the redshift distance
+};
+
+internal InstanceShaderLocations
+GetInstanceShaderLocations(Shader InstanceShader)
+{
+    InstanceShaderLocations Result = {};
+    Result.Sky = GetShaderLocationAttrib(InstanceShader, "instanceSky");
+    Result.Color = GetShaderLocation(InstanceShader, "catalogColor");
+    Result.Scale = GetShaderLocation(InstanceShader, "catalogScale");
+    Result.SphereRadius = GetShaderLocation(InstanceShader, "sphereRadius");
+    Result.DistanceScale = GetShaderLocation(InstanceShader, "catalogDistanceScale");
+    Result.RedshiftBlend = GetShaderLocation(InstanceShader, "catalogRedshiftBlend");
+
+    return Result;
+}
+
+internal void
+SetCatalogUniforms(InstanceUniforms *Uniforms, u32 Catalog, f32 Scale, Color CatalogColor, f32 DistancePerVelocity, f32 RedshiftBlend)
+{
+    Assert(Catalog < INSTANCE_CATALOG_MAX_COUNT);
+
+    Uniforms->Scale[Catalog] = Scale;
+    Uniforms->Color[Catalog][0] = CatalogColor.r / 255.0f;
+    Uniforms->Color[Catalog][1] = CatalogColor.g / 255.0f;
+    Uniforms->Color[Catalog][2] = CatalogColor.b / 255.0f;
+    Uniforms->Color[Catalog][3] = CatalogColor.a / 255.0f;
+    Uniforms->DistancePerVelocity[Catalog] = DistancePerVelocity;
+    Uniforms->RedshiftBlend[Catalog] = RedshiftBlend;
+
+    if (Catalog + 1 > Uniforms->CatalogCount)
+    {
+        Uniforms->CatalogCount = Catalog + 1;
+    }
+}
+
+internal void
+SetGalaxyInstance(GalaxyInstance *Instance, f64 X, f64 Y, f64 Z, Color InstanceColor)
+{
+    Instance->X = (f32)X;
+    Instance->Y = (f32)Y;
+    Instance->Z = (f32)Z;
+    Instance->Color[0] = InstanceColor.r;
+    Instance->Color[1] = InstanceColor.g;
+    Instance->Color[2] = InstanceColor.b;
+    Instance->Color[3] = InstanceColor.a;
+}
+
+internal void
+SetSkyInstance(SkyInstance *Instance, f32 RightAscension, f32 Declination, f32 Velocity, f32 Catalog)
+{
+    Instance->RightAscension = RightAscension;
+    Instance->Declination = Declination;
+    Instance->Velocity = Velocity;
+    Instance->Catalog = Catalog;
+}
+
+// @Note(Victor): A square around the origin in the xy plane, Radius from the center to every side. The impostor shader turns it
+// towards the camera and draws the sphere on it. The texture coordinates go from (0, 0) in one corner to
+// (1, 1) in the other, so the fragment shader knows where on the sphere it is.
+internal Mesh
+GenMeshImpostorQuad(f32 Radius)
+{
+    const f32 Corners[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+    const u16 Indices[6] = {0, 1, 2, 0, 2, 3};
+
+    Mesh Result = {};
+    Result.vertexCount = 4;
+    Result.triangleCount = 2;
+    Result.vertices = (f32 *)MemAlloc(4 * 3 * sizeof(f32));
+    Result.texcoords = (f32 *)MemAlloc(4 * 2 * sizeof(f32));
+    Result.normals = (f32 *)MemAlloc(4 * 3 * sizeof(f32));
+    Result.indices = (u16 *)MemAlloc(6 * sizeof(u16));
+
+    for (u32 i = 0; i < 4; ++i)
+    {
+        Result.vertices[i * 3 + 0] = Corners[i][0] * Radius;
+        Result.vertices[i * 3 + 1] = Corners[i][1] * Radius;
+        Result.vertices[i * 3 + 2] = 0.0f;
+
+        Result.texcoords[i * 2 + 0] = Corners[i][0] * 0.5f + 0.5f;
+        Result.texcoords[i * 2 + 1] = Corners[i][1] * 0.5f + 0.5f;
+
+        Result.normals[i * 3 + 0] = 0.0f;
+        Result.normals[i * 3 + 1] = 0.0f;
+        Result.normals[i * 3 + 2] = 1.0f;
+    }
+
+    memcpy(Result.indices, Indices, sizeof(Indices));
+
+    UploadMesh(&Result, false);
+
+    return Result;
+}
+
+// @Note(Victor): The lowest level of detail, one degenerate triangle at the center of the galaxy that is
+// drawn in point mode (see DrawGalaxyPoints), so every galaxy is a single pixel
+internal Mesh
+GenMeshGalaxyPoint(void)
+{
+    Mesh Result = {};
+    Result.vertexCount = 3;
+    Result.triangleCount = 1;
+    Result.vertices = (f32 *)MemAlloc(3 * 3 * sizeof(f32));
+    Result.texcoords = (f32 *)MemAlloc(3 * 2 * sizeof(f32));
+    Result.normals = (f32 *)MemAlloc(3 * 3 * sizeof(f32));
+
+    for (u32 i = 0; i < 3; ++i)
+    {
+        Result.texcoords[i * 2 + 0] = 0.5f;
+        Result.texcoords[i * 2 + 1] = 0.5f;
+
+        // Facing up, towards the sun light
+        Result.normals[i * 3 + 1] = 1.0f;
+    }
+
+    UploadMesh(&Result, false);
+
+    return Result;
+}
+
+internal void
+UnloadGalaxyInstances(GalaxyInstanceBuffer *Buffer)
+{
+    for (u32 Chunk = 0; Chunk < Buffer->ChunkCount; ++Chunk)
+    {
+        rlUnloadVertexBuffer(Buffer->Ids[Chunk]);
+    }
+
+    if (Buffer->Ids)
+    {
+        InstanceUploads.GPUMemory -= Buffer->Capacity * sizeof(SkyInstance);
+        CPUMemory -= (Buffer->ChunkCount + 1) * sizeof(u32);
+        free(Buffer->Ids);
+    }
+
+    *Buffer = {};
+}
+
+// Makes room for Capacity instances without uploading any, for catalogs that arrive in parts
+internal void
+ReserveGalaxyInstances(GalaxyInstanceBuffer *Buffer, u64 Capacity)
+{
+    if (Buffer->Ids != nullptr && Capacity <= Buffer->Capacity)
+    {
+        return;
+    }
+
+    UnloadGalaxyInstances(Buffer);
+
+    Buffer->ChunkCount = (u32)((Capacity + GALAXY_INSTANCE_CHUNK_SIZE - 1) / GALAXY_INSTANCE_CHUNK_SIZE);
+    Buffer->Ids = (u32 *)calloc(Buffer->ChunkCount + 1, sizeof(u32));
+    CPUMemory += (Buffer->ChunkCount + 1) * sizeof(u32);
+
+    for (u32 Chunk = 0; Chunk < Buffer->ChunkCount; ++Chunk)
+    {
+        u64 First = Chunk * GALAXY_INSTANCE_CHUNK_SIZE;
+        u64 Count = Capacity - First < GALAXY_INSTANCE_CHUNK_SIZE ? Capacity - First : GALAXY_INSTANCE_CHUNK_SIZE;
+        Buffer->Ids[Chunk] = rlLoadVertexBuffer(nullptr, (i32)(Count * sizeof(SkyInstance)), false);
+    }
+
+    Buffer->Count = 0;
+    Buffer->Capacity = Capacity;
+    InstanceUploads.GPUMemory += Capacity * sizeof(SkyInstance);
+}
+
+// @Note(Victor): Room for Capacity instances in a buffer that is only ever appended to, without touching what is
+// uploaded already. It grows by whole chunks, so every chunk keeps its place and only the new ones are created.
+internal void
+GrowGalaxyInstances(GalaxyInstanceBuffer *Buffer, u64 Capacity)
+{
+    if (Buffer->Ids != nullptr && Capacity <= Buffer->Capacity)
+    {
+        return;
+    }
+    Assert(Buffer->Capacity % GALAXY_INSTANCE_CHUNK_SIZE == 0);
+
+    u32 ChunkCount = (u32)((Capacity + GALAXY_INSTANCE_CHUNK_SIZE - 1) / GALAXY_INSTANCE_CHUNK_SIZE);
+    u32 *Ids = (u32 *)calloc(ChunkCount + 1, sizeof(u32));
+    CPUMemory += (ChunkCount + 1) * sizeof(u32);
+
+    if (Buffer->Ids)
+    {
+        memcpy(Ids, Buffer->Ids, Buffer->ChunkCount * sizeof(u32));
+        CPUMemory -= (Buffer->ChunkCount + 1) * sizeof(u32);
+        free(Buffer->Ids);
+    }
+
+    // Written a little at a time, every frame something is appended
+    for (u32 Chunk = Buffer->ChunkCount; Chunk < ChunkCount; ++Chunk)
+    {
+        Ids[Chunk] = rlLoadVertexBuffer(nullptr, (i32)(GALAXY_INSTANCE_CHUNK_SIZE * sizeof(SkyInstance)), true);
+    }
+
+    u64 NewCapacity = ChunkCount * GALAXY_INSTANCE_CHUNK_SIZE;
+    InstanceUploads.GPUMemory += (NewCapacity - Buffer->Capacity) * sizeof(SkyInstance);
+
+    Buffer->Ids = Ids;
+    Buffer->ChunkCount = ChunkCount;
+    Buffer->Capacity = NewCapacity;
+}
+
+// @Note(Victor): Overwrites [First, First + Count) of a buffer that already has room for them with
+// Instances[0, Count). Buffer->Count grows to the end of the range, so the draws pick up the new instances.
+internal void
+UploadGalaxyInstanceRange(GalaxyInstanceBuffer *Buffer, const SkyInstance *Instances, u64 First, u64 Count)
+{
+    Assert(Buffer->Ids != nullptr && First + Count <= Buffer->Capacity);
+
+    // One update per chunk the range touches
+    for (u64 At = First; At < First + Count;)
+    {
+        u64 Chunk = At / GALAXY_INSTANCE_CHUNK_SIZE;
+        u64 ChunkFirst = Chunk * GALAXY_INSTANCE_CHUNK_SIZE;
+        u64 End = First + Count < ChunkFirst + GALAXY_INSTANCE_CHUNK_SIZE ? First + Count : ChunkFirst + GALAXY_INSTANCE_CHUNK_SIZE;
+
+        rlUpdateVertexBuffer(Buffer->Ids[Chunk], Instances + (At - First), (i32)((End - At) * sizeof(SkyInstance)),
+                             (i32)((At - ChunkFirst) * sizeof(SkyInstance)));
+        At = End;
+    }
+
+    if (First + Count > Buffer->Count)
+    {
+        Buffer->Count = First + Count;
+    }
+
+    u64 Size = Count * sizeof(SkyInstance);
+    InstanceUploads.FrameBytes += Size;
+    InstanceUploads.TotalBytes += Size;
+    ProfileCount(PROFILE_COUNTER_UPLOAD_BYTES, Size);
+}
+
+// @Note(Victor): Creates the buffers the first time or when they have to grow, otherwise overwrites them in place
+internal void
+UploadGalaxyInstances(GalaxyInstanceBuffer *Buffer, const SkyInstance *Instances, u64 Count)
+{
+    ReserveGalaxyInstances(Buffer, Count);
+    UploadGalaxyInstanceRange(Buffer, Instances, 0, Count);
+    Buffer->Count = Count;
+}
+
+// @Note(Victor): Appends Ranges moved by Offset, a run that continues the last one just extends it
+internal void
+AppendInstanceRanges(InstanceRangeList *List, const InstanceRange *Ranges, u32 Count, u64 Offset)
+{
+    if (List->Count + Count > List->Capacity)
+    {
+        u32 Capacity = List->Capacity * 2 > List->Count + Count ? List->Capacity * 2 : List->Count + Count;
+        List->Ranges = (InstanceRange *)realloc(List->Ranges, Capacity * sizeof(InstanceRange));
+        CPUMemory += (Capacity - List->Capacity) * sizeof(InstanceRange);
+        List->Capacity = Capacity;
+    }
+
+    for (u32 i = 0; i < Count; ++i)
+    {
+        InstanceRange Range = {Ranges[i].First + Offset, Ranges[i].Count};
+        if (List->Count > 0)
+        {
+            InstanceRange *Last = &List->Ranges[List->Count - 1];
+            if (Last->First + Last->Count == Range.First)
+            {
+                Last->Count += Range.Count;
+                continue;
+            }
+        }
+        List->Ranges[List->Count++] = Range;
+    }
+}
+
+internal void
+FreeInstanceRangeList(InstanceRangeList *List)
+{
+    CPUMemory -= List->Capacity * sizeof(InstanceRange);
+    free(List->Ranges);
+    *List = {};
+}
+
+// Call once per frame, after the frame is drawn
+internal void
+EndInstanceUploadFrame(void)
+{
+    InstanceUploads.LastFrameBytes = InstanceUploads.FrameBytes;
+    InstanceUploads.FrameBytes = 0;
+}
+
+// @Note(Victor): rlSetVertexAttribute takes the offset as a pointer before raylib 5.5 and as an int after
+internal void
+SetInstanceAttribute(i32 Location, i32 ComponentCount, i32 Type, bool Normalized, u64 Offset)
+{
+    if (Location < 0)
+    {
+        return;
+    }
+
+    rlEnableVertexAttribute(Location);
+#if (RAYLIB_VERSION_MAJOR > 5) || (RAYLIB_VERSION_MAJOR == 5 && RAYLIB_VERSION_MINOR >= 5)
+    rlSetVertexAttribute(Location, ComponentCount, Type, Normalized, sizeof(SkyInstance), (i32)Offset);
+#else
+    rlSetVertexAttribute(Location, ComponentCount, Type, Normalized, sizeof(SkyInstance), (const void *)Offset);
+#endif
+    rlSetVertexAttributeDivisor(Location, 1);
+}
+
+// Same as DrawMeshInstanced, minus the per instance matrices and the upload. The ranges can be of any of the
+// catalogs in the buffer, the uniforms of all of them are set once. One instanced draw per range, the
+// instance attributes are pointed at the first instance of the range (there is no base instance in GL 3.3).
+internal void
+DrawGalaxyInstanceRanges(Mesh InstanceMesh, Material InstanceMaterial, InstanceShaderLocations Locations,
+                         const GalaxyInstanceBuffer *Buffer, const InstanceRange *Ranges, u32 RangeCount, const InstanceUniforms *Uniforms)
+{
+    if (Buffer->Ids == nullptr || RangeCount == 0)
+    {
+        return;
+    }
+
+    Shader InstanceShader = InstanceMaterial.shader;
+    rlEnableShader(InstanceShader.id);
+
+    if (InstanceShader.locs[SHADER_LOC_COLOR_DIFFUSE] != -1)
+    {
+        Color Diffuse = InstanceMaterial.maps[MATERIAL_MAP_DIFFUSE].color;
+        f32 Values[4] = {Diffuse.r / 255.0f, Diffuse.g / 255.0f, Diffuse.b / 255.0f, Diffuse.a / 255.0f};
+        rlSetUniform(InstanceShader.locs[SHADER_LOC_COLOR_DIFFUSE], Values, SHADER_UNIFORM_VEC4, 1);
+    }
+
+    // @Note(Victor): Set once for every catalog, the instances pick their slot
+    i32 CatalogCount = (i32)Uniforms->CatalogCount;
+    if (Locations.Color != -1)
+    {
+        rlSetUniform(Locations.Color, Uniforms->Color, SHADER_UNIFORM_VEC4, CatalogCount);
+    }
+
+    if (Locations.Scale != -1)
+    {
+        rlSetUniform(Locations.Scale, Uniforms->Scale, SHADER_UNIFORM_FLOAT, CatalogCount);
+    }
+
+    if (Locations.SphereRadius != -1)
+    {
+        rlSetUniform(Locations.SphereRadius, &Uniforms->SphereRadius, SHADER_UNIFORM_FLOAT, 1);
+    }
+
+    if (Locations.DistanceScale != -1)
+    {
+        rlSetUniform(Locations.DistanceScale, Uniforms->DistancePerVelocity, SHADER_UNIFORM_FLOAT, CatalogCount);
+    }
+
+    if (Locations.RedshiftBlend != -1)
+    {
+        rlSetUniform(Locations.RedshiftBlend, Uniforms->RedshiftBlend, SHADER_UNIFORM_FLOAT, CatalogCount);
+    }
+
+    Matrix View = rlGetMatrixModelview();
+    Matrix Projection = rlGetMatrixProjection();
+
+    if (InstanceShader.locs[SHADER_LOC_MATRIX_VIEW] != -1)
+    {
+        rlSetUniformMatrix(InstanceShader.locs[SHADER_LOC_MATRIX_VIEW], View);
+    }
+
+    if (InstanceShader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1)
+    {
+        rlSetUniformMatrix(InstanceShader.locs[SHADER_LOC_MATRIX_PROJECTION], Projection);
+    }
+
+    if (InstanceShader.locs[SHADER_LOC_MATRIX_NORMAL] != -1)
+    {
+        rlSetUniformMatrix(InstanceShader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixIdentity());
+    }
+
+    // Bind the texture maps of the material
+    for (i32 i = 0; i < MAX_MATERIAL_MAPS; ++i)
+    {
+        if (InstanceMaterial.maps[i].texture.id > 0)
+        {
+            rlActiveTextureSlot(i);
+            rlEnableTexture(InstanceMaterial.maps[i].texture.id);
+            rlSetUniform(InstanceShader.locs[SHADER_LOC_MAP_DIFFUSE + i], &i, SHADER_UNIFORM_INT, 1);
+        }
+    }
+
+    Matrix ModelView = MatrixMultiply(rlGetMatrixTransform(), View);
+    rlSetUniformMatrix(InstanceShader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(ModelView, Projection));
+
+    // Hook the instance buffer up to the mesh, the buffers share the mesh so this is done every draw.
+    // A range that crosses into the next chunk is drawn in two parts.
+    rlEnableVertexArray(InstanceMesh.vaoId);
+    u64 BoundChunk = ~0ULL;
+
+    for (u32 RangeIndex = 0; RangeIndex < RangeCount; ++RangeIndex)
+    {
+        InstanceRange Range = Ranges[RangeIndex];
+        Assert(Range.First + Range.Count <= Buffer->Count);
+
+        for (u64 At = Range.First; At < Range.First + Range.Count;)
+        {
+            u64 Chunk = At / GALAXY_INSTANCE_CHUNK_SIZE;
+            u64 ChunkFirst = Chunk * GALAXY_INSTANCE_CHUNK_SIZE;
+            u64 End = Range.First + Range.Count < ChunkFirst + GALAXY_INSTANCE_CHUNK_SIZE ? Range.First + Range.Count : ChunkFirst + GALAXY_INSTANCE_CHUNK_SIZE;
+            i32 Count = (i32)(End - At);
+
+            if (Chunk != BoundChunk)
+            {
+                rlEnableVertexBuffer(Buffer->Ids[Chunk]);
+                BoundChunk = Chunk;
+            }
+
+            u64 Offset = (At - ChunkFirst) * sizeof(SkyInstance);
+            SetInstanceAttribute(Locations.Sky, 4, RL_FLOAT, false, Offset + offsetof(SkyInstance, RightAscension));
+
+            if (InstanceMesh.indices != NULL)
+            {
+                rlDrawVertexArrayElementsInstanced(0, InstanceMesh.triangleCount * 3, 0, Count);
+            }
+            else
+            {
+                rlDrawVertexArrayInstanced(0, InstanceMesh.vertexCount, Count);
+            }
+
+            ProfileCount(PROFILE_COUNTER_DRAW_CALLS, 1);
+            ProfileCount(PROFILE_COUNTER_INSTANCES, (u64)Count);
+            At = End;
+        }
+    }
+
+    for (i32 i = 0; i < MAX_MATERIAL_MAPS; ++i)
+    {
+        if (InstanceMaterial.maps[i].texture.id > 0)
+        {
+            rlActiveTextureSlot(i);
+            rlDisableTexture();
+        }
+    }
+
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+    rlDisableShader();
+}
+
+internal void
+DrawGalaxyInstances(Mesh InstanceMesh, Material InstanceMaterial, InstanceShaderLocations Locations,
+                    const GalaxyInstanceBuffer *Buffer, const InstanceUniforms *Uniforms)
+{
+    InstanceRange Everything = {0, Buffer->Count};
+    DrawGalaxyInstanceRanges(InstanceMesh, InstanceMaterial, Locations, Buffer, &Everything, 1, Uniforms);
+}
+
+// Draws the ranges with a GenMeshGalaxyPoint mesh as one pixel per galaxy
+internal void
+DrawGalaxyPoints(Mesh PointMesh, Material InstanceMaterial, InstanceShaderLocations Locations,
+                 const GalaxyInstanceBuffer *Buffer, const InstanceRange *Ranges, u32 RangeCount, const InstanceUniforms *Uniforms)
+{
+    if (RangeCount == 0)
+    {
+        return;
+    }
+
+    // @Note(Victor): Point mode is GL state, flush what raylib has batched up so far so it is not drawn as points
+    rlDrawRenderBatchActive();
+    rlEnablePointMode();
+    rlDisableBackfaceCulling();
+
+    DrawGalaxyInstanceRanges(PointMesh, InstanceMaterial, Locations, Buffer, Ranges, RangeCount, Uniforms);
+
+    rlEnableBackfaceCulling();
+    rlDisablePointMode();
+}
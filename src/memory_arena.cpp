@@ -0,0 +1,230 @@
+// Memory arenas -------------------------------------------------------------------
+// @Note(Victor): The catalogs and the instances built from them are allocated together and freed
+// together, so they come from an arena instead of one calloc each. Pushing is a bump of Used, there is
+// no free of a single allocation. The arena counts its own bytes in CPUMemory and remembers its peak.
+//
+// The memory is a chain of big blocks. ResetArena keeps the blocks and starts over at the first one,
+// so loading a catalog again lands on the pages the last load already faulted in instead of asking
+// the heap (and the kernel) for them once more.
+//
+// With MemoryArenaHugePages the blocks are asked to be backed by transparent huge pages, one TLB entry
+// per 2 MB instead of per 4 KB, for the multi GB catalogs.
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define MEMORY_ARENA_HAS_MMAP 1
+#else
+#define MEMORY_ARENA_HAS_MMAP 0
+#endif
+
+const u64 MEMORY_ARENA_BLOCK_SIZE = Megabytes(16); // Smallest block, only the touched pages cost anything
+const u64 MEMORY_ARENA_HUGE_PAGE_SIZE = Megabytes(2);
+const u64 MEMORY_ARENA_ALIGNMENT = 64; // Every push is cache line aligned, for the SIMD kernels
+
+global_variable bool MemoryArenaHugePages = false;
+
+struct MemoryArenaBlock
+{
+    u8 *Base;
+    u64 Size;
+    u64 Used;
+    u64 Touched; // Bytes handed out since the block was allocated, past that the memory is still zero
+    MemoryArenaBlock *Next;
+};
+
+struct MemoryArena
+{
+    MemoryArenaBlock *First;
+    MemoryArenaBlock *Current;
+
+    u64 Used;     // Pushed since the last reset, what CPUMemory gets
+    u64 Peak;     // Largest Used ever
+    u64 Reserved; // Size of all the blocks
+};
+
+internal MemoryArenaBlock *
+AllocateArenaBlock(u64 MinimumSize)
+{
+    u64 Size = MinimumSize > MEMORY_ARENA_BLOCK_SIZE ? MinimumSize : MEMORY_ARENA_BLOCK_SIZE;
+    Size = (Size + MEMORY_ARENA_HUGE_PAGE_SIZE - 1) & ~(MEMORY_ARENA_HUGE_PAGE_SIZE - 1);
+
+    MemoryArenaBlock *Block = (MemoryArenaBlock *)calloc(1, sizeof(MemoryArenaBlock));
+
+#if MEMORY_ARENA_HAS_MMAP
+    // @Note(Victor): Anonymous pages are zero and only cost memory once they are touched.
+    // One extra huge page so the block can start on a huge page boundary.
+    u64 MappedSize = MemoryArenaHugePages ? Size + MEMORY_ARENA_HUGE_PAGE_SIZE : Size;
+    void *Mapping = mmap(nullptr, MappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (Mapping == MAP_FAILED)
+    {
+        free(Block);
+        return nullptr;
+    }
+
+    u8 *Base = (u8 *)Mapping;
+    if (MemoryArenaHugePages)
+    {
+        u8 *Aligned = (u8 *)(((usize)Base + MEMORY_ARENA_HUGE_PAGE_SIZE - 1) & ~(usize)(MEMORY_ARENA_HUGE_PAGE_SIZE - 1));
+        u64 Before = (u64)(Aligned - Base);
+        if (Before > 0)
+        {
+            munmap(Base, Before);
+        }
+        if (MappedSize - Before > Size)
+        {
+            munmap(Aligned + Size, MappedSize - Before - Size);
+        }
+        Base = Aligned;
+
+#ifdef MADV_HUGEPAGE
+        madvise(Base, Size, MADV_HUGEPAGE);
+#endif
+    }
+
+    Block->Base = Base;
+    Block->Touched = 0;
+#else
+    Block->Base = (u8 *)AlignedAlloc(MEMORY_ARENA_ALIGNMENT, Size);
+    if (Block->Base == nullptr)
+    {
+        free(Block);
+        return nullptr;
+    }
+    Block->Touched = Size; // Not zeroed, every push clears its bytes
+#endif
+
+    Block->Size = Size;
+    return Block;
+}
+
+internal void
+FreeArenaBlock(MemoryArenaBlock *Block)
+{
+#if MEMORY_ARENA_HAS_MMAP
+    munmap(Block->Base, Block->Size);
+#else
+    AlignedFree(Block->Base);
+#endif
+    free(Block);
+}
+
+// @Note(Victor): Size zeroed bytes, like calloc. Only the bytes an earlier push (before a reset) wrote
+// to are cleared, the rest of the block has never been touched.
+internal void *
+PushSize(MemoryArena *Arena, u64 Size)
+{
+    Size = (Size + MEMORY_ARENA_ALIGNMENT - 1) & ~(MEMORY_ARENA_ALIGNMENT - 1);
+
+    // The next block in the chain that fits, from before a reset, or a new one after the current block
+    MemoryArenaBlock *Block = Arena->Current;
+    while (Block && Block->Size - Block->Used < Size)
+    {
+        Block = Block->Next;
+        if (Block)
+        {
+            Block->Used = 0;
+        }
+    }
+
+    if (Block == nullptr)
+    {
+        Block = AllocateArenaBlock(Size);
+        if (Block == nullptr)
+        {
+            return nullptr;
+        }
+        Arena->Reserved += Block->Size;
+
+        if (Arena->Current)
+        {
+            Block->Next = Arena->Current->Next;
+            Arena->Current->Next = Block;
+        }
+        else
+        {
+            Arena->First = Block;
+        }
+    }
+    Arena->Current = Block;
+
+    u8 *Result = Block->Base + Block->Used;
+    if (Block->Touched > Block->Used)
+    {
+        u64 Dirty = Block->Touched - Block->Used;
+        memset(Result, 0, Dirty < Size ? Dirty : Size);
+    }
+
+    Block->Used += Size;
+    Block->Touched = Block->Used > Block->Touched ? Block->Used : Block->Touched;
+
+    Arena->Used += Size;
+    Arena->Peak = Arena->Used > Arena->Peak ? Arena->Used : Arena->Peak;
+    CPUMemory += Size;
+
+    return Result;
+}
+
+#define PushArray(Arena, Type, Count) (Type *)PushSize((Arena), (Count) * sizeof(Type))
+
+// Everything pushed since the mark was taken goes back to the arena
+struct ArenaMark
+{
+    MemoryArenaBlock *Block;
+    u64 BlockUsed;
+    u64 Used;
+};
+
+internal ArenaMark
+GetArenaMark(const MemoryArena *Arena)
+{
+    ArenaMark Result = {};
+    Result.Block = Arena->Current;
+    Result.BlockUsed = Arena->Current ? Arena->Current->Used : 0;
+    Result.Used = Arena->Used;
+
+    return Result;
+}
+
+internal void
+PopArenaToMark(MemoryArena *Arena, ArenaMark Mark)
+{
+    CPUMemory -= Arena->Used - Mark.Used;
+    Arena->Used = Mark.Used;
+
+    if (Mark.Block)
+    {
+        Mark.Block->Used = Mark.BlockUsed;
+        Arena->Current = Mark.Block;
+    }
+    else
+    {
+        Arena->Current = Arena->First;
+        if (Arena->First)
+        {
+            Arena->First->Used = 0;
+        }
+    }
+}
+
+// @Note(Victor): Keeps the blocks for the next load, their pages stay mapped
+internal void
+ResetArena(MemoryArena *Arena)
+{
+    PopArenaToMark(Arena, {});
+}
+
+internal void
+FreeArena(MemoryArena *Arena)
+{
+    CPUMemory -= Arena->Used;
+
+    MemoryArenaBlock *Block = Arena->First;
+    while (Block)
+    {
+        MemoryArenaBlock *Next = Block->Next;
+        FreeArenaBlock(Block);
+        Block = Next;
+    }
+
+    *Arena = {};
+}
@@ -0,0 +1,199 @@
+// Parallel ----------------------------------------------------------------------
+// @Note(Victor): A small persistent worker pool. ParallelFor splits [0, Count) into blocks that the
+// workers and the calling thread pull from a shared counter, so uneven blocks (like the triangular
+// pair loops) balance themselves. Any thread may call ParallelFor, also from inside another job.
+
+typedef void ParallelForCallback(void *UserData, u64 Begin, u64 End, u32 ThreadIndex);
+
+struct ParallelJob
+{
+    ParallelForCallback *Callback = nullptr;
+    void *UserData = nullptr;
+
+    u64 Count = 0;
+    u64 BlockSize = 0;
+    u64 BlockCount = 0;
+
+    std::atomic<u64> NextBlock{0};
+    std::atomic<u64> BlocksDone{0};
+
+    // Guarded by WorkerPool.Mutex, workers that still hold a pointer to this job
+    u32 Users = 0;
+};
+
+struct WorkerPool
+{
+    std::mutex Mutex;
+    std::condition_variable WorkAvailable;
+    std::condition_variable JobFinished;
+
+    ParallelJob *Jobs[64] = {};
+    u32 JobCount = 0;
+
+    u32 WorkerCount = 0; // Not counting the calling thread
+};
+
+// @Note(Victor): 0 means one thread per hardware thread, must be set before the first ParallelFor
+global_variable u32 ThreadCountOverride = 0;
+
+internal u32
+GetThreadCount(void)
+{
+    if (ThreadCountOverride > 0)
+    {
+        return ThreadCountOverride;
+    }
+
+    u32 HardwareThreads = std::thread::hardware_concurrency();
+    return HardwareThreads > 0 ? HardwareThreads : 1;
+}
+
+internal void
+RunJobBlocks(ParallelJob *Job, u32 ThreadIndex)
+{
+    for (;;)
+    {
+        u64 Block = Job->NextBlock.fetch_add(1, std::memory_order_relaxed);
+        if (Block >= Job->BlockCount)
+        {
+            break;
+        }
+
+        u64 Begin = Block * Job->BlockSize;
+        u64 End = Begin + Job->BlockSize;
+        if (End > Job->Count)
+        {
+            End = Job->Count;
+        }
+
+        Job->Callback(Job->UserData, Begin, End, ThreadIndex);
+        Job->BlocksDone.fetch_add(1, std::memory_order_release);
+    }
+}
+
+// @Note(Victor): The pool is never freed on purpose, the workers are detached and live until the process exits
+internal void
+WorkerThreadMain(WorkerPool *Pool, u32 ThreadIndex)
+{
+    for (;;)
+    {
+        ParallelJob *Job = nullptr;
+        {
+            std::unique_lock<std::mutex> Lock(Pool->Mutex);
+            Pool->WorkAvailable.wait(Lock, [&]
+                                     {
+                for (u32 i = 0; i < Pool->JobCount; ++i)
+                {
+                    ParallelJob *Candidate = Pool->Jobs[i];
+                    if (Candidate->NextBlock.load(std::memory_order_relaxed) < Candidate->BlockCount)
+                    {
+                        Job = Candidate;
+                        return true;
+                    }
+                }
+                return false; });
+
+            Job->Users++;
+        }
+
+        RunJobBlocks(Job, ThreadIndex);
+
+        {
+            std::lock_guard<std::mutex> Lock(Pool->Mutex);
+            Job->Users--;
+        }
+        Pool->JobFinished.notify_all();
+    }
+}
+
+internal WorkerPool *
+GetWorkerPool(void)
+{
+    // @Note(Victor): Function local static, so the first ParallelFor from any thread starts the pool exactly once
+    local_persist WorkerPool *Pool = []
+    {
+        WorkerPool *NewPool = new WorkerPool();
+        NewPool->WorkerCount = GetThreadCount() - 1;
+
+        for (u32 i = 0; i < NewPool->WorkerCount; ++i)
+        {
+            // @Note(Victor): The calling thread is always ThreadIndex 0 of its own job
+            std::thread(WorkerThreadMain, NewPool, i + 1).detach();
+        }
+
+        return NewPool;
+    }();
+
+    return Pool;
+}
+
+// @Note(Victor): ThreadIndex is unique within one ParallelFor call and < GetThreadCount(),
+// so it can index per thread scratch memory (private histograms etc.)
+internal void
+ParallelForRaw(u64 Count, u64 BlockSize, ParallelForCallback *Callback, void *UserData)
+{
+    if (Count == 0)
+    {
+        return;
+    }
+
+    if (BlockSize == 0)
+    {
+        BlockSize = 1;
+    }
+
+    ParallelJob Job;
+    Job.Callback = Callback;
+    Job.UserData = UserData;
+    Job.Count = Count;
+    Job.BlockSize = BlockSize;
+    Job.BlockCount = (Count + BlockSize - 1) / BlockSize;
+
+    WorkerPool *Pool = GetWorkerPool();
+    bool IsQueued = false;
+    if (Pool->WorkerCount > 0 && Job.BlockCount > 1)
+    {
+        std::lock_guard<std::mutex> Lock(Pool->Mutex);
+        if (Pool->JobCount < ArrayCount(Pool->Jobs))
+        {
+            Pool->Jobs[Pool->JobCount++] = &Job;
+            IsQueued = true;
+        }
+    }
+
+    if (IsQueued)
+    {
+        Pool->WorkAvailable.notify_all();
+    }
+
+    RunJobBlocks(&Job, 0);
+
+    if (IsQueued)
+    {
+        std::unique_lock<std::mutex> Lock(Pool->Mutex);
+        for (u32 i = 0; i < Pool->JobCount; ++i)
+        {
+            if (Pool->Jobs[i] == &Job)
+            {
+                Pool->Jobs[i] = Pool->Jobs[--Pool->JobCount];
+                break;
+            }
+        }
+
+        Pool->JobFinished.wait(Lock, [&]
+                               { return Job.Users == 0; });
+    }
+
+    Assert(Job.BlocksDone.load(std::memory_order_acquire) == Job.BlockCount);
+}
+
+// Body(u64 Begin, u64 End, u32 ThreadIndex)
+template <typename Function>
+internal void
+ParallelFor(u64 Count, u64 BlockSize, Function &&Body)
+{
+    ParallelForRaw(
+        Count, BlockSize, [](void *UserData, u64 Begin, u64 End, u32 ThreadIndex)
+        { (*(std::remove_reference_t<Function> *)UserData)(Begin, End, ThreadIndex); },
+        (void *)&Body);
+}
@@ -0,0 +1,534 @@
+// Profiler ----------------------------------------------------------------------
+// @Note(Victor): A small frame profiler for the overlay (P) and for Chrome traces (T, or GALAXY_TRACE=file).
+// - CPU scopes: ProfileScope("Name") times the rest of the C++ scope it is in.
+// - GPU passes: BeginGpuPass/EndGpuPass put GL timestamp queries around a pass. The results are read
+//   PROFILER_GPU_FRAMES frames later, so the CPU never waits on the GPU. Without GL 3.3 timer queries
+//   (GLES, web, no libGL to load them from) the passes are just not timed.
+// - Counters: draw calls, instances and uploaded bytes per frame.
+//
+// Every series keeps the last PROFILER_HISTORY frames for the min/avg/p99 of the overlay, and the last
+// PROFILER_MAX_EVENTS events are kept for the trace. Only the main thread profiles.
+
+#include <algorithm>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <dlfcn.h>
+#define PROFILER_HAS_GL_TIMERS 1
+#else
+#define PROFILER_HAS_GL_TIMERS 0
+#endif
+
+const u32 PROFILER_MAX_SERIES = 64;
+const u32 PROFILER_HISTORY = 256;
+const u32 PROFILER_MAX_EVENTS = 65536;
+const u32 PROFILER_GPU_FRAMES = 4; // In flight before a frame's queries are read back
+const u32 PROFILER_MAX_GPU_PASSES = 16;
+
+enum Profile_Counter
+{
+    PROFILE_COUNTER_DRAW_CALLS,
+    PROFILE_COUNTER_INSTANCES,
+    PROFILE_COUNTER_UPLOAD_BYTES,
+
+    PROFILE_COUNTER_COUNT,
+};
+
+global_variable const char *ProfileCounterNames[PROFILE_COUNTER_COUNT] = {"Draw calls", "Instances", "Uploaded bytes"};
+
+enum Profile_Kind
+{
+    PROFILE_CPU,
+    PROFILE_GPU,
+    PROFILE_COUNTER,
+};
+
+struct ProfileSeries
+{
+    const char *Name;
+    Profile_Kind Kind;
+    f64 FrameSeconds; // This frame so far
+    f64 History[PROFILER_HISTORY];
+};
+
+struct ProfileEvent
+{
+    const char *Name;
+    Profile_Kind Kind;
+    f64 Start; // Seconds, GetWallClockSeconds
+    f64 Duration;
+    u64 Value; // Counters
+};
+
+struct GpuPass
+{
+    const char *Name;
+    u32 BeginQuery;
+    u32 EndQuery;
+};
+
+struct ProfileStats
+{
+    f64 Min;
+    f64 Average;
+    f64 P99;
+};
+
+// @Note(Victor): GL entry points that rlgl doesn't wrap, loaded by hand
+typedef void GLGenQueries(i32 Count, u32 *Ids);
+typedef void GLDeleteQueries(i32 Count, const u32 *Ids);
+typedef void GLQueryCounter(u32 Id, u32 Target);
+typedef void GLGetQueryObjectiv(u32 Id, u32 Name, i32 *Value);
+typedef void GLGetQueryObjectui64v(u32 Id, u32 Name, u64 *Value);
+typedef void GLGetInteger64v(u32 Name, i64 *Value);
+
+const u32 GL_TIMESTAMP_QUERY = 0x8E28;
+const u32 GL_QUERY_RESULT_VALUE = 0x8866;
+const u32 GL_QUERY_RESULT_IS_AVAILABLE = 0x8867;
+
+struct Profiler
+{
+    ProfileSeries Series[PROFILER_MAX_SERIES];
+    u32 SeriesCount;
+
+    ProfileSeries Frame;
+    f64 FrameStart;
+    u32 HistoryIndex;
+    u32 HistoryCount;
+
+    u64 Counters[PROFILE_COUNTER_COUNT];
+    f64 CounterHistory[PROFILE_COUNTER_COUNT][PROFILER_HISTORY];
+
+    ProfileEvent Events[PROFILER_MAX_EVENTS]; // Ring
+    u64 EventCount;
+
+    // GPU
+    bool HasGpuTimers;
+    GLGenQueries *GenQueries;
+    GLDeleteQueries *DeleteQueries;
+    GLQueryCounter *QueryCounter;
+    GLGetQueryObjectiv *GetQueryObjectiv;
+    GLGetQueryObjectui64v *GetQueryObjectui64v;
+
+    u32 Queries[PROFILER_GPU_FRAMES][2 * PROFILER_MAX_GPU_PASSES];
+    GpuPass Passes[PROFILER_GPU_FRAMES][PROFILER_MAX_GPU_PASSES];
+    u32 PassCount[PROFILER_GPU_FRAMES];
+    u64 PassFrame[PROFILER_GPU_FRAMES]; // FrameNumber of the frame the passes are from
+    u32 GpuFrame;
+    bool IsInGpuPass;
+
+    // @Note(Victor): The GPU time of a whole frame, all its passes, once they are read back. For the
+    // replay (see camera_replay.cpp), which wants it per frame and not only in the histories.
+    u64 FrameNumber;
+    u64 GpuReadFrame;
+    f64 GpuReadSeconds;
+    bool HasGpuRead; // Set by EndProfileFrame when every pass of GpuReadFrame was available
+
+    // GPU nanoseconds to our seconds, measured once at init
+    i64 GpuClockBase;
+    f64 CpuClockBase;
+};
+
+global_variable Profiler GlobalProfiler = {};
+
+internal ProfileSeries *
+GetProfileSeries(const char *Name, Profile_Kind Kind)
+{
+    Profiler *Profile = &GlobalProfiler;
+    for (u32 i = 0; i < Profile->SeriesCount; ++i)
+    {
+        ProfileSeries *Series = &Profile->Series[i];
+        if (Series->Kind == Kind && (Series->Name == Name || strcmp(Series->Name, Name) == 0))
+        {
+            return Series;
+        }
+    }
+
+    if (Profile->SeriesCount == PROFILER_MAX_SERIES)
+    {
+        return nullptr;
+    }
+
+    ProfileSeries *Series = &Profile->Series[Profile->SeriesCount++];
+    *Series = {};
+    Series->Name = Name;
+    Series->Kind = Kind;
+
+    return Series;
+}
+
+internal void
+AddProfileEvent(const char *Name, Profile_Kind Kind, f64 Start, f64 Duration, u64 Value)
+{
+    Profiler *Profile = &GlobalProfiler;
+    ProfileEvent *Event = &Profile->Events[Profile->EventCount++ % PROFILER_MAX_EVENTS];
+    Event->Name = Name;
+    Event->Kind = Kind;
+    Event->Start = Start;
+    Event->Duration = Duration;
+    Event->Value = Value;
+}
+
+// For the scopes that don't line up with a C++ scope, Start is from GetWallClockSeconds
+internal void
+EndProfileScope(const char *Name, f64 Start)
+{
+    f64 Duration = GetWallClockSeconds() - Start;
+    ProfileSeries *Series = GetProfileSeries(Name, PROFILE_CPU);
+    if (Series)
+    {
+        Series->FrameSeconds += Duration;
+    }
+
+    AddProfileEvent(Name, PROFILE_CPU, Start, Duration, 0);
+}
+
+struct ProfileScopeTimer
+{
+    const char *Name;
+    f64 Start;
+
+    ProfileScopeTimer(const char *ScopeName)
+    {
+        Name = ScopeName;
+        Start = GetWallClockSeconds();
+    }
+
+    ~ProfileScopeTimer()
+    {
+        EndProfileScope(Name, Start);
+    }
+};
+
+#define PROFILE_CONCAT_(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_(A, B)
+
+// Name has to outlive the profiler, a string literal
+#define ProfileScope(Name) ProfileScopeTimer PROFILE_CONCAT(ProfileScope_, __LINE__)(Name)
+
+internal void
+ProfileCount(Profile_Counter Counter, u64 Value)
+{
+    GlobalProfiler.Counters[Counter] += Value;
+}
+
+#if PROFILER_HAS_GL_TIMERS
+internal void *
+GetGLProcedure(const char *Name)
+{
+#if defined(__APPLE__)
+    local_persist void *Library = dlopen("/System/Library/Frameworks/OpenGL.framework/OpenGL", RTLD_LAZY | RTLD_LOCAL);
+#else
+    local_persist void *Library = dlopen("libGL.so.1", RTLD_LAZY | RTLD_LOCAL);
+#endif
+
+    return Library ? dlsym(Library, Name) : nullptr;
+}
+#endif
+
+// @Note(Victor): After InitWindow, needs the GL context
+internal void
+InitProfilerGpuTimers(void)
+{
+    Profiler *Profile = &GlobalProfiler;
+    Profile->HasGpuTimers = false;
+
+#if PROFILER_HAS_GL_TIMERS
+    i32 Version = rlGetVersion();
+    if (Version != RL_OPENGL_33 && Version != RL_OPENGL_43)
+    {
+        printf("\tNo GPU timers, they need OpenGL 3.3\n");
+        return;
+    }
+
+    Profile->GenQueries = (GLGenQueries *)GetGLProcedure("glGenQueries");
+    Profile->DeleteQueries = (GLDeleteQueries *)GetGLProcedure("glDeleteQueries");
+    Profile->QueryCounter = (GLQueryCounter *)GetGLProcedure("glQueryCounter");
+    Profile->GetQueryObjectiv = (GLGetQueryObjectiv *)GetGLProcedure("glGetQueryObjectiv");
+    Profile->GetQueryObjectui64v = (GLGetQueryObjectui64v *)GetGLProcedure("glGetQueryObjectui64v");
+    GLGetInteger64v *GetInteger64v = (GLGetInteger64v *)GetGLProcedure("glGetInteger64v");
+
+    if (!Profile->GenQueries || !Profile->DeleteQueries || !Profile->QueryCounter ||
+        !Profile->GetQueryObjectiv || !Profile->GetQueryObjectui64v || !GetInteger64v)
+    {
+        printf("\tNo GPU timers, could not load the GL query functions\n");
+        return;
+    }
+
+    Profile->GenQueries(PROFILER_GPU_FRAMES * 2 * PROFILER_MAX_GPU_PASSES, &Profile->Queries[0][0]);
+
+    GetInteger64v(GL_TIMESTAMP_QUERY, &Profile->GpuClockBase);
+    Profile->CpuClockBase = GetWallClockSeconds();
+
+    Profile->HasGpuTimers = true;
+#endif
+}
+
+internal void
+FreeProfilerGpuTimers(void)
+{
+    Profiler *Profile = &GlobalProfiler;
+    if (Profile->HasGpuTimers)
+    {
+        Profile->DeleteQueries(PROFILER_GPU_FRAMES * 2 * PROFILER_MAX_GPU_PASSES, &Profile->Queries[0][0]);
+        Profile->HasGpuTimers = false;
+    }
+}
+
+// @Note(Victor): Passes don't nest. Raylib batches its own draws, so the batch is flushed on both ends
+// to count what was drawn in the pass to it, and only that.
+internal void
+BeginGpuPass(const char *Name)
+{
+    Profiler *Profile = &GlobalProfiler;
+    u32 Frame = Profile->GpuFrame;
+    if (!Profile->HasGpuTimers || Profile->PassCount[Frame] == PROFILER_MAX_GPU_PASSES)
+    {
+        return;
+    }
+
+    Assert(!Profile->IsInGpuPass);
+    Profile->IsInGpuPass = true;
+
+    rlDrawRenderBatchActive();
+
+    u32 Pass = Profile->PassCount[Frame];
+    GpuPass *Result = &Profile->Passes[Frame][Pass];
+    Result->Name = Name;
+    Result->BeginQuery = Profile->Queries[Frame][2 * Pass];
+    Result->EndQuery = Profile->Queries[Frame][2 * Pass + 1];
+
+    Profile->QueryCounter(Result->BeginQuery, GL_TIMESTAMP_QUERY);
+}
+
+internal void
+EndGpuPass(void)
+{
+    Profiler *Profile = &GlobalProfiler;
+    if (!Profile->IsInGpuPass)
+    {
+        return;
+    }
+
+    rlDrawRenderBatchActive();
+
+    u32 Frame = Profile->GpuFrame;
+    Profile->QueryCounter(Profile->Passes[Frame][Profile->PassCount[Frame]].EndQuery, GL_TIMESTAMP_QUERY);
+    Profile->PassCount[Frame]++;
+    Profile->IsInGpuPass = false;
+}
+
+// Reads the passes of the oldest frame in flight, whatever is not done yet is dropped
+internal void
+ReadGpuPasses(u32 Frame)
+{
+    Profiler *Profile = &GlobalProfiler;
+    Profile->GpuReadFrame = Profile->PassFrame[Frame];
+    Profile->GpuReadSeconds = 0.0;
+    Profile->HasGpuRead = Profile->PassCount[Frame] > 0;
+
+    for (u32 Pass = 0; Pass < Profile->PassCount[Frame]; ++Pass)
+    {
+        GpuPass *Timed = &Profile->Passes[Frame][Pass];
+
+        i32 IsAvailable = 0;
+        Profile->GetQueryObjectiv(Timed->EndQuery, GL_QUERY_RESULT_IS_AVAILABLE, &IsAvailable);
+        if (!IsAvailable)
+        {
+            Profile->HasGpuRead = false;
+            continue;
+        }
+
+        u64 Begin = 0;
+        u64 End = 0;
+        Profile->GetQueryObjectui64v(Timed->BeginQuery, GL_QUERY_RESULT_VALUE, &Begin);
+        Profile->GetQueryObjectui64v(Timed->EndQuery, GL_QUERY_RESULT_VALUE, &End);
+
+        f64 Duration = End > Begin ? (f64)(End - Begin) * 1e-9 : 0.0;
+        f64 Start = Profile->CpuClockBase + (f64)((i64)Begin - Profile->GpuClockBase) * 1e-9;
+
+        ProfileSeries *Series = GetProfileSeries(Timed->Name, PROFILE_GPU);
+        if (Series)
+        {
+            Series->FrameSeconds += Duration;
+        }
+        AddProfileEvent(Timed->Name, PROFILE_GPU, Start, Duration, 0);
+        Profile->GpuReadSeconds += Duration;
+    }
+
+    Profile->PassCount[Frame] = 0;
+}
+
+internal void
+BeginProfileFrame(void)
+{
+    GlobalProfiler.FrameStart = GetWallClockSeconds();
+}
+
+// @Note(Victor): After EndDrawing, pushes this frame into the histories
+internal void
+EndProfileFrame(void)
+{
+    Profiler *Profile = &GlobalProfiler;
+    f64 Now = GetWallClockSeconds();
+
+    if (Profile->HasGpuTimers)
+    {
+        Profile->PassFrame[Profile->GpuFrame] = Profile->FrameNumber;
+        Profile->GpuFrame = (Profile->GpuFrame + 1) % PROFILER_GPU_FRAMES;
+        ReadGpuPasses(Profile->GpuFrame);
+    }
+    Profile->FrameNumber++;
+
+    u32 Index = Profile->HistoryIndex;
+
+    Profile->Frame.Name = "Frame";
+    Profile->Frame.History[Index] = Now - Profile->FrameStart;
+    AddProfileEvent("Frame", PROFILE_CPU, Profile->FrameStart, Now - Profile->FrameStart, 0);
+
+    for (u32 i = 0; i < Profile->SeriesCount; ++i)
+    {
+        ProfileSeries *Series = &Profile->Series[i];
+        Series->History[Index] = Series->FrameSeconds;
+        Series->FrameSeconds = 0.0;
+    }
+
+    for (u32 Counter = 0; Counter < PROFILE_COUNTER_COUNT; ++Counter)
+    {
+        Profile->CounterHistory[Counter][Index] = (f64)Profile->Counters[Counter];
+        AddProfileEvent(ProfileCounterNames[Counter], PROFILE_COUNTER, Now, 0.0, Profile->Counters[Counter]);
+        Profile->Counters[Counter] = 0;
+    }
+
+    Profile->HistoryIndex = (Index + 1) % PROFILER_HISTORY;
+    Profile->HistoryCount = Profile->HistoryCount < PROFILER_HISTORY ? Profile->HistoryCount + 1 : PROFILER_HISTORY;
+}
+
+// What a series (or the frame, Name "Frame") took in the frame EndProfileFrame just pushed
+internal f64
+GetLastProfileSeconds(const char *Name, Profile_Kind Kind)
+{
+    Profiler *Profile = &GlobalProfiler;
+    u32 Last = (Profile->HistoryIndex + PROFILER_HISTORY - 1) % PROFILER_HISTORY;
+    if (Kind == PROFILE_CPU && strcmp(Name, "Frame") == 0)
+    {
+        return Profile->Frame.History[Last];
+    }
+
+    for (u32 i = 0; i < Profile->SeriesCount; ++i)
+    {
+        ProfileSeries *Series = &Profile->Series[i];
+        if (Series->Kind == Kind && (Series->Name == Name || strcmp(Series->Name, Name) == 0))
+        {
+            return Series->History[Last];
+        }
+    }
+
+    return 0.0;
+}
+
+internal ProfileStats
+GetProfileStats(const f64 *History)
+{
+    ProfileStats Result = {};
+    u32 Count = GlobalProfiler.HistoryCount;
+    if (Count == 0)
+    {
+        return Result;
+    }
+
+    f64 Sorted[PROFILER_HISTORY];
+    f64 Sum = 0.0;
+    for (u32 i = 0; i < Count; ++i)
+    {
+        Sorted[i] = History[i];
+        Sum += History[i];
+    }
+    std::sort(Sorted, Sorted + Count);
+
+    u32 Rank = (u32)ceil(0.99 * Count);
+    Result.Min = Sorted[0];
+    Result.Average = Sum / Count;
+    Result.P99 = Sorted[Rank > 0 ? Rank - 1 : 0];
+
+    return Result;
+}
+
+internal void
+DrawProfilerOverlay(Font OverlayFont, Vector2 Position)
+{
+    Profiler *Profile = &GlobalProfiler;
+    const f32 FontSize = 14.0f;
+    const f32 LineHeight = 16.0f;
+
+    u32 LineCount = 3 + Profile->SeriesCount + PROFILE_COUNTER_COUNT;
+    DrawRectangle((i32)Position.x - 6, (i32)Position.y - 6, 430, (i32)(LineCount * LineHeight) + 12, Fade(BLACK, 0.7f));
+
+    DrawTextEx(OverlayFont, TextFormat("Profiler (P), last %u frames, T: trace", Profile->HistoryCount), Position, FontSize, 1, WHITE);
+    Position.y += LineHeight;
+
+    DrawTextEx(OverlayFont, "ms            min      avg      p99", Position, FontSize, 1, GRAY);
+    Position.y += LineHeight;
+
+    ProfileStats Frame = GetProfileStats(Profile->Frame.History);
+    DrawTextEx(OverlayFont, TextFormat("Frame         %6.2f   %6.2f   %6.2f", Frame.Min * 1000.0, Frame.Average * 1000.0, Frame.P99 * 1000.0), Position, FontSize, 1, WHITE);
+    Position.y += LineHeight;
+
+    for (u32 i = 0; i < Profile->SeriesCount; ++i)
+    {
+        ProfileSeries *Series = &Profile->Series[i];
+        ProfileStats Stats = GetProfileStats(Series->History);
+        DrawTextEx(OverlayFont, TextFormat("%s %-22s %6.2f   %6.2f   %6.2f", Series->Kind == PROFILE_GPU ? "GPU" : "CPU", Series->Name, Stats.Min * 1000.0, Stats.Average * 1000.0, Stats.P99 * 1000.0),
+                   Position, FontSize, 1, Series->Kind == PROFILE_GPU ? SKYBLUE : YELLOW);
+        Position.y += LineHeight;
+    }
+
+    for (u32 Counter = 0; Counter < PROFILE_COUNTER_COUNT; ++Counter)
+    {
+        ProfileStats Stats = GetProfileStats(Profile->CounterHistory[Counter]);
+        DrawTextEx(OverlayFont, TextFormat("%-26s %8.0f %8.0f %8.0f", ProfileCounterNames[Counter], Stats.Min, Stats.Average, Stats.P99), Position, FontSize, 1, GREEN);
+        Position.y += LineHeight;
+    }
+}
+
+// @Note(Victor): chrome://tracing or https://ui.perfetto.dev, CPU scopes on one track, GPU passes on another
+internal bool
+WriteChromeTrace(const char *FileName)
+{
+    Profiler *Profile = &GlobalProfiler;
+    FILE *f = fopen(FileName, "w");
+    if (f == NULL)
+    {
+        printf("\tCould not write the trace to %s\n", FileName);
+        return (false);
+    }
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(f, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": {\"name\": \"CPU\"}},\n");
+    fprintf(f, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": {\"name\": \"GPU\"}}");
+
+    u64 First = Profile->EventCount > PROFILER_MAX_EVENTS ? Profile->EventCount - PROFILER_MAX_EVENTS : 0;
+    f64 Origin = Profile->EventCount > 0 ? Profile->Events[First % PROFILER_MAX_EVENTS].Start : 0.0;
+    for (u64 i = First; i < Profile->EventCount; ++i)
+    {
+        const ProfileEvent *Event = &Profile->Events[i % PROFILER_MAX_EVENTS];
+        f64 Start = (Event->Start - Origin) * 1e6;
+
+        if (Event->Kind == PROFILE_COUNTER)
+        {
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 1, \"args\": {\"value\": %lu}}",
+                    Event->Name, Start, (unsigned long)Event->Value);
+        }
+        else
+        {
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+                    Event->Name, Start, Event->Duration * 1e6, Event->Kind == PROFILE_GPU ? 2 : 1);
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    bool Success = fclose(f) == 0;
+
+    printf("\tWrote %lu profiler events to %s\n", (unsigned long)(Profile->EventCount - First), FileName);
+
+    return (Success);
+}
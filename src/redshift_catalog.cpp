@@ -0,0 +1,355 @@
+// Redshift catalogs -----------------------------------------------------------------
+// @Note(Victor): The Huchra catalogs (seyfert.dat here, ZCAT and friends) are fixed width Fortran style
+// listings, so the fields are read by column instead of split on blanks. Blank means left out: the
+// catalogs drop leading zeros and often the seconds ("1433  " is 14d 33' 00"), and a lot of rows have
+// no velocity at all. Those rows can't be placed and are skipped.
+//
+//   NAME      RA (1950)  DEC    MB    VH
+//   MK334      000035.6  214054 14.40  6605 ...
+//
+// RA is HHMMSS.s, DEC is a sign and DDMMSS, VH the heliocentric velocity cz in km/s. They go into the
+// catalog as the numbers HHMMSS.s, +-DDMMSS and cz, the instance builder turns them into positions.
+//
+// The rows come after the first "---" line and end at the next one (the notes follow it). Same as
+// the arcmin catalogs the file is mapped and parsed in newline aligned chunks on every thread: one pass
+// only looks for newlines to find where the rows of each chunk go, the second one parses every row once.
+
+// Columns of seyfert.dat, 0 based. The documented Fortran format at the end of the file is off by a couple.
+const u32 REDSHIFT_RA_HOURS_COLUMN = 11;    // HH MM SS.s
+const u32 REDSHIFT_DEC_SIGN_COLUMN = 20;    // ' ', '+' or '-'
+const u32 REDSHIFT_DEC_DEGREES_COLUMN = 21; // DD MM SS
+const u32 REDSHIFT_VELOCITY_COLUMN = 33;    // Right aligned, up to 6 characters
+const u32 REDSHIFT_VELOCITY_WIDTH = 6;
+
+const u32 REDSHIFT_MAX_HEADER_LINES = 64; // No "---" line before this, the whole file is rows
+
+// Hubble's law, good enough at these redshifts: distance = cz / H0
+const f64 HUBBLE_CONSTANT = 70.0; // km/s/Mpc
+
+internal bool
+IsRedshiftSeparator(const char *Begin, const char *End)
+{
+    return End - Begin >= 3 && Begin[0] == '-' && Begin[1] == '-' && Begin[2] == '-';
+}
+
+// @Note(Victor): The number in Line[Column, Column + Width), past the end of the line is blank. Blanks are
+// skipped, '-' makes it negative and '.' starts the fraction. False on anything else, IsBlank when there
+// are no digits at all.
+internal bool
+ParseFixedWidthNumber(const char *Line, u64 LineLength, u64 Column, u64 Width, f64 *Value, bool *IsBlank)
+{
+    u64 Integer = 0;
+    u64 Fraction = 0;
+    u64 FractionScale = 1;
+    bool IsNegative = false;
+    bool IsFraction = false;
+    bool HasDigits = false;
+
+    u64 End = Column + Width < LineLength ? Column + Width : LineLength;
+    for (u64 i = Column; i < End; ++i)
+    {
+        char Character = Line[i];
+        if (Character >= '0' && Character <= '9')
+        {
+            if (IsFraction)
+            {
+                Fraction = Fraction * 10 + (Character - '0');
+                FractionScale *= 10;
+            }
+            else
+            {
+                Integer = Integer * 10 + (Character - '0');
+            }
+            HasDigits = true;
+        }
+        else if (Character == '.' && !IsFraction)
+        {
+            IsFraction = true;
+        }
+        else if (Character == '-' && !HasDigits && !IsNegative)
+        {
+            IsNegative = true;
+        }
+        else if (Character != ' ' && Character != '\t' && Character != '\r')
+        {
+            return (false);
+        }
+    }
+
+    f64 Result = (f64)Integer + (f64)Fraction / (f64)FractionScale;
+    *Value = IsNegative ? -Result : Result;
+    *IsBlank = !HasDigits;
+
+    return (true);
+}
+
+enum Redshift_Row
+{
+    REDSHIFT_ROW_OK,
+    REDSHIFT_ROW_NO_VELOCITY,
+    REDSHIFT_ROW_MALFORMED,
+};
+
+internal Redshift_Row
+ParseRedshiftRow(const char *Line, u64 LineLength, f64 *RightAscension, f64 *Declination, f64 *Velocity)
+{
+    f64 Hours, RaMinutes, RaSeconds;
+    bool HoursBlank, RaMinutesBlank, RaSecondsBlank;
+    if (!ParseFixedWidthNumber(Line, LineLength, REDSHIFT_RA_HOURS_COLUMN, 2, &Hours, &HoursBlank) ||
+        !ParseFixedWidthNumber(Line, LineLength, REDSHIFT_RA_HOURS_COLUMN + 2, 2, &RaMinutes, &RaMinutesBlank) ||
+        !ParseFixedWidthNumber(Line, LineLength, REDSHIFT_RA_HOURS_COLUMN + 4, 4, &RaSeconds, &RaSecondsBlank) ||
+        HoursBlank)
+    {
+        return REDSHIFT_ROW_MALFORMED;
+    }
+
+    // @Note(Victor): A couple of rows have their DEC one column to the left, over the sign. They are north.
+    u64 DecColumn = REDSHIFT_DEC_DEGREES_COLUMN;
+    char Sign = LineLength > REDSHIFT_DEC_SIGN_COLUMN ? Line[REDSHIFT_DEC_SIGN_COLUMN] : ' ';
+    if (Sign >= '0' && Sign <= '9')
+    {
+        DecColumn = REDSHIFT_DEC_SIGN_COLUMN;
+        Sign = '+';
+    }
+    else if (Sign != ' ' && Sign != '+' && Sign != '-')
+    {
+        return REDSHIFT_ROW_MALFORMED;
+    }
+
+    f64 Degrees, DecMinutes, DecSeconds;
+    bool DegreesBlank, DecMinutesBlank, DecSecondsBlank;
+    if (!ParseFixedWidthNumber(Line, LineLength, DecColumn, 2, &Degrees, &DegreesBlank) ||
+        !ParseFixedWidthNumber(Line, LineLength, DecColumn + 2, 2, &DecMinutes, &DecMinutesBlank) ||
+        !ParseFixedWidthNumber(Line, LineLength, DecColumn + 4, 2, &DecSeconds, &DecSecondsBlank) ||
+        (DegreesBlank && DecMinutesBlank))
+    {
+        return REDSHIFT_ROW_MALFORMED;
+    }
+
+    bool VelocityBlank;
+    if (!ParseFixedWidthNumber(Line, LineLength, REDSHIFT_VELOCITY_COLUMN, REDSHIFT_VELOCITY_WIDTH, Velocity, &VelocityBlank))
+    {
+        return REDSHIFT_ROW_MALFORMED;
+    }
+
+    *RightAscension = Hours * 10000.0 + RaMinutes * 100.0 + RaSeconds;
+
+    f64 Dec = Degrees * 10000.0 + DecMinutes * 100.0 + DecSeconds;
+    *Declination = Sign == '-' ? -Dec : Dec;
+
+    return VelocityBlank ? REDSHIFT_ROW_NO_VELOCITY : REDSHIFT_ROW_OK;
+}
+
+// Where the rows start, right after the "---" line under the column names
+internal const char *
+FindRedshiftRows(const char *Begin, const char *End)
+{
+    const char *At = Begin;
+    for (u32 Line = 0; Line < REDSHIFT_MAX_HEADER_LINES && At < End; ++Line)
+    {
+        const char *LineEnd = (const char *)memchr(At, '\n', End - At);
+        LineEnd = LineEnd ? LineEnd : End;
+
+        if (IsRedshiftSeparator(At, LineEnd))
+        {
+            return LineEnd < End ? LineEnd + 1 : End;
+        }
+
+        At = LineEnd + 1;
+    }
+
+    return Begin;
+}
+
+// @Note(Victor): The non blank lines of a chunk, up to the "---" line that ends the rows if it is in there
+internal u64
+CountRedshiftLines(const char *Begin, const char *End, bool *HasSeparator)
+{
+    u64 LineCount = 0;
+    *HasSeparator = false;
+
+    while (Begin < End)
+    {
+        const char *LineEnd = (const char *)memchr(Begin, '\n', End - Begin);
+        LineEnd = LineEnd ? LineEnd : End;
+
+        if (IsRedshiftSeparator(Begin, LineEnd))
+        {
+            *HasSeparator = true;
+            break;
+        }
+
+        LineCount += IsBlankLine(Begin, LineEnd) ? 0 : 1;
+        Begin = LineEnd + 1;
+    }
+
+    return LineCount;
+}
+
+struct RedshiftChunks
+{
+    MappedFile File;
+
+    u64 ChunkCount; // Only the chunks with rows, the notes after the closing "---" are left out
+    const char **ChunkBegin;
+    u64 *ChunkFirstLine; // ChunkCount + 1, the last one is the number of lines
+};
+
+internal void
+FreeRedshiftChunks(RedshiftChunks *Chunks)
+{
+    free(Chunks->ChunkBegin);
+    free(Chunks->ChunkFirstLine);
+    UnmapFile(&Chunks->File);
+    *Chunks = {};
+}
+
+// Maps FileName and finds where the lines of every chunk go, without parsing them
+internal bool
+MapRedshiftChunks(const char *FileName, RedshiftChunks *Result)
+{
+    *Result = {};
+    if (!MapFile(FileName, &Result->File))
+    {
+        return (false);
+    }
+
+    const char *FileEnd = Result->File.Data + Result->File.Size;
+    const char *RowsBegin = FindRedshiftRows(Result->File.Data, FileEnd);
+
+    u64 ChunkCount = 0;
+    Result->ChunkBegin = SplitIntoLineChunks(RowsBegin, FileEnd, &ChunkCount);
+    Result->ChunkFirstLine = (u64 *)calloc(ChunkCount + 1, sizeof(u64));
+
+    bool *HasSeparator = (bool *)calloc(ChunkCount, sizeof(bool));
+    ParallelFor(ChunkCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Chunk = Begin; Chunk < End; ++Chunk)
+        {
+            Result->ChunkFirstLine[Chunk + 1] = CountRedshiftLines(Result->ChunkBegin[Chunk], Result->ChunkBegin[Chunk + 1], &HasSeparator[Chunk]);
+        } });
+
+    Result->ChunkCount = ChunkCount;
+    for (u64 Chunk = 0; Chunk < ChunkCount; ++Chunk)
+    {
+        Result->ChunkFirstLine[Chunk + 1] += Result->ChunkFirstLine[Chunk];
+        if (HasSeparator[Chunk])
+        {
+            Result->ChunkCount = Chunk + 1;
+            break;
+        }
+    }
+
+    free(HasSeparator);
+    return (true);
+}
+
+// @Note(Victor): Every row, so a few more than the galaxies with a velocity that end up in the catalog
+internal bool
+CountRedshiftDataPoints(const char *FileName, u64 *Count)
+{
+    RedshiftChunks Chunks;
+    if (!MapRedshiftChunks(FileName, &Chunks))
+    {
+        return (false);
+    }
+
+    *Count = Chunks.ChunkFirstLine[Chunks.ChunkCount];
+    FreeRedshiftChunks(&Chunks);
+
+    return (true);
+}
+
+// Reads a Huchra redshift catalog into the (allocated) columns of Result, up to its capacity
+internal bool
+ReadInputDataFromRedshiftFile(const char *FileName, Catalog *Result)
+{
+    Result->Count = 0;
+
+    RedshiftChunks Chunks;
+    if (!MapRedshiftChunks(FileName, &Chunks))
+    {
+        printf("Error opening redshift file: %s\n", FileName);
+        return (false);
+    }
+
+    u64 LineCount = Chunks.ChunkFirstLine[Chunks.ChunkCount];
+    if (LineCount > Result->Capacity)
+    {
+        printf("Error: %s has %lu rows, there is only room for %lu\n", FileName,
+               (unsigned long)LineCount, (unsigned long)Result->Capacity);
+        FreeRedshiftChunks(&Chunks);
+        return (false);
+    }
+
+    // @Note(Victor): Every chunk writes its galaxies from the first line it has, the rows without a
+    // velocity leave a gap at the end of the chunk that is closed afterwards
+    u64 *ChunkGalaxyCount = (u64 *)calloc(Chunks.ChunkCount, sizeof(u64));
+    std::atomic<u64> MalformedCount{0};
+
+    ParallelFor(Chunks.ChunkCount, 1, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Chunk = Begin; Chunk < End; ++Chunk)
+        {
+            const char *At = Chunks.ChunkBegin[Chunk];
+            const char *ChunkEnd = Chunks.ChunkBegin[Chunk + 1];
+            u64 First = Chunks.ChunkFirstLine[Chunk];
+            u64 Galaxy = First;
+            u64 Malformed = 0;
+
+            while (At < ChunkEnd)
+            {
+                const char *LineEnd = (const char *)memchr(At, '\n', ChunkEnd - At);
+                LineEnd = LineEnd ? LineEnd : ChunkEnd;
+
+                if (IsRedshiftSeparator(At, LineEnd))
+                {
+                    break;
+                }
+
+                if (!IsBlankLine(At, LineEnd))
+                {
+                    Redshift_Row Row = ParseRedshiftRow(At, LineEnd - At, &Result->RightAscension[Galaxy],
+                                                        &Result->Declination[Galaxy], &Result->Redshift[Galaxy]);
+                    Galaxy += Row == REDSHIFT_ROW_OK ? 1 : 0;
+                    Malformed += Row == REDSHIFT_ROW_MALFORMED ? 1 : 0;
+                }
+
+                At = LineEnd + 1;
+            }
+
+            ChunkGalaxyCount[Chunk] = Galaxy - First;
+            MalformedCount += Malformed;
+        } });
+
+    u64 GalaxyCount = 0;
+    for (u64 Chunk = 0; Chunk < Chunks.ChunkCount; ++Chunk)
+    {
+        u64 First = Chunks.ChunkFirstLine[Chunk];
+        u64 Count = ChunkGalaxyCount[Chunk];
+        if (First != GalaxyCount)
+        {
+            memmove(&Result->RightAscension[GalaxyCount], &Result->RightAscension[First], Count * sizeof(f64));
+            memmove(&Result->Declination[GalaxyCount], &Result->Declination[First], Count * sizeof(f64));
+            memmove(&Result->Redshift[GalaxyCount], &Result->Redshift[First], Count * sizeof(f64));
+        }
+
+        GalaxyCount += Count;
+    }
+
+    free(ChunkGalaxyCount);
+
+    Result->Count = GalaxyCount;
+    Result->SourceSize = Chunks.File.Size;
+    FreeRedshiftChunks(&Chunks);
+
+    printf("\tRead %lu redshift data points from %s, %lu rows without a velocity", (unsigned long)GalaxyCount, FileName,
+           (unsigned long)(LineCount - GalaxyCount - MalformedCount.load()));
+    if (MalformedCount.load() > 0)
+    {
+        printf(", %lu rows we could not read", (unsigned long)MalformedCount.load());
+    }
+    printf("\n");
+
+    return (true);
+}
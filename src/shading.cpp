@@ -0,0 +1,125 @@
+// Shading tiers -----------------------------------------------------------------
+// @Note(Victor): Every fragment of every tiny galaxy sphere ran the full lighting of lighting.fs: up to
+// MAX_LIGHTS lights with a pow specular, two texture fetches and a pow for the gamma. With millions of
+// galaxies on screen most of that is not visible, so the galaxy shaders come in tiers:
+// - SHADING_PHONG, the full lighting as before.
+// - SHADING_LAMBERT, one texture and one lighting term: the lights are summed on the CPU into the lightSum
+//   uniform (see GetLightSum), one matrix * normal and one dot per fragment whatever the number of lights.
+// - SHADING_UNLIT, the color of the catalog and nothing else, for the huge catalogs.
+//
+// The fragment shaders are the same files for all the tiers, LoadTieredShader puts a #define SHADING_TIER
+// after their #version line. Every tier draws in its own GPU pass (ShadingTierPasses), so the P overlay
+// and the Chrome trace show what each one costs on the card at hand.
+
+enum Shading_Tier
+{
+    SHADING_PHONG,
+    SHADING_LAMBERT,
+    SHADING_UNLIT,
+
+    SHADING_TIER_COUNT,
+};
+
+global_variable const char *ShadingTierNames[SHADING_TIER_COUNT] = {"phong", "lambert", "unlit"};
+global_variable const char *ShadingTierPasses[SHADING_TIER_COUNT] = {"Galaxies phong", "Galaxies lambert", "Galaxies unlit"};
+
+internal bool
+ParseShadingTier(const char *Name, Shading_Tier *Result)
+{
+    for (u32 Tier = 0; Tier < SHADING_TIER_COUNT; ++Tier)
+    {
+        if (strcmp(Name, ShadingTierNames[Tier]) == 0)
+        {
+            *Result = (Shading_Tier)Tier;
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+// Loads the vertex shader as is and the fragment shader compiled for Tier
+internal Shader
+LoadTieredShader(const char *VertexFileName, const char *FragmentFileName, Shading_Tier Tier)
+{
+    char *VertexCode = LoadFileText(VertexFileName);
+    char *FragmentCode = LoadFileText(FragmentFileName);
+    if (VertexCode == nullptr || FragmentCode == nullptr)
+    {
+        printf("\tCould not read the shaders %s and %s\n", VertexFileName, FragmentFileName);
+        UnloadFileText(VertexCode);
+        UnloadFileText(FragmentCode);
+
+        // raylib's default shader, so the galaxies still show up
+        return LoadShader(nullptr, nullptr);
+    }
+
+    // @Note(Victor): GLSL wants #version first, the define goes on the line after it
+    const char *Body = strchr(FragmentCode, '\n');
+    Body = Body ? Body + 1 : FragmentCode + strlen(FragmentCode);
+    i32 VersionLength = (i32)(Body - FragmentCode);
+
+    const char *Define = TextFormat("#define SHADING_TIER %u\n", (u32)Tier);
+    usize TieredSize = VersionLength + strlen(Define) + strlen(Body) + 1;
+    char *TieredCode = (char *)malloc(TieredSize);
+    snprintf(TieredCode, TieredSize, "%.*s%s%s", VersionLength, FragmentCode, Define, Body);
+
+    Shader Result = LoadShaderFromMemory(VertexCode, TieredCode);
+
+    free(TieredCode);
+    UnloadFileText(VertexCode);
+    UnloadFileText(FragmentCode);
+
+    return Result;
+}
+
+// @Note(Victor): The lights of lighting.fs as one matrix for SHADING_LAMBERT, the light on a normal n is
+// dot(v, lightSum * v) with v = vec4(n, 1). Each light's clamped cosine max(x, 0), x = dot(n, l), is taken
+// up to its second Legendre term, 3/32 + x/2 + 15/32 x^2, which is a quadratic form in v, and the forms of
+// all the lights just add up. Only a linear term would not do: our lights come in opposite pairs that
+// cancel out in it, the x^2 keeps them.
+// One matrix is one brightness, so a light's color goes in as the mean of its channels (ours are white).
+// A point light has no single direction, it goes in as its mean over the sphere, 1/4.
+internal Matrix
+GetLightSum(const Light *Lights, i32 LightCount)
+{
+    f32 Form[4][4] = {};
+    for (i32 i = 0; i < LightCount; ++i)
+    {
+        const Light *Source = &Lights[i];
+        if (!Source->enabled)
+        {
+            continue;
+        }
+
+        f32 Brightness = (Source->color.r + Source->color.g + Source->color.b) / (3.0f * 255.0f);
+        if (Source->type != LIGHT_DIRECTIONAL)
+        {
+            Form[3][3] += Brightness * 0.25f;
+            continue;
+        }
+
+        Vector3 Direction = Vector3Normalize(Vector3Subtract(Source->position, Source->target));
+        f32 L[3] = {Direction.x, Direction.y, Direction.z};
+        for (u32 Row = 0; Row < 3; ++Row)
+        {
+            for (u32 Column = 0; Column < 3; ++Column)
+            {
+                Form[Row][Column] += Brightness * (15.0f / 32.0f) * L[Row] * L[Column];
+            }
+
+            // x/2 split over the two symmetric entries
+            Form[Row][3] += Brightness * 0.25f * L[Row];
+            Form[3][Row] += Brightness * 0.25f * L[Row];
+        }
+        Form[3][3] += Brightness * (3.0f / 32.0f);
+    }
+
+    // The form is symmetric, so the row/column order of raylib's Matrix doesn't matter
+    Matrix Result = {Form[0][0], Form[0][1], Form[0][2], Form[0][3],
+                     Form[1][0], Form[1][1], Form[1][2], Form[1][3],
+                     Form[2][0], Form[2][1], Form[2][2], Form[2][3],
+                     Form[3][0], Form[3][1], Form[3][2], Form[3][3]};
+
+    return Result;
+}
@@ -0,0 +1,458 @@
+// Sky density -------------------------------------------------------------------
+// @Note(Victor): Zoomed out, a few hundred thousand overlapping spheres are noise, and expensive noise.
+// The density map counts the galaxies of the real (A) and the random (B) catalog in equal area cells of
+// the sky and draws how much denser the real one is as a single texture on the sky sphere instead.
+//
+// The cells are the equal area grid of the random footprint: columns of equal RA and rows of equal height
+// in sin(Dec), Columns x Columns/2 of them. The row of a Dec is found without a sin: DecLookup cuts Dec in
+// steps thinner than the thinnest row (the ones at the equator) and gives the row every step starts in,
+// one compare with the next row boundary finishes it.
+//
+// Adding galaxies is incremental, AddSkyDensityPoints only bins the ones it is given. Every thread counts
+// into its own scratch histogram and remembers the rows it touched, only those rows are merged into the
+// map and cleared again. The colors depend on the totals of both catalogs, so the image is recolored
+// (a pass over the cells, not the galaxies) the next time it is drawn.
+
+enum Sky_Density_Layer
+{
+    SKY_DENSITY_DATA,   // Catalog A, the real galaxies
+    SKY_DENSITY_RANDOM, // Catalog B, what they are compared to
+
+    SKY_DENSITY_LAYER_COUNT,
+};
+
+enum Sky_Density_Measure
+{
+    SKY_DENSITY_DIFFERENCE, // (a - b) / (a + b) of the normalized counts
+    SKY_DENSITY_RATIO,      // log2(a / b), from a quarter to 4 times
+
+    SKY_DENSITY_MEASURE_COUNT,
+};
+
+global_variable const char *SkyDensityMeasureNames[SKY_DENSITY_MEASURE_COUNT] = {"difference", "ratio"};
+
+const u32 SKY_DENSITY_DEFAULT_COLUMNS = 720; // Half a degree of RA
+const u32 SKY_DENSITY_MIN_COLUMNS = 16;
+const u32 SKY_DENSITY_MAX_COLUMNS = 4096;
+const u32 SKY_DENSITY_LOOKUP_PER_ROW = 4; // Steps of DecLookup per row, thinner than the equator rows for any size
+const u64 SKY_DENSITY_BLOCK_SIZE = 65536;
+
+// The sphere the texture goes on, the texture rows are spread the same way as its rows of vertices
+const u32 SKY_DENSITY_MESH_COLUMNS = 128;
+const u32 SKY_DENSITY_MESH_ROWS = 64;
+
+struct SkyDensityMap
+{
+    u32 Columns; // Equal steps of RA
+    u32 Rows;    // Equal steps of sin(Dec), from the south pole
+
+    u32 *Counts[SKY_DENSITY_LAYER_COUNT]; // Rows * Columns
+    u64 Totals[SKY_DENSITY_LAYER_COUNT];  // Galaxies added so far
+
+    f64 *RowBoundaries; // Rows + 1, the lowest Dec of every row in arc minutes
+    u32 *DecLookup;
+    u32 LookupCount;
+
+    // @Note(Victor): Scratch of the threads, allocated the first time a thread bins something and all zero
+    // between two adds. ThreadRows is the first and the end row each thread counted in.
+    u32 ThreadCount;
+    u32 **ThreadCounts;
+    u32 *ThreadRows;
+
+    Sky_Density_Measure Measure;
+    u8 *Pixels; // RGBA, Rows * Columns
+    bool IsImageDirty;
+
+    // GPU, see UploadSkyDensityMap
+    Mesh Sphere;
+    Material SphereMaterial; // Owns the texture
+    bool IsUploaded;
+};
+
+internal u64
+GetSkyDensityCellCount(const SkyDensityMap *Map)
+{
+    return (u64)Map->Columns * Map->Rows;
+}
+
+internal void
+AllocateSkyDensityMap(SkyDensityMap *Map, u32 Columns)
+{
+    Columns = Columns < SKY_DENSITY_MIN_COLUMNS ? SKY_DENSITY_MIN_COLUMNS : (Columns > SKY_DENSITY_MAX_COLUMNS ? SKY_DENSITY_MAX_COLUMNS : Columns);
+
+    *Map = {};
+    Map->Columns = Columns;
+    Map->Rows = Columns / 2;
+    Map->LookupCount = Map->Rows * SKY_DENSITY_LOOKUP_PER_ROW;
+    Map->ThreadCount = GetThreadCount();
+
+    u64 CellCount = GetSkyDensityCellCount(Map);
+    for (u32 Layer = 0; Layer < SKY_DENSITY_LAYER_COUNT; ++Layer)
+    {
+        Map->Counts[Layer] = (u32 *)calloc(CellCount, sizeof(u32));
+    }
+    Map->RowBoundaries = (f64 *)calloc(Map->Rows + 1, sizeof(f64));
+    Map->DecLookup = (u32 *)calloc(Map->LookupCount, sizeof(u32));
+    Map->ThreadCounts = (u32 **)calloc(Map->ThreadCount, sizeof(u32 *));
+    Map->ThreadRows = (u32 *)calloc(Map->ThreadCount * 2, sizeof(u32));
+    Map->Pixels = (u8 *)calloc(CellCount, 4);
+
+    CPUMemory += CellCount * (SKY_DENSITY_LAYER_COUNT * sizeof(u32) + 4) + (Map->Rows + 1) * sizeof(f64) +
+                 Map->LookupCount * sizeof(u32) + Map->ThreadCount * (sizeof(u32 *) + 2 * sizeof(u32));
+
+    for (u32 Row = 0; Row <= Map->Rows; ++Row)
+    {
+        Map->RowBoundaries[Row] = asin(-1.0 + 2.0 * Row / Map->Rows) * ARCMIN_PER_RADIAN;
+    }
+    Map->RowBoundaries[0] = -90.0 * 60.0;
+    Map->RowBoundaries[Map->Rows] = 90.0 * 60.0;
+
+    u32 Row = 0;
+    for (u32 Step = 0; Step < Map->LookupCount; ++Step)
+    {
+        f64 Declination = -90.0 * 60.0 + Step * (180.0 * 60.0 / Map->LookupCount);
+        while (Row + 1 < Map->Rows && Declination >= Map->RowBoundaries[Row + 1])
+        {
+            Row++;
+        }
+        Map->DecLookup[Step] = Row;
+    }
+
+    for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+    {
+        Map->ThreadRows[Thread * 2 + 0] = Map->Rows;
+        Map->ThreadRows[Thread * 2 + 1] = 0;
+    }
+
+    Map->IsImageDirty = true;
+}
+
+internal u64
+GetSkyDensityMemory(const SkyDensityMap *Map)
+{
+    u64 Result = GetSkyDensityCellCount(Map) * (SKY_DENSITY_LAYER_COUNT * sizeof(u32) + 4) + (Map->Rows + 1) * sizeof(f64) +
+                 Map->LookupCount * sizeof(u32) + Map->ThreadCount * (sizeof(u32 *) + 2 * sizeof(u32));
+    for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+    {
+        Result += Map->ThreadCounts && Map->ThreadCounts[Thread] ? GetSkyDensityCellCount(Map) * sizeof(u32) : 0;
+    }
+
+    return Result;
+}
+
+internal void
+FreeSkyDensityMap(SkyDensityMap *Map)
+{
+    if (Map->Counts[0] == nullptr)
+    {
+        return;
+    }
+
+    CPUMemory -= GetSkyDensityMemory(Map);
+
+    for (u32 Layer = 0; Layer < SKY_DENSITY_LAYER_COUNT; ++Layer)
+    {
+        free(Map->Counts[Layer]);
+    }
+    for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+    {
+        free(Map->ThreadCounts[Thread]);
+    }
+    free(Map->RowBoundaries);
+    free(Map->DecLookup);
+    free(Map->ThreadCounts);
+    free(Map->ThreadRows);
+    free(Map->Pixels);
+
+    *Map = {};
+}
+
+// Only for the galaxies outside [0, 360) degrees of RA, the catalogs don't have any
+internal u32
+WrapSkyDensityColumn(f64 RightAscension, u32 Columns)
+{
+    f64 Ra = fmod(RightAscension, 360.0 * 60.0);
+    Ra = Ra < 0.0 ? Ra + 360.0 * 60.0 : Ra;
+
+    u32 Column = (u32)(Ra * (Columns / (360.0 * 60.0)));
+    return Column < Columns ? Column : Columns - 1;
+}
+
+// @Note(Victor): Bins galaxies [First, First + Count) of Source (RA and Dec in arc minutes) into Layer
+internal void
+AddSkyDensityPoints(SkyDensityMap *Map, Sky_Density_Layer Layer, const Catalog *Source, u64 First, u64 Count)
+{
+    Assert(First + Count <= Source->Count);
+    if (Count == 0)
+    {
+        return;
+    }
+
+    const u32 Columns = Map->Columns;
+    const u32 Rows = Map->Rows;
+    const f64 ColumnScale = Columns / (360.0 * 60.0);
+    const f64 LookupScale = Map->LookupCount / (180.0 * 60.0);
+    const u64 CellCount = GetSkyDensityCellCount(Map);
+
+    ParallelFor(Count, SKY_DENSITY_BLOCK_SIZE, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        u32 *Cells = Map->ThreadCounts[ThreadIndex];
+        if (Cells == nullptr)
+        {
+            Cells = (u32 *)calloc(CellCount, sizeof(u32));
+            Map->ThreadCounts[ThreadIndex] = Cells;
+            CPUMemory += CellCount * sizeof(u32);
+        }
+
+        u32 FirstRow = Map->ThreadRows[ThreadIndex * 2 + 0];
+        u32 EndRow = Map->ThreadRows[ThreadIndex * 2 + 1];
+        for (u64 i = First + Begin; i < First + End; ++i)
+        {
+            f64 Dec = GetCatalogDeclination(Source, i);
+            i64 Step = (i64)((Dec + 90.0 * 60.0) * LookupScale);
+            Step = Step < 0 ? 0 : (Step >= (i64)Map->LookupCount ? (i64)Map->LookupCount - 1 : Step);
+
+            u32 Row = Map->DecLookup[Step];
+            while (Row + 1 < Rows && Dec >= Map->RowBoundaries[Row + 1])
+            {
+                Row++;
+            }
+
+            f64 Ra = GetCatalogRightAscension(Source, i);
+            u32 Column = (u32)(i64)(Ra * ColumnScale);
+            if (Ra < 0.0 || Column >= Columns)
+            {
+                Column = WrapSkyDensityColumn(Ra, Columns);
+            }
+
+            Cells[(u64)Row * Columns + Column]++;
+            FirstRow = Row < FirstRow ? Row : FirstRow;
+            EndRow = Row + 1 > EndRow ? Row + 1 : EndRow;
+        }
+
+        Map->ThreadRows[ThreadIndex * 2 + 0] = FirstRow;
+        Map->ThreadRows[ThreadIndex * 2 + 1] = EndRow; });
+
+    // @Note(Victor): Merge the rows any thread counted in, and leave the scratch zero again
+    u32 FirstRow = Rows;
+    u32 EndRow = 0;
+    for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+    {
+        FirstRow = Map->ThreadRows[Thread * 2 + 0] < FirstRow ? Map->ThreadRows[Thread * 2 + 0] : FirstRow;
+        EndRow = Map->ThreadRows[Thread * 2 + 1] > EndRow ? Map->ThreadRows[Thread * 2 + 1] : EndRow;
+    }
+
+    u32 *Counts = Map->Counts[Layer];
+    ParallelFor(EndRow > FirstRow ? EndRow - FirstRow : 0, 8, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+        {
+            u32 *Cells = Map->ThreadCounts[Thread];
+            u32 ThreadFirstRow = Map->ThreadRows[Thread * 2 + 0];
+            u32 ThreadEndRow = Map->ThreadRows[Thread * 2 + 1];
+            for (u64 Row = FirstRow + Begin; Row < FirstRow + End; ++Row)
+            {
+                if (Row < ThreadFirstRow || Row >= ThreadEndRow)
+                {
+                    continue;
+                }
+
+                u32 *From = Cells + Row * Columns;
+                u32 *To = Counts + Row * Columns;
+                for (u32 Column = 0; Column < Columns; ++Column)
+                {
+                    To[Column] += From[Column];
+                }
+                memset(From, 0, Columns * sizeof(u32));
+            }
+        } });
+
+    for (u32 Thread = 0; Thread < Map->ThreadCount; ++Thread)
+    {
+        Map->ThreadRows[Thread * 2 + 0] = Rows;
+        Map->ThreadRows[Thread * 2 + 1] = 0;
+    }
+
+    Map->Totals[Layer] += Count;
+    Map->IsImageDirty = true;
+}
+
+// @Note(Victor): The shares of both catalogs in every cell, compared with Measure. Without a random catalog
+// the real one is compared to a uniform sky. Blue where the real galaxies are denser, red where the random
+// ones are, gray where they match, and nothing where neither has a galaxy.
+internal void
+ColorSkyDensityMap(SkyDensityMap *Map)
+{
+    const u32 Columns = Map->Columns;
+    const u64 CellCount = GetSkyDensityCellCount(Map);
+    const f64 DataScale = Map->Totals[SKY_DENSITY_DATA] > 0 ? 1.0 / (f64)Map->Totals[SKY_DENSITY_DATA] : 0.0;
+    const f64 RandomScale = Map->Totals[SKY_DENSITY_RANDOM] > 0 ? 1.0 / (f64)Map->Totals[SKY_DENSITY_RANDOM] : 0.0;
+    const bool HasRandom = Map->Totals[SKY_DENSITY_RANDOM] > 0;
+
+    const f32 Neutral[3] = {48.0f, 48.0f, 48.0f};
+    const f32 Denser[3] = {0.0f, 121.0f, 241.0f};  // BLUE
+    const f32 Sparser[3] = {230.0f, 41.0f, 55.0f}; // RED
+
+    ParallelFor(Map->Rows, 16, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Cell = Begin * Columns; Cell < End * Columns; ++Cell)
+        {
+            u32 DataCount = Map->Counts[SKY_DENSITY_DATA][Cell];
+            u32 RandomCount = Map->Counts[SKY_DENSITY_RANDOM][Cell];
+            u8 *Pixel = Map->Pixels + Cell * 4;
+
+            f64 Data = DataCount * DataScale;
+            f64 Random = HasRandom ? RandomCount * RandomScale : 1.0 / (f64)CellCount;
+            if (DataCount == 0 && RandomCount == 0)
+            {
+                Pixel[0] = Pixel[1] = Pixel[2] = Pixel[3] = 0;
+                continue;
+            }
+
+            f64 Value = 0.0; // In [-1, 1]
+            if (Map->Measure == SKY_DENSITY_DIFFERENCE)
+            {
+                Value = (Data - Random) / (Data + Random);
+            }
+            else
+            {
+                Value = Data == 0.0 ? -1.0 : (Random == 0.0 ? 1.0 : 0.5 * log2(Data / Random));
+                Value = Value < -1.0 ? -1.0 : (Value > 1.0 ? 1.0 : Value);
+            }
+
+            const f32 *Target = Value > 0.0 ? Denser : Sparser;
+            f32 t = (f32)fabs(Value);
+            Pixel[0] = (u8)(Neutral[0] + (Target[0] - Neutral[0]) * t);
+            Pixel[1] = (u8)(Neutral[1] + (Target[1] - Neutral[1]) * t);
+            Pixel[2] = (u8)(Neutral[2] + (Target[2] - Neutral[2]) * t);
+            Pixel[3] = 255;
+        } });
+
+    Map->IsImageDirty = false;
+}
+
+internal void
+SetSkyDensityMeasure(SkyDensityMap *Map, Sky_Density_Measure Measure)
+{
+    Map->Measure = Measure;
+    Map->IsImageDirty = true;
+}
+
+// A sphere of radius 1 from the inside, with its rows of vertices at equal steps of sin(Dec) like the cells
+internal Mesh
+GenMeshSkyDensitySphere(void)
+{
+    const u32 VertexColumns = SKY_DENSITY_MESH_COLUMNS + 1;
+    const u32 VertexRows = SKY_DENSITY_MESH_ROWS + 1;
+
+    Mesh Result = {};
+    Result.vertexCount = VertexColumns * VertexRows;
+    Result.triangleCount = SKY_DENSITY_MESH_COLUMNS * SKY_DENSITY_MESH_ROWS * 2;
+    Result.vertices = (f32 *)MemAlloc(Result.vertexCount * 3 * sizeof(f32));
+    Result.texcoords = (f32 *)MemAlloc(Result.vertexCount * 2 * sizeof(f32));
+    Result.normals = (f32 *)MemAlloc(Result.vertexCount * 3 * sizeof(f32));
+    Result.indices = (u16 *)MemAlloc(Result.triangleCount * 3 * sizeof(u16));
+
+    for (u32 Row = 0; Row < VertexRows; ++Row)
+    {
+        f64 SinDec = -1.0 + 2.0 * Row / SKY_DENSITY_MESH_ROWS;
+        f64 CosDec = sqrt(fmax(0.0, 1.0 - SinDec * SinDec));
+        for (u32 Column = 0; Column < VertexColumns; ++Column)
+        {
+            // Same axes as the instancing shaders
+            f64 Ra = 2.0 * PI * Column / SKY_DENSITY_MESH_COLUMNS;
+            u32 Vertex = Row * VertexColumns + Column;
+            Result.vertices[Vertex * 3 + 0] = (f32)(cos(Ra) * CosDec);
+            Result.vertices[Vertex * 3 + 1] = (f32)SinDec;
+            Result.vertices[Vertex * 3 + 2] = (f32)(sin(Ra) * CosDec);
+
+            Result.normals[Vertex * 3 + 0] = -Result.vertices[Vertex * 3 + 0];
+            Result.normals[Vertex * 3 + 1] = -Result.vertices[Vertex * 3 + 1];
+            Result.normals[Vertex * 3 + 2] = -Result.vertices[Vertex * 3 + 2];
+
+            // Texture row 0 is the south pole, like the cells
+            Result.texcoords[Vertex * 2 + 0] = (f32)Column / SKY_DENSITY_MESH_COLUMNS;
+            Result.texcoords[Vertex * 2 + 1] = (f32)Row / SKY_DENSITY_MESH_ROWS;
+        }
+    }
+
+    u16 *Index = Result.indices;
+    for (u32 Row = 0; Row < SKY_DENSITY_MESH_ROWS; ++Row)
+    {
+        for (u32 Column = 0; Column < SKY_DENSITY_MESH_COLUMNS; ++Column)
+        {
+            u16 Corner = (u16)(Row * VertexColumns + Column);
+            *Index++ = Corner;
+            *Index++ = (u16)(Corner + VertexColumns);
+            *Index++ = (u16)(Corner + 1);
+            *Index++ = (u16)(Corner + 1);
+            *Index++ = (u16)(Corner + VertexColumns);
+            *Index++ = (u16)(Corner + VertexColumns + 1);
+        }
+    }
+
+    UploadMesh(&Result, false);
+
+    return Result;
+}
+
+// Needs the window, the map only lives on the CPU before that
+internal void
+UploadSkyDensityMap(SkyDensityMap *Map)
+{
+    ColorSkyDensityMap(Map);
+
+    Image Pixels = {};
+    Pixels.data = Map->Pixels;
+    Pixels.width = (i32)Map->Columns;
+    Pixels.height = (i32)Map->Rows;
+    Pixels.mipmaps = 1;
+    Pixels.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    // @Note(Victor): Point sampled, every texel is a cell
+    Texture2D Texture = LoadTextureFromImage(Pixels);
+    SetTextureFilter(Texture, TEXTURE_FILTER_POINT);
+
+    Map->Sphere = GenMeshSkyDensitySphere();
+    Map->SphereMaterial = LoadMaterialDefault();
+    Map->SphereMaterial.maps[MATERIAL_MAP_DIFFUSE].texture = Texture;
+    Map->IsUploaded = true;
+}
+
+internal void
+UnloadSkyDensityMap(SkyDensityMap *Map)
+{
+    if (!Map->IsUploaded)
+    {
+        return;
+    }
+
+    UnloadMesh(Map->Sphere);
+    UnloadMaterial(Map->SphereMaterial);
+    Map->IsUploaded = false;
+}
+
+// @Note(Victor): One mesh and one texture, however many galaxies went in. Recolors and uploads the
+// texture first when something was added since the last time.
+internal void
+DrawSkyDensityMap(SkyDensityMap *Map, f32 Radius)
+{
+    if (!Map->IsUploaded)
+    {
+        return;
+    }
+
+    if (Map->IsImageDirty)
+    {
+        ColorSkyDensityMap(Map);
+        UpdateTexture(Map->SphereMaterial.maps[MATERIAL_MAP_DIFFUSE].texture, Map->Pixels);
+        ProfileCount(PROFILE_COUNTER_UPLOAD_BYTES, GetSkyDensityCellCount(Map) * 4);
+    }
+
+    // Seen from the inside
+    rlDisableBackfaceCulling();
+    DrawMesh(Map->Sphere, Map->SphereMaterial, MatrixScale(Radius, Radius, Radius));
+    rlEnableBackfaceCulling();
+
+    ProfileCount(PROFILE_COUNTER_DRAW_CALLS, 1);
+}
@@ -0,0 +1,967 @@
+// Spatial index -----------------------------------------------------------------
+// @Note(Victor): Built once after the instances, it reorders them so that every node of a tree covers
+// one contiguous run of instances. Culling walks the tree against the camera frustum and hands out the
+// runs of the visible nodes, neighbouring runs merged, which are drawn straight from the static buffer.
+//
+// Two ways to build the tree:
+//  - Sky tiling, for the catalogs on the sphere. The sky is cut into equal area tiles the way HEALPix
+//    does it, bands of equal height in y (= equal area on a sphere) and equal sectors in longitude.
+//    The grid of tiles is split in halves recursively, so tiles close on the sky end up close in memory.
+//  - Octree, for the redshift catalog that fills a volume.
+//
+// The same walk picks the level of detail. A node goes to one LOD bucket as a whole when its nearest and
+// furthest point from the camera fall in the same LOD, otherwise it is split further. Leaves that straddle
+// a threshold take the LOD of their nearest point. So the LOD is per tile, not per galaxy, which is what
+// lets every bucket be drawn as runs of the static buffer without sorting or uploading anything.
+//
+// The shaders can put the galaxies anywhere between the sky sphere and their redshift distance (see
+// InstanceUniforms), so every node keeps two boxes: the one of the positions the index was built from
+// and the one of the unit directions. A galaxy is drawn at SkyRadius * direction + PlacedScale * position,
+// so the same sum of the two boxes bounds the node wherever the uniforms put it.
+
+const u64 SKY_TILE_TARGET_SIZE = 512; // Galaxies per sky tile we aim for
+const u32 SKY_TILE_MAX_BANDS = 1024;
+const u64 OCTREE_LEAF_SIZE = 512;
+const u32 OCTREE_MAX_DEPTH = 16;
+const u32 SPATIAL_CULL_STACK_SIZE = 512;
+
+// @Note(Victor): 16x16, 8x8 and 4x4 spheres and a single point
+const u32 GALAXY_LOD_COUNT = 4;
+
+struct SpatialNode
+{
+    // Bounds of the positions of the galaxies in the node, Min > Max when there are none
+    Vector3 Min;
+    Vector3 Max;
+
+    // Bounds of their directions from the origin
+    Vector3 SkyMin;
+    Vector3 SkyMax;
+
+    u64 First; // Run of instances
+    u64 Count;
+
+    u32 FirstChild;
+    u32 ChildCount; // 0 for leaves
+    u32 LeafCount;  // Leaves in the subtree, for the overlay
+};
+
+struct SpatialIndex
+{
+    SpatialNode *Nodes;
+    u32 NodeCount;
+    u32 NodeCapacity;
+    u32 LeafCount;
+
+    // @Note(Victor): Instance i is galaxy Order[i] of the catalog
+    u32 *Order;
+    u64 Count;
+};
+
+// @Note(Victor): Where the galaxies are drawn, SkyRadius * direction + PlacedScale * position, and the radius of one galaxy
+struct IndexProjection
+{
+    f32 SkyRadius;
+    f32 PlacedScale;
+    f32 Padding;
+};
+
+struct FrustumPlanes
+{
+    // (a, b, c, d), a point is inside when a*x + b*y + c*z + d >= 0 for all six
+    Vector4 Planes[6];
+};
+
+// LOD i is used for galaxies closer to the camera than Distances[i], the last one for everything further
+struct LodDistances
+{
+    f32 Distances[GALAXY_LOD_COUNT - 1];
+};
+
+struct VisibleInstances
+{
+    // One list of runs per LOD, each with room for one run per leaf
+    InstanceRange *Ranges[GALAXY_LOD_COUNT];
+    u32 RangeCount[GALAXY_LOD_COUNT];
+    u64 LodCount[GALAXY_LOD_COUNT];
+    u32 RangeCapacity;
+
+    u32 VisibleLeafCount;
+    u64 VisibleCount;
+};
+
+// What the culling of one frame did, summed over the catalogs that were drawn
+struct CullingStats
+{
+    u64 SubmittedCount;
+    u64 TotalCount;
+    u32 VisibleLeafCount;
+    u32 LeafCount;
+    u32 DrawCount;
+    u64 LodCount[GALAXY_LOD_COUNT];
+    f64 Seconds;
+};
+
+enum Frustum_Test
+{
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECTS,
+    FRUSTUM_INSIDE,
+};
+
+internal SpatialNode *
+PushSpatialNode(SpatialIndex *Index)
+{
+    if (Index->NodeCount == Index->NodeCapacity)
+    {
+        u32 NewCapacity = Index->NodeCapacity ? Index->NodeCapacity * 2 : 64;
+        Index->Nodes = (SpatialNode *)realloc(Index->Nodes, NewCapacity * sizeof(SpatialNode));
+        CPUMemory += (NewCapacity - Index->NodeCapacity) * sizeof(SpatialNode);
+        Index->NodeCapacity = NewCapacity;
+    }
+
+    SpatialNode *Result = &Index->Nodes[Index->NodeCount++];
+    *Result = {};
+    Result->Min = {INFINITY, INFINITY, INFINITY};
+    Result->Max = {-INFINITY, -INFINITY, -INFINITY};
+    Result->SkyMin = Result->Min;
+    Result->SkyMax = Result->Max;
+
+    return Result;
+}
+
+internal void
+AllocateSpatialIndex(SpatialIndex *Index, u64 Count)
+{
+    Assert(Count <= 0xFFFFFFFFULL);
+
+    *Index = {};
+    Index->Count = Count;
+    Index->Order = (u32 *)calloc(Count + 1, sizeof(u32));
+    CPUMemory += Count * sizeof(u32);
+}
+
+internal u64
+GetSpatialIndexMemory(const SpatialIndex *Index)
+{
+    return Index->Count * sizeof(u32) + Index->NodeCapacity * sizeof(SpatialNode);
+}
+
+internal void
+FreeSpatialIndex(SpatialIndex *Index)
+{
+    CPUMemory -= GetSpatialIndexMemory(Index);
+
+    free(Index->Order);
+    free(Index->Nodes);
+
+    *Index = {};
+}
+
+internal void
+GrowNodeBounds(SpatialNode *Node, const SpatialNode *Child)
+{
+    Node->Min = Vector3Min(Node->Min, Child->Min);
+    Node->Max = Vector3Max(Node->Max, Child->Max);
+    Node->SkyMin = Vector3Min(Node->SkyMin, Child->SkyMin);
+    Node->SkyMax = Vector3Max(Node->SkyMax, Child->SkyMax);
+}
+
+// @Note(Victor): Children always come after their parent, so going backwards sees every child first
+internal void
+FinishSpatialNodes(SpatialIndex *Index)
+{
+    Index->LeafCount = 0;
+    for (u32 NodeIndex = Index->NodeCount; NodeIndex-- > 0;)
+    {
+        SpatialNode *Node = &Index->Nodes[NodeIndex];
+        if (Node->ChildCount == 0)
+        {
+            Node->LeafCount = 1;
+            Index->LeafCount++;
+            continue;
+        }
+
+        SpatialNode *FirstChild = &Index->Nodes[Node->FirstChild];
+        Node->First = FirstChild->First;
+        Node->Count = 0;
+        Node->LeafCount = 0;
+        for (u32 i = 0; i < Node->ChildCount; ++i)
+        {
+            SpatialNode *Child = &Index->Nodes[Node->FirstChild + i];
+            Assert(Child->First == Node->First + Node->Count);
+
+            GrowNodeBounds(Node, Child);
+            Node->Count += Child->Count;
+            Node->LeafCount += Child->LeafCount;
+        }
+    }
+}
+
+// Unit direction of the galaxy from the origin
+internal Vector3
+GetInstanceDirection(const GalaxyInstance *Instance, const SkyInstance *Sky)
+{
+    Vector3 Position = {Instance->X, Instance->Y, Instance->Z};
+
+    // @Note(Victor): The galaxies at the origin (cz <= 0) still have a place on the sky
+    f32 Length = Vector3Length(Position);
+    if (Length == 0.0f)
+    {
+        f32 CosDec = cosf(Sky->Declination);
+        return {cosf(Sky->RightAscension) * CosDec, sinf(Sky->Declination), sinf(Sky->RightAscension) * CosDec};
+    }
+
+    return Vector3Scale(Position, 1.0f / Length);
+}
+
+// Tight bounds of the positions and the directions of the instances of a leaf
+internal void
+ComputeLeafBounds(SpatialNode *Node, const GalaxyInstance *Instances, const SkyInstance *Sky)
+{
+    for (u64 i = Node->First; i < Node->First + Node->Count; ++i)
+    {
+        Vector3 Position = {Instances[i].X, Instances[i].Y, Instances[i].Z};
+        Node->Min = Vector3Min(Node->Min, Position);
+        Node->Max = Vector3Max(Node->Max, Position);
+
+        Vector3 Direction = GetInstanceDirection(&Instances[i], &Sky[i]);
+        Node->SkyMin = Vector3Min(Node->SkyMin, Direction);
+        Node->SkyMax = Vector3Max(Node->SkyMax, Direction);
+    }
+}
+
+// Puts the instances in Order, Scratch has room for Count GalaxyInstances
+internal void
+ApplySpatialOrder(const SpatialIndex *Index, GalaxyInstance *Instances, SkyInstance *Sky, GalaxyInstance *Scratch)
+{
+    memcpy(Scratch, Instances, Index->Count * sizeof(GalaxyInstance));
+
+    ParallelFor(Index->Count, Kilobytes(64), [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            Instances[i] = Scratch[Index->Order[i]];
+        } });
+
+    SkyInstance *SkyScratch = (SkyInstance *)Scratch;
+    memcpy(SkyScratch, Sky, Index->Count * sizeof(SkyInstance));
+
+    ParallelFor(Index->Count, Kilobytes(64), [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            Sky[i] = SkyScratch[Index->Order[i]];
+        } });
+}
+
+// Sky tiling ----------------------------------------------------------------------
+struct SkyTileRect
+{
+    u32 BandBegin;
+    u32 BandEnd;
+    u32 SectorBegin;
+    u32 SectorEnd;
+};
+
+internal u32
+GetSkyTile(const GalaxyInstance *Instance, u32 BandCount, u32 SectorCount)
+{
+    f64 Length = sqrt((f64)Instance->X * Instance->X + (f64)Instance->Y * Instance->Y + (f64)Instance->Z * Instance->Z);
+    f64 Height = Length > 0.0 ? Instance->Y / Length : 0.0;
+    f64 Longitude = atan2((f64)Instance->Z, (f64)Instance->X);
+
+    i64 Band = (i64)((Height + 1.0) * 0.5 * BandCount);
+    i64 Sector = (i64)((Longitude + PI) / (2.0 * PI) * SectorCount);
+    Band = Band < 0 ? 0 : (Band >= BandCount ? BandCount - 1 : Band);
+    Sector = Sector < 0 ? 0 : (Sector >= SectorCount ? SectorCount - 1 : Sector);
+
+    return (u32)(Band * SectorCount + Sector);
+}
+
+// @Note(Victor): Reorders the instances (both kinds) into sky tiles
+internal void
+BuildSkyTiling(SpatialIndex *Index, GalaxyInstance *Instances, SkyInstance *Sky, u64 Count)
+{
+    AllocateSpatialIndex(Index, Count);
+
+    u32 BandCount = (u32)sqrt((f64)Count / (2.0 * SKY_TILE_TARGET_SIZE));
+    BandCount = BandCount < 2 ? 2 : (BandCount > SKY_TILE_MAX_BANDS ? SKY_TILE_MAX_BANDS : BandCount);
+
+    u32 SectorCount = BandCount * 2;
+    u32 TileCount = BandCount * SectorCount;
+
+    // The tree over the grid of tiles, every node is split in half along its longer side
+    SkyTileRect *Rects = (SkyTileRect *)calloc(TileCount * 2, sizeof(SkyTileRect));
+    u32 *TileLeaf = (u32 *)calloc(TileCount, sizeof(u32));
+
+    PushSpatialNode(Index);
+    Rects[0] = {0, BandCount, 0, SectorCount};
+
+    for (u32 NodeIndex = 0; NodeIndex < Index->NodeCount; ++NodeIndex)
+    {
+        SkyTileRect Rect = Rects[NodeIndex];
+        u32 Bands = Rect.BandEnd - Rect.BandBegin;
+        u32 Sectors = Rect.SectorEnd - Rect.SectorBegin;
+        if (Bands * Sectors == 1)
+        {
+            continue;
+        }
+
+        SkyTileRect Low = Rect;
+        SkyTileRect High = Rect;
+        if (Sectors >= Bands)
+        {
+            Low.SectorEnd = High.SectorBegin = Rect.SectorBegin + Sectors / 2;
+        }
+        else
+        {
+            Low.BandEnd = High.BandBegin = Rect.BandBegin + Bands / 2;
+        }
+
+        u32 FirstChild = Index->NodeCount;
+        PushSpatialNode(Index);
+        PushSpatialNode(Index);
+        Rects[FirstChild] = Low;
+        Rects[FirstChild + 1] = High;
+
+        Index->Nodes[NodeIndex].FirstChild = FirstChild;
+        Index->Nodes[NodeIndex].ChildCount = 2;
+    }
+
+    // Number the leaves depth first, that is the order of the tiles in memory
+    u32 *Stack = (u32 *)calloc(Index->NodeCount, sizeof(u32));
+    u32 *LeafNode = (u32 *)calloc(TileCount, sizeof(u32));
+    u32 StackCount = 0;
+    u32 LeafCount = 0;
+
+    Stack[StackCount++] = 0;
+    while (StackCount > 0)
+    {
+        u32 NodeIndex = Stack[--StackCount];
+        SpatialNode *Node = &Index->Nodes[NodeIndex];
+        if (Node->ChildCount == 0)
+        {
+            SkyTileRect Rect = Rects[NodeIndex];
+            TileLeaf[Rect.BandBegin * SectorCount + Rect.SectorBegin] = LeafCount;
+            LeafNode[LeafCount++] = NodeIndex;
+            continue;
+        }
+
+        for (u32 i = Node->ChildCount; i-- > 0;)
+        {
+            Stack[StackCount++] = Node->FirstChild + i;
+        }
+    }
+
+    Assert(LeafCount == TileCount);
+
+    // Counting sort of the galaxies by leaf
+    u32 *GalaxyLeaf = (u32 *)calloc(Count + 1, sizeof(u32));
+    u64 *LeafFirst = (u64 *)calloc(TileCount + 1, sizeof(u64));
+
+    ParallelFor(Count, Kilobytes(16), [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 i = Begin; i < End; ++i)
+        {
+            GalaxyLeaf[i] = TileLeaf[GetSkyTile(&Instances[i], BandCount, SectorCount)];
+        } });
+
+    for (u64 i = 0; i < Count; ++i)
+    {
+        LeafFirst[GalaxyLeaf[i] + 1]++;
+    }
+
+    for (u32 Leaf = 0; Leaf < TileCount; ++Leaf)
+    {
+        LeafFirst[Leaf + 1] += LeafFirst[Leaf];
+
+        SpatialNode *Node = &Index->Nodes[LeafNode[Leaf]];
+        Node->First = LeafFirst[Leaf];
+        Node->Count = LeafFirst[Leaf + 1] - LeafFirst[Leaf];
+    }
+
+    for (u64 i = 0; i < Count; ++i)
+    {
+        Index->Order[LeafFirst[GalaxyLeaf[i]]++] = (u32)i;
+    }
+
+    GalaxyInstance *Scratch = (GalaxyInstance *)calloc(Count + 1, sizeof(GalaxyInstance));
+    ApplySpatialOrder(Index, Instances, Sky, Scratch);
+
+    ParallelFor(TileCount, 64, [&](u64 Begin, u64 End, u32 ThreadIndex)
+                {
+        for (u64 Leaf = Begin; Leaf < End; ++Leaf)
+        {
+            ComputeLeafBounds(&Index->Nodes[LeafNode[Leaf]], Instances, Sky);
+        } });
+
+    FinishSpatialNodes(Index);
+
+    free(Scratch);
+    free(GalaxyLeaf);
+    free(LeafFirst);
+    free(LeafNode);
+    free(Stack);
+    free(TileLeaf);
+    free(Rects);
+
+    printf("\tSky tiling: %u x %u tiles for %lu galaxies\n", BandCount, SectorCount, (unsigned long)Count);
+}
+
+// Octree --------------------------------------------------------------------------
+// @Note(Victor): Reorders the instances (both kinds) into the leaves of an octree
+internal void
+BuildOctree(SpatialIndex *Index, GalaxyInstance *Instances, SkyInstance *Sky, u64 Count)
+{
+    AllocateSpatialIndex(Index, Count);
+
+    for (u64 i = 0; i < Count; ++i)
+    {
+        Index->Order[i] = (u32)i;
+    }
+
+    // The cube every node splits in eight, next to the nodes while building
+    struct OctreeCell
+    {
+        Vector3 Center;
+        f32 HalfSize;
+        u32 Depth;
+    };
+
+    u32 CellCapacity = 64;
+    OctreeCell *Cells = (OctreeCell *)calloc(CellCapacity, sizeof(OctreeCell));
+    u32 *Scratch = (u32 *)calloc(Count + 1, sizeof(u32));
+    u8 *Octant = (u8 *)calloc(Count + 1, sizeof(u8));
+
+    Vector3 Min = {INFINITY, INFINITY, INFINITY};
+    Vector3 Max = {-INFINITY, -INFINITY, -INFINITY};
+    for (u64 i = 0; i < Count; ++i)
+    {
+        Min = Vector3Min(Min, {Instances[i].X, Instances[i].Y, Instances[i].Z});
+        Max = Vector3Max(Max, {Instances[i].X, Instances[i].Y, Instances[i].Z});
+    }
+
+    SpatialNode *Root = PushSpatialNode(Index);
+    Root->First = 0;
+    Root->Count = Count;
+
+    Vector3 Size = Vector3Subtract(Max, Min);
+    Cells[0].Center = Vector3Scale(Vector3Add(Min, Max), 0.5f);
+    Cells[0].HalfSize = 0.5f * fmaxf(Size.x, fmaxf(Size.y, Size.z));
+    Cells[0].Depth = 0;
+
+    for (u32 NodeIndex = 0; Count > 0 && NodeIndex < Index->NodeCount; ++NodeIndex)
+    {
+        SpatialNode Node = Index->Nodes[NodeIndex];
+        OctreeCell Cell = Cells[NodeIndex];
+        if (Node.Count <= OCTREE_LEAF_SIZE || Cell.Depth >= OCTREE_MAX_DEPTH)
+        {
+            continue;
+        }
+
+        // Which octant every galaxy of the node goes to
+        u64 OctantFirst[9] = {};
+        for (u64 i = Node.First; i < Node.First + Node.Count; ++i)
+        {
+            const GalaxyInstance *Instance = &Instances[Index->Order[i]];
+            Octant[i] = (u8)((Instance->X >= Cell.Center.x ? 1 : 0) |
+                             (Instance->Y >= Cell.Center.y ? 2 : 0) |
+                             (Instance->Z >= Cell.Center.z ? 4 : 0));
+            OctantFirst[Octant[i] + 1]++;
+        }
+
+        for (u32 i = 0; i < 8; ++i)
+        {
+            OctantFirst[i + 1] += OctantFirst[i];
+        }
+
+        u64 OctantAt[8];
+        memcpy(OctantAt, OctantFirst, sizeof(OctantAt));
+        for (u64 i = Node.First; i < Node.First + Node.Count; ++i)
+        {
+            Scratch[Node.First + OctantAt[Octant[i]]++] = Index->Order[i];
+        }
+        memcpy(Index->Order + Node.First, Scratch + Node.First, Node.Count * sizeof(u32));
+
+        // One child per octant that has galaxies
+        u32 FirstChild = Index->NodeCount;
+        u32 ChildCount = 0;
+        for (u32 i = 0; i < 8; ++i)
+        {
+            u64 OctantCount = OctantFirst[i + 1] - OctantFirst[i];
+            if (OctantCount == 0)
+            {
+                continue;
+            }
+
+            SpatialNode *Child = PushSpatialNode(Index);
+            Child->First = Node.First + OctantFirst[i];
+            Child->Count = OctantCount;
+
+            if (Index->NodeCount > CellCapacity)
+            {
+                CellCapacity *= 2;
+                Cells = (OctreeCell *)realloc(Cells, CellCapacity * sizeof(OctreeCell));
+            }
+
+            f32 Quarter = Cell.HalfSize * 0.5f;
+            OctreeCell *ChildCell = &Cells[Index->NodeCount - 1];
+            ChildCell->Center.x = Cell.Center.x + ((i & 1) ? Quarter : -Quarter);
+            ChildCell->Center.y = Cell.Center.y + ((i & 2) ? Quarter : -Quarter);
+            ChildCell->Center.z = Cell.Center.z + ((i & 4) ? Quarter : -Quarter);
+            ChildCell->HalfSize = Quarter;
+            ChildCell->Depth = Cell.Depth + 1;
+
+            ChildCount++;
+        }
+
+        Index->Nodes[NodeIndex].FirstChild = FirstChild;
+        Index->Nodes[NodeIndex].ChildCount = ChildCount;
+    }
+
+    GalaxyInstance *InstanceScratch = (GalaxyInstance *)calloc(Count + 1, sizeof(GalaxyInstance));
+    ApplySpatialOrder(Index, Instances, Sky, InstanceScratch);
+
+    for (u32 NodeIndex = 0; NodeIndex < Index->NodeCount; ++NodeIndex)
+    {
+        if (Index->Nodes[NodeIndex].ChildCount == 0)
+        {
+            ComputeLeafBounds(&Index->Nodes[NodeIndex], Instances, Sky);
+        }
+    }
+
+    FinishSpatialNodes(Index);
+
+    free(InstanceScratch);
+    free(Octant);
+    free(Scratch);
+    free(Cells);
+
+    printf("\tOctree: %u nodes, %u leaves for %lu galaxies\n", Index->NodeCount, Index->LeafCount, (unsigned long)Count);
+}
+
+// Culling -------------------------------------------------------------------------
+// @Note(Victor): Gribb & Hartmann, the planes are sums and differences of the rows of the view projection
+// matrix. raylib matrices are column major in memory, the GL row i is (m[i], m[i + 4], m[i + 8], m[i + 12]).
+internal FrustumPlanes
+GetFrustumPlanes(Matrix ViewProjection)
+{
+    const Matrix &M = ViewProjection;
+    Vector4 Rows[4] = {
+        {M.m0, M.m4, M.m8, M.m12},
+        {M.m1, M.m5, M.m9, M.m13},
+        {M.m2, M.m6, M.m10, M.m14},
+        {M.m3, M.m7, M.m11, M.m15},
+    };
+
+    FrustumPlanes Result = {};
+    for (u32 Axis = 0; Axis < 3; ++Axis)
+    {
+        Result.Planes[Axis * 2 + 0] = {Rows[3].x + Rows[Axis].x, Rows[3].y + Rows[Axis].y, Rows[3].z + Rows[Axis].z, Rows[3].w + Rows[Axis].w};
+        Result.Planes[Axis * 2 + 1] = {Rows[3].x - Rows[Axis].x, Rows[3].y - Rows[Axis].y, Rows[3].z - Rows[Axis].z, Rows[3].w - Rows[Axis].w};
+    }
+
+    for (u32 i = 0; i < 6; ++i)
+    {
+        Vector4 *Plane = &Result.Planes[i];
+        f32 Length = sqrtf(Plane->x * Plane->x + Plane->y * Plane->y + Plane->z * Plane->z);
+        if (Length > 0.0f)
+        {
+            Plane->x /= Length;
+            Plane->y /= Length;
+            Plane->z /= Length;
+            Plane->w /= Length;
+        }
+    }
+
+    return Result;
+}
+
+internal Frustum_Test
+TestFrustumBox(const FrustumPlanes *Frustum, Vector3 Min, Vector3 Max)
+{
+    Frustum_Test Result = FRUSTUM_INSIDE;
+    for (u32 i = 0; i < 6; ++i)
+    {
+        Vector4 Plane = Frustum->Planes[i];
+
+        // The corner furthest along the normal of the plane, and the one furthest against it
+        f32 Far = Plane.x * (Plane.x >= 0.0f ? Max.x : Min.x) +
+                  Plane.y * (Plane.y >= 0.0f ? Max.y : Min.y) +
+                  Plane.z * (Plane.z >= 0.0f ? Max.z : Min.z) + Plane.w;
+        if (Far < 0.0f)
+        {
+            return FRUSTUM_OUTSIDE;
+        }
+
+        f32 Near = Plane.x * (Plane.x >= 0.0f ? Min.x : Max.x) +
+                   Plane.y * (Plane.y >= 0.0f ? Min.y : Max.y) +
+                   Plane.z * (Plane.z >= 0.0f ? Min.z : Max.z) + Plane.w;
+        if (Near < 0.0f)
+        {
+            Result = FRUSTUM_INTERSECTS;
+        }
+    }
+
+    return Result;
+}
+
+// @Note(Victor): Every point is inside of it, for when the culling is off
+internal FrustumPlanes
+GetInfiniteFrustum(void)
+{
+    FrustumPlanes Result = {};
+    for (u32 i = 0; i < 6; ++i)
+    {
+        Result.Planes[i] = {0.0f, 0.0f, 0.0f, 1.0f};
+    }
+
+    return Result;
+}
+
+internal u32
+GetLod(const LodDistances *Lods, f32 Distance)
+{
+    u32 Lod = 0;
+    while (Lod < GALAXY_LOD_COUNT - 1 && Distance >= Lods->Distances[Lod])
+    {
+        Lod++;
+    }
+
+    return Lod;
+}
+
+// Distance from Point to the closest and to the furthest point of the box
+internal void
+GetBoxDistances(Vector3 Point, Vector3 Min, Vector3 Max, f32 *Nearest, f32 *Furthest)
+{
+    f32 NearX = fmaxf(fmaxf(Min.x - Point.x, Point.x - Max.x), 0.0f);
+    f32 NearY = fmaxf(fmaxf(Min.y - Point.y, Point.y - Max.y), 0.0f);
+    f32 NearZ = fmaxf(fmaxf(Min.z - Point.z, Point.z - Max.z), 0.0f);
+    *Nearest = sqrtf(NearX * NearX + NearY * NearY + NearZ * NearZ);
+
+    f32 FarX = fmaxf(fabsf(Point.x - Min.x), fabsf(Point.x - Max.x));
+    f32 FarY = fmaxf(fabsf(Point.y - Min.y), fabsf(Point.y - Max.y));
+    f32 FarZ = fmaxf(fabsf(Point.z - Min.z), fabsf(Point.z - Max.z));
+    *Furthest = sqrtf(FarX * FarX + FarY * FarY + FarZ * FarZ);
+}
+
+internal void
+AllocateVisibleInstances(VisibleInstances *Visible, const SpatialIndex *Index)
+{
+    *Visible = {};
+    Visible->RangeCapacity = Index->LeafCount > 0 ? Index->LeafCount : 1;
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+    {
+        Visible->Ranges[Lod] = (InstanceRange *)calloc(Visible->RangeCapacity, sizeof(InstanceRange));
+    }
+    CPUMemory += GALAXY_LOD_COUNT * Visible->RangeCapacity * sizeof(InstanceRange);
+}
+
+internal u64
+GetVisibleInstancesMemory(const VisibleInstances *Visible)
+{
+    return GALAXY_LOD_COUNT * Visible->RangeCapacity * sizeof(InstanceRange);
+}
+
+internal void
+FreeVisibleInstances(VisibleInstances *Visible)
+{
+    CPUMemory -= GetVisibleInstancesMemory(Visible);
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+    {
+        free(Visible->Ranges[Lod]);
+    }
+    *Visible = {};
+}
+
+internal void
+AddVisibleRange(VisibleInstances *Visible, const SpatialNode *Node, u32 Lod)
+{
+    Visible->VisibleLeafCount += Node->LeafCount;
+    Visible->VisibleCount += Node->Count;
+    Visible->LodCount[Lod] += Node->Count;
+
+    // Nodes come in instance order, so a run that continues the last one of its LOD just extends it
+    InstanceRange *Ranges = Visible->Ranges[Lod];
+    u32 *RangeCount = &Visible->RangeCount[Lod];
+    if (*RangeCount > 0)
+    {
+        InstanceRange *Last = &Ranges[*RangeCount - 1];
+        if (Last->First + Last->Count == Node->First)
+        {
+            Last->Count += Node->Count;
+            return;
+        }
+    }
+
+    Assert(*RangeCount < Visible->RangeCapacity);
+    Ranges[(*RangeCount)++] = {Node->First, Node->Count};
+}
+
+// Where the galaxies of Node are drawn with Projection
+internal void
+GetProjectedNodeBounds(const SpatialNode *Node, const IndexProjection *Projection, Vector3 *Min, Vector3 *Max)
+{
+    Vector3 Padding = {Projection->Padding, Projection->Padding, Projection->Padding};
+
+    Vector3 SkyMin = Vector3Scale(Node->SkyMin, Projection->SkyRadius);
+    Vector3 SkyMax = Vector3Scale(Node->SkyMax, Projection->SkyRadius);
+    if (Projection->PlacedScale == 0.0f)
+    {
+        *Min = Vector3Subtract(SkyMin, Padding);
+        *Max = Vector3Add(SkyMax, Padding);
+        return;
+    }
+
+    *Min = Vector3Subtract(Vector3Add(SkyMin, Vector3Scale(Node->Min, Projection->PlacedScale)), Padding);
+    *Max = Vector3Add(Vector3Add(SkyMax, Vector3Scale(Node->Max, Projection->PlacedScale)), Padding);
+}
+
+// Collects the runs of instances of the nodes that are (partly) in the frustum, bucketed by their
+// distance to the camera. Lods is in world units.
+internal void
+CullSpatialIndex(const SpatialIndex *Index, const IndexProjection *Projection, const FrustumPlanes *Frustum,
+                 Vector3 CameraPosition, const LodDistances *Lods, VisibleInstances *Visible)
+{
+    for (u32 Lod = 0; Lod < GALAXY_LOD_COUNT; ++Lod)
+    {
+        Visible->RangeCount[Lod] = 0;
+        Visible->LodCount[Lod] = 0;
+    }
+    Visible->VisibleLeafCount = 0;
+    Visible->VisibleCount = 0;
+
+    if (Index->NodeCount == 0)
+    {
+        return;
+    }
+
+    u32 Stack[SPATIAL_CULL_STACK_SIZE];
+    u32 StackCount = 0;
+    Stack[StackCount++] = 0;
+
+    while (StackCount > 0)
+    {
+        const SpatialNode *Node = &Index->Nodes[Stack[--StackCount]];
+        if (Node->Count == 0)
+        {
+            continue;
+        }
+
+        Vector3 Min, Max;
+        GetProjectedNodeBounds(Node, Projection, &Min, &Max);
+
+        Frustum_Test Test = TestFrustumBox(Frustum, Min, Max);
+        if (Test == FRUSTUM_OUTSIDE)
+        {
+            continue;
+        }
+
+        f32 Nearest, Furthest;
+        GetBoxDistances(CameraPosition, Min, Max, &Nearest, &Furthest);
+        u32 Lod = GetLod(Lods, Nearest);
+
+        if ((Test == FRUSTUM_INSIDE && Lod == GetLod(Lods, Furthest)) || Node->ChildCount == 0)
+        {
+            AddVisibleRange(Visible, Node, Lod);
+            continue;
+        }
+
+        // Backwards, so the first child is popped first and the runs come out in order
+        Assert(StackCount + Node->ChildCount <= SPATIAL_CULL_STACK_SIZE);
+        for (u32 i = Node->ChildCount; i-- > 0;)
+        {
+            Stack[StackCount++] = Node->FirstChild + i;
+        }
+    }
+}
+
+// Picking -------------------------------------------------------------------------
+// @Note(Victor): The galaxy under the mouse. The ray picks a galaxy when it passes within the galaxy's
+// radius, or within Tolerance (the tangent of a few pixels) times its distance, so the far away ones that
+// are a single point on the screen can be picked too. Of those the one closest to the camera wins, it is
+// the one drawn on top.
+//
+// The walk goes over the same nodes as the culling, the nearest box first, and drops every box the ray
+// only enters behind the best galaxy so far. A ray crosses a thin line of tiles, so out of millions of
+// galaxies only the few thousand in the tiles along it are ever tested.
+
+struct PickResult
+{
+    bool Hit;
+    u64 Instance;     // In the order of the index
+    u64 CatalogIndex; // Galaxy of the catalog, Order[Instance]
+    f32 Distance;     // From the camera, along the ray
+    Vector3 Position; // Where it is drawn
+    u32 NodeCount;    // Visited, for the overlay
+    u64 TestedCount;
+};
+
+struct PickStackEntry
+{
+    u32 Node;
+    f32 Enter;
+};
+
+// Distance along the ray to where it enters the box, INFINITY when it misses
+internal f32
+GetRayBoxEnter(Vector3 Origin, Vector3 Direction, Vector3 Min, Vector3 Max)
+{
+    f32 Origins[3] = {Origin.x, Origin.y, Origin.z};
+    f32 Directions[3] = {Direction.x, Direction.y, Direction.z};
+    f32 Mins[3] = {Min.x, Min.y, Min.z};
+    f32 Maxs[3] = {Max.x, Max.y, Max.z};
+
+    f32 Enter = 0.0f;
+    f32 Exit = INFINITY;
+    for (u32 Axis = 0; Axis < 3; ++Axis)
+    {
+        if (Directions[Axis] == 0.0f)
+        {
+            if (Origins[Axis] < Mins[Axis] || Origins[Axis] > Maxs[Axis])
+            {
+                return INFINITY;
+            }
+            continue;
+        }
+
+        f32 Inverse = 1.0f / Directions[Axis];
+        f32 Near = (Mins[Axis] - Origins[Axis]) * Inverse;
+        f32 Far = (Maxs[Axis] - Origins[Axis]) * Inverse;
+        if (Near > Far)
+        {
+            f32 Swap = Near;
+            Near = Far;
+            Far = Swap;
+        }
+
+        Enter = fmaxf(Enter, Near);
+        Exit = fminf(Exit, Far);
+        if (Enter > Exit)
+        {
+            return INFINITY;
+        }
+    }
+
+    return Enter;
+}
+
+// Where the node's box, widened by the pick tolerance at its far side, is entered by the ray
+internal f32
+GetPickNodeEnter(const SpatialNode *Node, const IndexProjection *Projection, Ray PickRay, f32 Tolerance)
+{
+    if (Node->Count == 0)
+    {
+        return INFINITY;
+    }
+
+    Vector3 Min, Max;
+    GetProjectedNodeBounds(Node, Projection, &Min, &Max);
+
+    f32 Nearest, Furthest;
+    GetBoxDistances(PickRay.position, Min, Max, &Nearest, &Furthest);
+    Vector3 Reach = {Furthest * Tolerance, Furthest * Tolerance, Furthest * Tolerance};
+
+    return GetRayBoxEnter(PickRay.position, PickRay.direction, Vector3Subtract(Min, Reach), Vector3Add(Max, Reach));
+}
+
+// @Note(Victor): Instances and Sky in the order of the index. Projection->Padding is the radius of a galaxy.
+internal PickResult
+PickSpatialIndex(const SpatialIndex *Index, const GalaxyInstance *Instances, const SkyInstance *Sky,
+                 const IndexProjection *Projection, Ray PickRay, f32 Tolerance)
+{
+    PickResult Result = {};
+    Result.Distance = INFINITY;
+
+    if (Index->NodeCount == 0)
+    {
+        return Result;
+    }
+
+    PickRay.direction = Vector3Normalize(PickRay.direction);
+    Vector3 Origin = PickRay.position;
+    Vector3 Direction = PickRay.direction;
+
+    PickStackEntry Stack[SPATIAL_CULL_STACK_SIZE];
+    u32 StackCount = 0;
+    Stack[StackCount++] = {0, GetPickNodeEnter(&Index->Nodes[0], Projection, PickRay, Tolerance)};
+
+    while (StackCount > 0)
+    {
+        PickStackEntry Entry = Stack[--StackCount];
+        if (Entry.Enter >= Result.Distance)
+        {
+            continue;
+        }
+
+        const SpatialNode *Node = &Index->Nodes[Entry.Node];
+        Result.NodeCount++;
+
+        if (Node->ChildCount == 0)
+        {
+            for (u64 i = Node->First; i < Node->First + Node->Count; ++i)
+            {
+                Vector3 Position = {Instances[i].X, Instances[i].Y, Instances[i].Z};
+                Vector3 World = Vector3Add(Vector3Scale(GetInstanceDirection(&Instances[i], &Sky[i]), Projection->SkyRadius),
+                                           Vector3Scale(Position, Projection->PlacedScale));
+
+                Vector3 ToGalaxy = Vector3Subtract(World, Origin);
+                f32 Along = Vector3DotProduct(ToGalaxy, Direction);
+                if (Along <= 0.0f || Along >= Result.Distance)
+                {
+                    continue;
+                }
+
+                // @Note(Victor): From the ray straight to the galaxy, |ToGalaxy|^2 - Along^2 would cancel away
+                // most of its digits this far from the camera
+                Vector3 Across = Vector3Subtract(ToGalaxy, Vector3Scale(Direction, Along));
+                f32 Reach = fmaxf(Projection->Padding, Along * Tolerance);
+                if (Vector3DotProduct(Across, Across) <= Reach * Reach)
+                {
+                    Result.Hit = true;
+                    Result.Instance = i;
+                    Result.Distance = Along;
+                    Result.Position = World;
+                }
+            }
+            Result.TestedCount += Node->Count;
+            continue;
+        }
+
+        // The nearest child goes on the stack last, so it is walked first
+        PickStackEntry Children[8];
+        u32 ChildCount = 0;
+        for (u32 i = 0; i < Node->ChildCount; ++i)
+        {
+            u32 ChildIndex = Node->FirstChild + i;
+            f32 Enter = GetPickNodeEnter(&Index->Nodes[ChildIndex], Projection, PickRay, Tolerance);
+            if (Enter >= Result.Distance)
+            {
+                continue;
+            }
+
+            u32 At = ChildCount++;
+            while (At > 0 && Children[At - 1].Enter < Enter)
+            {
+                Children[At] = Children[At - 1];
+                At--;
+            }
+            Children[At] = {ChildIndex, Enter};
+        }
+
+        Assert(StackCount + ChildCount <= SPATIAL_CULL_STACK_SIZE);
+        for (u32 i = 0; i < ChildCount; ++i)
+        {
+            Stack[StackCount++] = Children[i];
+        }
+    }
+
+    if (Result.Hit)
+    {
+        Result.CatalogIndex = Index->Order[Result.Instance];
+    }
+
+    return Result;
+}